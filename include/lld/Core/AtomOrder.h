@@ -0,0 +1,74 @@
+//===- Core/AtomOrder.h - Profile-guided atom ordering --------------------===//
+//
+//                             The LLVM Linker
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLD_CORE_ATOM_ORDER_H
+#define LLD_CORE_ATOM_ORDER_H
+
+#include "lld/Core/LLVM.h"
+#include "llvm/ADT/ArrayRef.h"
+#include "llvm/ADT/StringMap.h"
+#include <system_error>
+#include <vector>
+
+namespace lld {
+
+class DefinedAtom;
+
+/// \brief A weighted call graph read from a profile.
+///
+/// The profile has one "caller callee weight" entry per line, where caller
+/// and callee are symbol names and weight is the number of calls (or any
+/// other measure of how hot the edge is). Targets use the graph to cluster
+/// functions that call each other, so that the hot code of a program is
+/// packed into as few pages and cache lines as possible.
+class CallGraphProfile {
+public:
+  /// Adds the entries of a profile. Returns an error naming the first line
+  /// that is not of the form "caller callee weight".
+  std::error_code parse(StringRef content);
+
+  bool empty() const { return _edges.empty(); }
+
+  /// Orders the code atoms of \p atoms that are called or call others in the
+  /// profile, using the C3 (call-chain clustering) heuristic: each function
+  /// is appended to the cluster of its hottest caller unless the result gets
+  /// too big or too cold, and clusters are laid out by decreasing density
+  /// (weight per byte). If several atoms have the same name, only the first
+  /// one in \p atoms is ordered. Atoms absent from the profile are not in the
+  /// result.
+  std::vector<const DefinedAtom *>
+  sortAtoms(ArrayRef<const DefinedAtom *> atoms) const;
+
+private:
+  struct Edge {
+    unsigned caller;
+    unsigned callee;
+    uint64_t weight;
+  };
+
+  unsigned getId(StringRef name);
+
+  llvm::StringMap<unsigned> _ids;
+  std::vector<StringRef> _names;
+  std::vector<Edge> _edges;
+};
+
+/// \brief Stable-sorts \p atoms by \p priority, lowest first.
+///
+/// Atoms linked by kindLayoutAfter references come from the same input
+/// section and may refer to each other without relocations, so such a chain
+/// is moved as a whole, to the position of its member with the lowest
+/// priority, and keeps its internal order. Chains whose members all have no
+/// priority (UINT_MAX) keep their relative order after the others.
+void orderLayoutChains(llvm::MutableArrayRef<const DefinedAtom *> atoms,
+                       ArrayRef<unsigned> priority);
+
+} // end namespace lld
+
+#endif
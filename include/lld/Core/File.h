@@ -145,6 +145,21 @@ public:
   // Use this hook instead.
   virtual void beforeLink() {}
 
+  // Section groups, such as ELF COMDAT groups, may be read in two levels.
+  // doParse() creates the group atoms and the symbols that the members of
+  // the groups define, and the resolver calls this function when it selects
+  // a group, just before it adds the group's kindGroupChild references. A
+  // file can thus create the member atoms of the selected groups only, as
+  // most groups are duplicates of groups in other files.
+  virtual void loadGroupMembers(const DefinedAtom &group) {}
+
+  // Called once for each linked file after all symbols are resolved, in
+  // parallel with the other files. Files that loaded group members lazily
+  // finish them here, e.g. by reading their relocations. \p resolve returns
+  // the atom that the symbol table has for a given name, or null.
+  virtual void
+  finishGroupMembers(const std::function<const Atom *(StringRef)> &resolve) {}
+
   // Usually each file owns a std::unique_ptr<MemoryBuffer>.
   // However, there's one special case. If a file is an archive file,
   // the archive file and its children all shares the same memory buffer.
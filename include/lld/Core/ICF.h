@@ -0,0 +1,51 @@
+//===- Core/ICF.h - Identical code folding --------------------------------===//
+//
+//                             The LLVM Linker
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLD_CORE_ICF_H
+#define LLD_CORE_ICF_H
+
+#include "lld/Core/Pass.h"
+#include <memory>
+
+namespace lld {
+
+class LinkingContext;
+class SimpleFile;
+
+/// \brief Folds identical functions of the merged file into one.
+///
+/// Two code atoms are identical if they have the same attributes and
+/// content, and if their references have the same kinds, offsets and
+/// addends and point either to the same atoms or to identical atoms. The
+/// second condition is recursive, so the pass starts with the atoms
+/// grouped by their own bytes and references, and splits the groups until
+/// the references of all members of each group agree. References to the
+/// folded atoms are then redirected to the first member of their group, and
+/// the folded atoms are replaced with aliases of it.
+///
+/// Atoms that are chained by kindLayoutAfter references are left alone
+/// since their neighbours may rely on their position. So are atoms that
+/// must stay visible by name: the entry point, the dead strip roots, and the
+/// global atoms of outputs that export them (shared libraries). With
+/// ICFMode::Safe, only atoms whose address is not taken, i.e. that are
+/// referenced by calls and branches alone (see
+/// LinkingContext::isCallReference), are folded.
+class ICFPass : public Pass {
+public:
+  explicit ICFPass(const LinkingContext &ctx) : _ctx(ctx) {}
+
+  void perform(std::unique_ptr<SimpleFile> &mergedFile) override;
+
+private:
+  const LinkingContext &_ctx;
+};
+
+} // end namespace lld
+
+#endif
@@ -10,6 +10,7 @@
 #ifndef LLD_CORE_LINKING_CONTEXT_H
 #define LLD_CORE_LINKING_CONTEXT_H
 
+#include "lld/Core/AtomOrder.h"
 #include "lld/Core/Error.h"
 #include "lld/Core/LLVM.h"
 #include "lld/Core/Node.h"
@@ -43,6 +44,13 @@ public:
     YAML,    // The output type is set to YAML
   };
 
+  /// \brief Which functions identical code folding may merge.
+  enum class ICFMode : uint8_t {
+    None, // Do not fold
+    Safe, // Fold functions whose address is known not to be taken
+    All,  // Fold all identical functions
+  };
+
   virtual ~LinkingContext();
 
   /// \name Methods needed by core linking
@@ -57,6 +65,22 @@ public:
   /// if globalsAreDeadStripRoots() is true.
   bool deadStrip() const { return _deadStrip; }
 
+  /// Whether identical functions are folded into one after core linking.
+  ICFMode icfMode() const { return _icfMode; }
+
+  /// Whether global atoms are visible outside of the output, so that passes
+  /// must keep them under their own names.
+  virtual bool globalsAreExported() const { return _globalsAreDeadStripRoots; }
+
+  /// Whether \p ref, a reference of \p atom, is a call or a branch to its
+  /// target, as opposed to a use of the target's address. Identical code
+  /// folding in ICFMode::Safe only folds functions that are referenced by
+  /// calls and branches alone. The default is conservative.
+  virtual bool isCallReference(const DefinedAtom &atom,
+                               const Reference &ref) const {
+    return false;
+  }
+
   /// Only used if deadStrip() returns true.  Means all global scope Atoms
   /// should be marked live (along with all Atoms they reference).  Usually
   /// this method returns false for main executables, but true for dynamic
@@ -176,6 +200,7 @@ public:
   }
 
   void setDeadStripping(bool enable) { _deadStrip = enable; }
+  void setICFMode(ICFMode mode) { _icfMode = mode; }
   void setAllowDuplicates(bool enable) { _allowDuplicates = enable; }
   void setGlobalsAreDeadStripRoots(bool v) { _globalsAreDeadStripRoots = v; }
   void setSearchArchivesToOverrideTentativeDefinitions(bool search) {
@@ -309,6 +334,11 @@ public:
 
   TaskGroup &getTaskGroup() { return _taskGroup; }
 
+  /// Call graph profile given with --call-graph-ordering-file (or the
+  /// flavor's equivalent). Targets use it to cluster hot functions.
+  const CallGraphProfile &callGraphProfile() const { return _callGraphProfile; }
+  CallGraphProfile &callGraphProfile() { return _callGraphProfile; }
+
   /// @}
 protected:
   LinkingContext(); // Must be subclassed
@@ -341,6 +371,7 @@ protected:
   bool _logInputFiles;
   bool _allowShlibUndefines;
   OutputFileType _outputFileType;
+  ICFMode _icfMode;
   std::vector<StringRef> _deadStripRoots;
   std::map<std::string, std::string> _aliasSymbols;
   std::vector<const char *> _llvmOptions;
@@ -349,6 +380,7 @@ protected:
   mutable llvm::BumpPtrAllocator _allocator;
   mutable uint64_t _nextOrdinal;
   Registry _registry;
+  CallGraphProfile _callGraphProfile;
 
 private:
   /// Validate the subclass bits. Only called by validate.
@@ -292,6 +292,11 @@ template <class Iterator, class Func>
 void parallel_for_each(Iterator begin, Iterator end, Func func) {
   concurrency::parallel_for_each(begin, end, func);
 }
+
+template <class Func>
+void parallel_for(size_t begin, size_t end, Func func) {
+  concurrency::parallel_for(begin, end, func);
+}
 #else
 template <class Iterator, class Func>
 void parallel_for_each(Iterator begin, Iterator end, Func func) {
@@ -303,6 +308,22 @@ void parallel_for_each(Iterator begin, Iterator end, Func func) {
   }
   std::for_each(begin, end, func);
 }
+
+/// \brief Calls \p func with every index in [begin, end).
+template <class Func>
+void parallel_for(size_t begin, size_t end, Func func) {
+  TaskGroup tg;
+  size_t taskSize = 1024;
+  while (begin + taskSize <= end) {
+    tg.spawn([=, &func] {
+      for (size_t i = begin, e = begin + taskSize; i != e; ++i)
+        func(i);
+    });
+    begin += taskSize;
+  }
+  for (size_t i = begin; i < end; ++i)
+    func(i);
+}
 #endif
 } // end namespace lld
 
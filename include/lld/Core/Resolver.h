@@ -68,6 +68,7 @@ private:
   /// \brief The main function that iterates over the files to resolve
   void updatePreloadArchiveMap();
   bool resolveUndefines();
+  void finishGroupMembers();
   void updateReferences();
   void deadStripOptimize();
   bool checkUndefines();
@@ -94,6 +95,9 @@ private:
   std::unique_ptr<MergedFile>   _result;
   std::unordered_multimap<const Atom *, const Atom *> _reverseRef;
 
+  // Files whose atoms were added, in the order they were added.
+  std::vector<File *> _linkedFiles;
+
   // --start-group and --end-group
   std::vector<File *> _files;
   std::map<File *, bool> _newUndefinesAdded;
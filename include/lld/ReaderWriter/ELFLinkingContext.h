@@ -18,6 +18,7 @@
 #include "lld/Core/Reader.h"
 #include "lld/Core/Writer.h"
 #include "lld/ReaderWriter/LinkerScript.h"
+#include "llvm/ADT/StringMap.h"
 #include "llvm/ADT/StringSet.h"
 #include "llvm/ADT/Triple.h"
 #include "llvm/Object/ELF.h"
@@ -26,10 +27,6 @@
 #include <memory>
 #include <set>
 
-namespace llvm {
-class FileOutputBuffer;
-}
-
 namespace lld {
 struct AtomLayout;
 class File;
@@ -55,9 +52,11 @@ class TargetRelocationHandler {
 public:
   virtual ~TargetRelocationHandler() {}
 
-  virtual std::error_code applyRelocation(ELFWriter &, llvm::FileOutputBuffer &,
-                                          const lld::AtomLayout &,
-                                          const Reference &) const = 0;
+  /// Applies \p ref to the contents of the atom, which start at
+  /// buf + atom._fileOffset. buf is usually the output file buffer.
+  virtual std::error_code applyRelocation(ELFWriter &, uint8_t *buf,
+                                          const lld::AtomLayout &atom,
+                                          const Reference &ref) const = 0;
 };
 
 } // namespace elf
@@ -184,9 +183,21 @@ public:
   /// \brief Returns true if we are creating a shared library.
   bool isDynamicLibrary() const { return _outputELFType == llvm::ELF::ET_DYN; }
 
+  bool globalsAreExported() const override {
+    return _outputELFType != llvm::ELF::ET_EXEC || _exportDynamic;
+  }
+
   /// \brief Returns true if a given relocation is a relative relocation.
   virtual bool isRelativeReloc(const Reference &r) const;
 
+  /// \brief Returns true if a given relocation only adds the load address to
+  /// a word-sized field, so that it can be emitted into the packed .relr.dyn
+  /// table. Relocations that need a resolver, like IRELATIVE, must return
+  /// false.
+  virtual bool isPackableRelativeReloc(const Reference &) const {
+    return false;
+  }
+
   TargetHandler &getTargetHandler() const {
     assert(_targetHandler && "Got null TargetHandler!");
     return *_targetHandler;
@@ -341,6 +352,29 @@ public:
 
   const llvm::StringSet<> &wrapCalls() const { return _wrapCalls; }
 
+  /// \brief --symbol-ordering-file: atoms defining the listed symbols are
+  /// laid out first, in list order. A symbol listed twice keeps its first
+  /// position.
+  void addOrderedSymbol(StringRef sym) {
+    if (_symbolOrder.count(sym))
+      return;
+    unsigned order = _symbolOrder.size();
+    _symbolOrder[sym] = order;
+  }
+
+  bool hasSymbolOrder() const { return !_symbolOrder.empty(); }
+  unsigned numOrderedSymbols() const { return _symbolOrder.size(); }
+
+  /// \brief Returns true and sets \p order to the position of \p sym in the
+  /// symbol ordering list if it is listed.
+  bool findSymbolOrder(StringRef sym, unsigned &order) const {
+    auto it = _symbolOrder.find(sym);
+    if (it == _symbolOrder.end())
+      return false;
+    order = it->second;
+    return true;
+  }
+
   void setUndefinesResolver(std::unique_ptr<File> resolver);
 
   script::Sema &linkerScriptSema() { return _linkerScriptSema; }
@@ -350,6 +384,17 @@ public:
   bool armTarget1Rel() const { return _armTarget1Rel; }
   void setArmTarget1Rel(bool value) { _armTarget1Rel = value; }
 
+  /// \brief Emit relative relocations into a packed .relr.dyn table
+  /// (-z pack-relative-relocs). In a shared object, absolute pointers to
+  /// atoms defined in the link become relative relocations for the table.
+  bool packRelativeRelocs() const { return _packRelativeRelocs; }
+  void setPackRelativeRelocs(bool value) { _packRelativeRelocs = value; }
+
+  /// \brief Compress the non-allocated .debug_* sections with zlib
+  /// (--compress-debug-sections=zlib).
+  bool compressDebugSections() const { return _compressDebugSections; }
+  void setCompressDebugSections(bool value) { _compressDebugSections = value; }
+
   // Set R_MIPS_EH relocation behaviour.
   bool mipsPcRelEhRel() const { return _mipsPcRelEhRel; }
   void setMipsPcRelEhRel(bool value) { _mipsPcRelEhRel = value; }
@@ -392,6 +437,8 @@ protected:
   bool _collectStats = false;
   bool _armTarget1Rel = false;
   bool _mipsPcRelEhRel = false;
+  bool _packRelativeRelocs = false;
+  bool _compressDebugSections = false;
   uint64_t _maxPageSize = 0x1000;
   uint32_t _dtFlags = 0;
 
@@ -406,6 +453,7 @@ protected:
   StringRefVector _rpathList;
   StringRefVector _rpathLinkList;
   llvm::StringSet<> _wrapCalls;
+  llvm::StringMap<unsigned> _symbolOrder;
   std::map<std::string, uint64_t> _absoluteSymbols;
   llvm::StringSet<> _dynamicallyExportedSymbols;
   std::unique_ptr<File> _resolver;
@@ -407,6 +407,7 @@ public:
   }
 
   ErrorOr<int64_t> evalExpr(SymbolTableTy &symbolTable) const override;
+  uint64_t value() const { return _num; }
 
 private:
   uint64_t _num;
@@ -423,6 +424,7 @@ public:
   }
 
   ErrorOr<int64_t> evalExpr(SymbolTableTy &symbolTable) const override;
+  StringRef name() const { return _name; }
 
 private:
   StringRef _name;
@@ -469,6 +471,8 @@ public:
   }
 
   ErrorOr<int64_t> evalExpr(SymbolTableTy &symbolTable) const override;
+  Operation op() const { return _op; }
+  const Expression *child() const { return _child; }
 
 private:
   Operation _op;
@@ -504,6 +508,9 @@ public:
   }
 
   ErrorOr<int64_t> evalExpr(SymbolTableTy &symbolTable) const override;
+  Operation op() const { return _op; }
+  const Expression *lhs() const { return _lhs; }
+  const Expression *rhs() const { return _rhs; }
 
 private:
   Operation _op;
@@ -539,6 +546,9 @@ public:
   }
 
   ErrorOr<int64_t> evalExpr(SymbolTableTy &symbolTable) const override;
+  const Expression *conditional() const { return _conditional; }
+  const Expression *trueExpr() const { return _trueExpr; }
+  const Expression *falseExpr() const { return _falseExpr; }
 
 private:
   const Expression *_conditional;
@@ -546,6 +556,44 @@ private:
   const Expression *_falseExpr;
 };
 
+/// An expression compiled by Sema into a flat program for a small stack
+/// machine. Constant subexpressions are folded at compile time and symbols are
+/// resolved to slot numbers, so evaluating the program neither recurses over
+/// the AST nor looks symbol names up.
+class CompiledExpr {
+public:
+  struct Insn {
+    enum Kind : uint8_t {
+      Push,       // Push _operand.
+      Load,       // Push the value of slot _operand.
+      UnaryOp,    // Apply Unary::Operation _op to the top of the stack.
+      BinaryOp,   // Apply BinOp::Operation _op to the two topmost values.
+      JumpIfZero, // Pop a value and continue at _operand if it is zero.
+      Jump,       // Continue at _operand.
+      Call        // Fail, function calls are not supported.
+    };
+    Kind _kind;
+    uint8_t _op;
+    int64_t _operand;
+  };
+
+  /// The value of a symbol, and whether it has been assigned yet.
+  struct Slot {
+    Slot() : _value(0), _defined(false) {}
+    int64_t _value;
+    bool _defined;
+  };
+
+  /// Evaluates the program over \p slots. The errors are the ones
+  /// Expression::evalExpr() would return for the original AST.
+  ErrorOr<int64_t> eval(ArrayRef<Slot> slots) const;
+
+  /// Appends the slots the program loads from to \p slots.
+  void getLoadedSlots(SmallVectorImpl<unsigned> &slots) const;
+
+  std::vector<Insn> _code;
+};
+
 /// Symbol assignments of the form "symbolname = <expression>" may occur either
 /// as sections-commands or as output-section-commands.
 /// Example:
@@ -1192,6 +1240,53 @@ private:
   Token _bufferedToken;
 };
 
+/// A file or section name pattern from a linker script, compiled once so that
+/// matching a name is a single forward pass without backtracking.
+///
+/// '*' matches one or more characters, '?' any character, "[...]" any of the
+/// listed characters (ranges like "a-z" are allowed), and '\' escapes the
+/// next character.
+class WildcardPattern {
+public:
+  WildcardPattern() {}
+  explicit WildcardPattern(StringRef pattern);
+
+  StringRef pattern() const { return _pattern; }
+
+  /// The pattern has no special characters.
+  bool isExact() const { return _kind == Kind::Exact; }
+
+  /// The pattern is a plain literal followed by a single '*'.
+  bool isPrefix() const { return _kind == Kind::Prefix; }
+
+  /// For exact and prefix patterns, the literal part of the pattern.
+  StringRef literal() const { return _literal; }
+
+  bool match(StringRef name) const;
+
+private:
+  enum class Kind { Exact, Prefix, Any, General };
+
+  struct Element {
+    enum Type : uint8_t { Char, AnyChar, CharSet } _type;
+    char _char;
+    StringRef _set;
+  };
+
+  bool matchSegment(size_t seg, StringRef name, size_t pos) const;
+  size_t segmentSize(size_t seg) const {
+    return _segments[seg + 1] - _segments[seg];
+  }
+
+  StringRef _pattern;
+  Kind _kind = Kind::Exact;
+  StringRef _literal;
+  // General patterns are split at each '*' into fixed-length segments of
+  // elements. Segment i is _elements[_segments[i], _segments[i + 1]).
+  std::vector<Element> _elements;
+  std::vector<size_t> _segments;
+};
+
 /// script::Sema traverses all parsed linker script structures and populate
 /// internal data structures to be able to answer the following questions:
 ///
@@ -1248,6 +1343,13 @@ public:
   /// rhs.
   bool less(const SectionKey &lhs, const SectionKey &rhs) const;
 
+  /// Returns the permutation that sorts \p keys the way a stable sort with
+  /// less() would. The layout order of each key is looked up once, in
+  /// parallel, and the result is a parallel sort on integer keys, so less()
+  /// and its caches are never hit from the sort. The layout orders are cached
+  /// for later hasMapping(), getOutputSection() and getExprs() queries.
+  std::vector<size_t> getLayoutPermutation(ArrayRef<SectionKey> keys);
+
   /// Retrieve the name of the output section that this input section is mapped
   /// to, according to custom linker script mappings.
   StringRef getOutputSection(const SectionKey &key) const;
@@ -1263,6 +1365,8 @@ public:
   /// Evaluate a single linker script expression according to our current
   /// context (symbol table). This function is *not* constant because it can
   /// update our symbol table with new symbols calculated in this expression.
+  /// Expressions that do not depend on the location counter were evaluated
+  /// once by perform(), so for them this only has to update curPos.
   std::error_code evalExpr(const SymbolAssignment *assgn, uint64_t &curPos);
 
   /// Retrieve the set of symbols defined in linker script expressions.
@@ -1308,6 +1412,11 @@ private:
   ///expressions.
   int getLayoutOrder(const SectionKey &key, bool coarse) const;
 
+  /// Uncached version of getLayoutOrder. Returns the coarse layout order of
+  /// \p key and sets \p exprOrder to the fine one. Does not touch any mutable
+  /// state, so it may be called concurrently.
+  int findLayoutOrder(const SectionKey &key, int &exprOrder) const;
+
   /// Compare two sections that have the same mapping rule (i.e., are matched
   /// by the same InputSectionsCmd).
   /// Determine if lhs < rhs by analyzing the InputSectionsCmd structure.
@@ -1372,16 +1481,65 @@ private:
 
   void perform(const LinkerScript *ls);
 
+  /// Compile the archive and section name patterns of all layout commands and
+  /// index the rules in _memberNameWildcards by their section name patterns.
+  void compilePatterns();
+
+  /// Returns the indices into _memberNameWildcards of the rules that may have
+  /// a section name pattern matching \p sectionName, in ascending order.
+  void getCandidateRules(StringRef sectionName,
+                         SmallVectorImpl<unsigned> &rules) const;
+
+  const WildcardPattern &getPattern(const Command *c) const {
+    auto it = _patterns.find(c);
+    assert(it != _patterns.end() && "Pattern was not compiled");
+    return it->second;
+  }
+
+  bool sortedGroupContains(const InputSectionSortedGroup *cmd,
+                           const SectionKey &key) const;
+
+  /// Compile the expressions of all symbol assignments, then evaluate the ones
+  /// that do not depend on the location counter, in dependency order.
+  void compileExpressions();
+
+  /// Returns the slot holding the value of symbol \p name.
+  unsigned getSymbolSlot(StringRef name);
+
+  void compileExpr(const Expression *expr, CompiledExpr &out);
+
+  struct CompiledAssignment {
+    CompiledExpr _expr;
+    unsigned _slot;
+    // True if compileExpressions() already stored the value in _slot.
+    bool _isConstant;
+  };
+
   std::vector<std::unique_ptr<Parser>> _scripts;
   std::vector<const Command *> _layoutCommands;
   std::unordered_multimap<std::string, int> _memberToLayoutOrder;
-  std::vector<std::pair<StringRef, int>> _memberNameWildcards;
+  std::vector<std::pair<WildcardPattern, int>> _memberNameWildcards;
+  // Compiled section name patterns of InputSectionName commands, and archive
+  // name patterns of InputSectionsCmd commands.
+  llvm::DenseMap<const Command *, WildcardPattern> _patterns;
+  // Rules in _memberNameWildcards by section name pattern: exact names, the
+  // literals of prefix patterns and their distinct lengths, and the rules with
+  // any other pattern.
+  llvm::StringMap<std::vector<unsigned>> _exactNameRules;
+  llvm::StringMap<std::vector<unsigned>> _prefixNameRules;
+  std::vector<size_t> _prefixLengths;
+  std::vector<unsigned> _otherNameRules;
   mutable std::unordered_map<SectionKey, int, SectionKeyHash, SectionKeyEq>
       _cacheSectionOrder, _cacheExpressionOrder;
   llvm::DenseSet<int> _deliveredExprs;
   mutable llvm::StringSet<> _definedSymbols;
 
-  Expression::SymbolTableTy _symbolTable;
+  // Compiled symbol assignments, and the symbol table they work on. Slot 0 of
+  // _slots is the location counter.
+  std::vector<CompiledAssignment> _assignments;
+  llvm::DenseMap<const SymbolAssignment *, unsigned> _assignmentIds;
+  llvm::StringMap<unsigned> _symbolSlots;
+  std::vector<CompiledExpr::Slot> _slots;
 };
 
 llvm::BumpPtrAllocator &Command::getAllocator() const {
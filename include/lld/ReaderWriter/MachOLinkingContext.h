@@ -89,6 +89,13 @@ public:
 
   HeaderFileType outputMachOType() const { return _outputMachOType; }
 
+  bool globalsAreExported() const override {
+    return _outputMachOType != llvm::MachO::MH_EXECUTE;
+  }
+
+  bool isCallReference(const DefinedAtom &atom,
+                       const Reference &ref) const override;
+
   Arch arch() const { return _arch; }
   StringRef archName() const { return nameFromArch(_arch); }
   OS os() const { return _os; }
@@ -105,11 +112,14 @@ public:
   }
 
   void appendOrderedSymbol(StringRef symbol, StringRef filename);
+  bool isOrderedSymbol(StringRef symbol) const;
 
   bool keepPrivateExterns() const { return _keepPrivateExterns; }
   void setKeepPrivateExterns(bool v) { _keepPrivateExterns = v; }
   bool demangleSymbols() const { return _demangle; }
   void setDemangleSymbols(bool d) { _demangle = d; }
+  bool mergeSymbolStrings() const { return _mergeSymbolStrings; }
+  void setMergeSymbolStrings(bool v) { _mergeSymbolStrings = v; }
   /// Create file at specified path which will contain a binary encoding
   /// of all input and output file paths.
   std::error_code createDependencyFile(StringRef path);
@@ -122,6 +132,8 @@ public:
   bool doNothing() const { return _doNothing; }
   bool printAtoms() const { return _printAtoms; }
   bool testingFileUsage() const { return _testingFileUsage; }
+  uint64_t testBranchReach() const { return _testBranchReach; }
+  StringRef dylibCachePath() const { return _dylibCachePath; }
   const StringRefVector &searchDirs() const { return _searchDirs; }
   const StringRefVector &frameworkDirs() const { return _frameworkDirs; }
   void setSysLibRoots(const StringRefVector &paths);
@@ -223,6 +235,8 @@ public:
   void setTestingFileUsage(bool value = true) {
     _testingFileUsage = value;
   }
+  void setTestBranchReach(uint64_t reach) { _testBranchReach = reach; }
+  void setDylibCachePath(StringRef path) { _dylibCachePath = path; }
   void addExistingPathForDebug(StringRef path) {
     _existingPaths.insert(path);
   }
@@ -249,6 +263,7 @@ public:
 
   /// Pass to add shims switching between thumb and arm mode.
   bool needsShimPass() const;
+  bool needsBranchIslandPass() const;
 
   /// Magic symbol name stubs will need to help lazy bind.
   StringRef binderSymbolName() const;
@@ -349,8 +364,11 @@ private:
   bool _deadStrippableDylib;
   bool _printAtoms;
   bool _testingFileUsage;
+  uint64_t _testBranchReach;
+  StringRef _dylibCachePath;
   bool _keepPrivateExterns;
   bool _demangle;
+  bool _mergeSymbolStrings;
   StringRef _bundleLoader;
   mutable std::unique_ptr<mach_o::ArchHandler> _archHandler;
   mutable std::unique_ptr<Writer> _writer;
@@ -0,0 +1,223 @@
+//===- Core/AtomOrder.cpp - Profile-guided atom ordering ------------------===//
+//
+//                             The LLVM Linker
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#include "lld/Core/AtomOrder.h"
+#include "lld/Core/DefinedAtom.h"
+#include "lld/Core/Error.h"
+#include "lld/Core/Reference.h"
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/StringExtras.h"
+#include <algorithm>
+#include <limits>
+
+namespace lld {
+
+unsigned CallGraphProfile::getId(StringRef name) {
+  auto it = _ids.find(name);
+  if (it != _ids.end())
+    return it->second;
+  unsigned id = _names.size();
+  auto &entry = *_ids.insert(std::make_pair(name, id)).first;
+  _names.push_back(entry.getKey());
+  return id;
+}
+
+std::error_code CallGraphProfile::parse(StringRef content) {
+  while (!content.empty()) {
+    StringRef line;
+    std::tie(line, content) = content.split('\n');
+    line = line.trim();
+    if (line.empty())
+      continue;
+    StringRef caller, callee, weightStr, rest;
+    std::tie(caller, rest) = llvm::getToken(line);
+    std::tie(callee, rest) = llvm::getToken(rest);
+    std::tie(weightStr, rest) = llvm::getToken(rest);
+    uint64_t weight;
+    if (callee.empty() || weightStr.getAsInteger(10, weight) ||
+        !rest.trim().empty())
+      return make_dynamic_error_code(
+          Twine("malformed call graph profile entry: ") + line);
+    Edge edge = {getId(caller), getId(callee), weight};
+    _edges.push_back(edge);
+  }
+  return std::error_code();
+}
+
+namespace {
+/// Functions are merged into the cluster of their hottest caller only while
+/// the cluster stays below this size, and as long as doing so does not make
+/// the cluster much colder. The values are the ones proposed with C3.
+const uint64_t maxClusterSize = 1024 * 1024;
+const uint64_t maxDensityDegradation = 8;
+
+struct Cluster {
+  uint64_t size;
+  uint64_t weight;
+  unsigned next; // Circular list of the members, in layout order.
+  unsigned last; // Last member, valid for the leader.
+  unsigned leader;
+
+  double density() const { return double(weight) / size; }
+};
+} // end anonymous namespace
+
+static unsigned findLeader(std::vector<Cluster> &clusters, unsigned i) {
+  while (clusters[i].leader != i) {
+    clusters[i].leader = clusters[clusters[i].leader].leader;
+    i = clusters[i].leader;
+  }
+  return i;
+}
+
+std::vector<const DefinedAtom *>
+CallGraphProfile::sortAtoms(ArrayRef<const DefinedAtom *> atoms) const {
+  std::vector<const DefinedAtom *> nodes(_names.size(), nullptr);
+  for (const DefinedAtom *atom : atoms) {
+    if (atom->contentType() != DefinedAtom::typeCode || atom->name().empty())
+      continue;
+    auto it = _ids.find(atom->name());
+    if (it != _ids.end() && !nodes[it->second])
+      nodes[it->second] = atom;
+  }
+
+  // Each function starts in a cluster of its own. Its weight is the sum of
+  // its incoming edges, and its hottest caller is the one it would like to
+  // follow.
+  const unsigned none = std::numeric_limits<unsigned>::max();
+  size_t numNodes = nodes.size();
+  std::vector<Cluster> clusters(numNodes);
+  std::vector<unsigned> bestCaller(numNodes, none);
+  std::vector<uint64_t> bestWeight(numNodes, 0);
+  std::vector<bool> used(numNodes, false);
+  for (unsigned i = 0; i != numNodes; ++i) {
+    uint64_t size = nodes[i] ? nodes[i]->size() : 0;
+    Cluster c = {std::max<uint64_t>(size, 1), 0, i, i, i};
+    clusters[i] = c;
+  }
+  for (const Edge &edge : _edges) {
+    if (edge.caller == edge.callee || !nodes[edge.caller] ||
+        !nodes[edge.callee])
+      continue;
+    used[edge.caller] = used[edge.callee] = true;
+    clusters[edge.callee].weight += edge.weight;
+    if (edge.weight > bestWeight[edge.callee]) {
+      bestWeight[edge.callee] = edge.weight;
+      bestCaller[edge.callee] = edge.caller;
+    }
+  }
+
+  std::vector<unsigned> byDensity;
+  for (unsigned i = 0; i != numNodes; ++i)
+    if (used[i])
+      byDensity.push_back(i);
+  auto denser = [&](unsigned a, unsigned b) {
+    return clusters[a].density() > clusters[b].density();
+  };
+  std::stable_sort(byDensity.begin(), byDensity.end(), denser);
+
+  for (unsigned i : byDensity) {
+    if (bestCaller[i] == none)
+      continue;
+    unsigned from = findLeader(clusters, i);
+    unsigned into = findLeader(clusters, bestCaller[i]);
+    if (from == into)
+      continue;
+    Cluster &src = clusters[from];
+    Cluster &dst = clusters[into];
+    if (src.size + dst.size > maxClusterSize)
+      continue;
+    double merged = double(src.weight + dst.weight) / (src.size + dst.size);
+    if (merged * maxDensityDegradation < dst.density())
+      continue;
+    // Append the members of src to dst. A leader is the first member of its
+    // cluster, so the last member links back to it.
+    clusters[dst.last].next = from;
+    clusters[src.last].next = into;
+    dst.last = src.last;
+    dst.size += src.size;
+    dst.weight += src.weight;
+    src.leader = into;
+  }
+
+  std::vector<unsigned> leaders;
+  for (unsigned i : byDensity)
+    if (findLeader(clusters, i) == i)
+      leaders.push_back(i);
+  std::stable_sort(leaders.begin(), leaders.end(), denser);
+
+  std::vector<const DefinedAtom *> result;
+  for (unsigned leader : leaders) {
+    unsigned member = leader;
+    do {
+      result.push_back(nodes[member]);
+      member = clusters[member].next;
+    } while (member != leader);
+  }
+  return result;
+}
+
+void orderLayoutChains(llvm::MutableArrayRef<const DefinedAtom *> atoms,
+                       ArrayRef<unsigned> priority) {
+  const unsigned unordered = std::numeric_limits<unsigned>::max();
+  size_t numAtoms = atoms.size();
+
+  llvm::DenseMap<const DefinedAtom *, size_t> index;
+  llvm::DenseMap<const DefinedAtom *, const DefinedAtom *> prev;
+  for (size_t i = 0; i != numAtoms; ++i) {
+    index[atoms[i]] = i;
+    for (const Reference *ref : *atoms[i])
+      if (ref->kindNamespace() == Reference::KindNamespace::all &&
+          ref->kindValue() == Reference::kindLayoutAfter)
+        if (auto *target = dyn_cast_or_null<DefinedAtom>(ref->target()))
+          prev[target] = atoms[i];
+  }
+
+  // Find the first atom of each chain and the best priority of any of its
+  // members.
+  const size_t unknown = std::numeric_limits<size_t>::max();
+  std::vector<size_t> root(numAtoms, unknown);
+  std::vector<size_t> path;
+  for (size_t i = 0; i != numAtoms; ++i) {
+    size_t cur = i;
+    while (root[cur] == unknown && path.size() <= numAtoms) {
+      path.push_back(cur);
+      auto it = prev.find(atoms[cur]);
+      if (it == prev.end())
+        break;
+      auto pos = index.find(it->second);
+      if (pos == index.end())
+        break;
+      cur = pos->second;
+    }
+    size_t r = (root[cur] == unknown) ? cur : root[cur];
+    for (size_t member : path)
+      root[member] = r;
+    path.clear();
+  }
+  std::vector<unsigned> chainPriority(numAtoms, unordered);
+  for (size_t i = 0; i != numAtoms; ++i)
+    chainPriority[root[i]] = std::min(chainPriority[root[i]], priority[i]);
+
+  std::vector<size_t> perm(numAtoms);
+  for (size_t i = 0; i != numAtoms; ++i)
+    perm[i] = i;
+  std::stable_sort(perm.begin(), perm.end(), [&](size_t a, size_t b) {
+    unsigned prioA = chainPriority[root[a]], prioB = chainPriority[root[b]];
+    if (prioA != prioB)
+      return prioA < prioB;
+    return prioA != unordered && root[a] < root[b];
+  });
+
+  std::vector<const DefinedAtom *> sorted(atoms.begin(), atoms.end());
+  for (size_t i = 0; i != numAtoms; ++i)
+    atoms[i] = sorted[perm[i]];
+}
+
+} // end namespace lld
@@ -89,8 +89,14 @@ bool DefinedAtom::compareByPosition(const DefinedAtom *lhs,
   const File *rhsFile = &rhs->file();
   if (lhsFile->ordinal() != rhsFile->ordinal())
     return lhsFile->ordinal() < rhsFile->ordinal();
-  assert(lhs->ordinal() != rhs->ordinal());
-  return lhs->ordinal() < rhs->ordinal();
+  if (lhs->ordinal() != rhs->ordinal())
+    return lhs->ordinal() < rhs->ordinal();
+  // Aliases created by passes, such as ICF, share the position of their
+  // target and come before it.
+  assert(lhs->size() == 0 || rhs->size() == 0);
+  if (lhs->size() != rhs->size())
+    return lhs->size() < rhs->size();
+  return lhs->name() < rhs->name();
 }
 
 } // namespace
@@ -0,0 +1,321 @@
+//===- Core/ICF.cpp - Identical code folding ------------------------------===//
+//
+//                             The LLVM Linker
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// Identical code folding works on the classes of equivalent atoms. Atoms are
+// first put in the same class if their attributes, contents and references
+// (ignoring the targets) are the same. Then each class is split into
+// subclasses whose members' references point to atoms of the same classes,
+// until no class is split any more. The classes of an iteration are read
+// from one buffer and written to the other, so that classes are split in
+// parallel.
+//
+// A class is identified by the index of its first member in the array of
+// candidates, which is unique without any coordination between threads.
+//
+// The folded atoms are replaced with aliases of the atoms they were folded
+// into, so that their symbols stay in the output.
+//
+//===----------------------------------------------------------------------===//
+
+#include "lld/Core/ICF.h"
+#include "lld/Core/Alias.h"
+#include "lld/Core/DefinedAtom.h"
+#include "lld/Core/LinkingContext.h"
+#include "lld/Core/Parallel.h"
+#include "lld/Core/Reference.h"
+#include "lld/Core/Simple.h"
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/DenseSet.h"
+#include "llvm/ADT/Hashing.h"
+#include "llvm/ADT/StringSet.h"
+#include <algorithm>
+#include <atomic>
+
+namespace lld {
+
+namespace {
+/// Replaces an atom folded into \p keep. It shares the position and the
+/// alignment of \p keep, so that nothing is laid out between the two, and
+/// keeps the name, scope and merge attribute of the folded atom.
+class FoldedAtom : public AliasAtom {
+public:
+  FoldedAtom(const DefinedAtom &folded, const DefinedAtom &keep)
+      : AliasAtom(keep.file(), folded.name()), _keep(keep),
+        _scope(folded.scope()) {
+    setMerge(folded.merge());
+    addReference(Reference::KindNamespace::all, Reference::KindArch::all,
+                 Reference::kindLayoutAfter, 0, &keep, 0);
+  }
+
+  uint64_t ordinal() const override { return _keep.ordinal(); }
+  Scope scope() const override { return _scope; }
+  Alignment alignment() const override { return _keep.alignment(); }
+
+private:
+  const DefinedAtom &_keep;
+  Scope _scope;
+};
+
+class ICF {
+public:
+  ICF(const LinkingContext &ctx, SimpleFile &file) : _ctx(ctx), _file(file) {}
+
+  void run();
+
+private:
+  typedef std::pair<size_t, size_t> Range;
+
+  bool isCandidate(const DefinedAtom *atom) const;
+  bool equalsConstant(const DefinedAtom *a, const DefinedAtom *b) const;
+  bool equalsVariable(const DefinedAtom *a, const DefinedAtom *b) const;
+
+  template <class Pred> bool split(Range range, unsigned out, Pred eq);
+  std::vector<Range> findClasses(unsigned in) const;
+
+  const LinkingContext &_ctx;
+  SimpleFile &_file;
+  llvm::StringSet<> _roots;
+  llvm::DenseSet<const DefinedAtom *> _chained;
+  llvm::DenseSet<const DefinedAtom *> _addressTaken;
+
+  // Candidates in file order, and their positions in that vector.
+  std::vector<const DefinedAtom *> _atoms;
+  llvm::DenseMap<const Atom *, unsigned> _slot;
+
+  // Candidate slots, grouped by class.
+  std::vector<unsigned> _members;
+
+  // The class of each slot, double buffered.
+  std::vector<size_t> _class[2];
+  unsigned _current = 0;
+};
+} // end anonymous namespace
+
+bool ICF::isCandidate(const DefinedAtom *atom) const {
+  if (atom->contentType() != DefinedAtom::typeCode ||
+      atom->permissions() != DefinedAtom::permR_X || atom->size() == 0)
+    return false;
+  if (atom->deadStrip() == DefinedAtom::deadStripNever ||
+      atom->interposable() != DefinedAtom::interposeNo)
+    return false;
+  if (_ctx.icfMode() == LinkingContext::ICFMode::Safe &&
+      _addressTaken.count(atom))
+    return false;
+  if (_roots.count(atom->name()))
+    return false;
+  if (atom->scope() == DefinedAtom::scopeGlobal && _ctx.globalsAreExported())
+    return false;
+  return !_chained.count(atom);
+}
+
+bool ICF::equalsConstant(const DefinedAtom *a, const DefinedAtom *b) const {
+  if (a->size() != b->size() || !(a->alignment() == b->alignment()) ||
+      a->sectionChoice() != b->sectionChoice() ||
+      a->customSectionName() != b->customSectionName() ||
+      !a->rawContent().equals(b->rawContent()))
+    return false;
+  DefinedAtom::reference_iterator ia = a->begin(), ea = a->end();
+  DefinedAtom::reference_iterator ib = b->begin(), eb = b->end();
+  for (; ia != ea; ++ia, ++ib) {
+    if (!(ib != eb))
+      return false;
+    const Reference *ra = *ia;
+    const Reference *rb = *ib;
+    if (ra->offsetInAtom() != rb->offsetInAtom() ||
+        ra->kindNamespace() != rb->kindNamespace() ||
+        ra->kindArch() != rb->kindArch() ||
+        ra->kindValue() != rb->kindValue() || ra->addend() != rb->addend())
+      return false;
+  }
+  return !(ib != eb);
+}
+
+// Called only for atoms that are equal by equalsConstant.
+bool ICF::equalsVariable(const DefinedAtom *a, const DefinedAtom *b) const {
+  const std::vector<size_t> &classes = _class[_current];
+  DefinedAtom::reference_iterator ia = a->begin(), ea = a->end();
+  DefinedAtom::reference_iterator ib = b->begin();
+  for (; ia != ea; ++ia, ++ib) {
+    const Atom *ta = ia->target();
+    const Atom *tb = ib->target();
+    if (ta == tb)
+      continue;
+    auto sa = _slot.find(ta);
+    auto sb = _slot.find(tb);
+    if (sa == _slot.end() || sb == _slot.end())
+      return false;
+    if (classes[sa->second] != classes[sb->second])
+      return false;
+  }
+  return true;
+}
+
+/// Splits the class in \p range into subclasses of atoms equal by \p eq, and
+/// writes their ids to buffer \p out. Returns true if the class was split.
+template <class Pred> bool ICF::split(Range range, unsigned out, Pred eq) {
+  auto begin = _members.begin() + range.first;
+  auto end = _members.begin() + range.second;
+  bool didSplit = false;
+  while (begin != end) {
+    const DefinedAtom *head = _atoms[*begin];
+    auto mid = std::stable_partition(begin + 1, end, [&](unsigned slot) {
+      return eq(head, _atoms[slot]);
+    });
+    size_t id = begin - _members.begin();
+    for (auto it = begin; it != mid; ++it)
+      _class[out][*it] = id;
+    if (mid != end)
+      didSplit = true;
+    begin = mid;
+  }
+  return didSplit;
+}
+
+/// Returns the classes with more than one member.
+std::vector<ICF::Range> ICF::findClasses(unsigned in) const {
+  std::vector<Range> ranges;
+  for (size_t begin = 0, e = _members.size(); begin != e;) {
+    size_t end = begin + 1;
+    while (end != e && _class[in][_members[end]] == _class[in][_members[begin]])
+      ++end;
+    if (end - begin > 1)
+      ranges.push_back(Range(begin, end));
+    begin = end;
+  }
+  return ranges;
+}
+
+void ICF::run() {
+  if (!_ctx.entrySymbolName().empty())
+    _roots.insert(_ctx.entrySymbolName());
+  for (StringRef name : _ctx.deadStripRoots())
+    _roots.insert(name);
+  bool safe = _ctx.icfMode() == LinkingContext::ICFMode::Safe;
+  for (const DefinedAtom *atom : _file.defined()) {
+    for (const Reference *ref : *atom) {
+      auto *target = dyn_cast_or_null<DefinedAtom>(ref->target());
+      if (ref->kindNamespace() != Reference::KindNamespace::all) {
+        // The address of a function is significant unless it is only
+        // called or branched to.
+        if (safe && target && !_ctx.isCallReference(*atom, *ref))
+          _addressTaken.insert(target);
+        continue;
+      }
+      if (ref->kindValue() != Reference::kindLayoutAfter &&
+          ref->kindValue() != Reference::kindAssociate)
+        continue;
+      _chained.insert(atom);
+      if (target)
+        _chained.insert(target);
+    }
+  }
+
+  for (const DefinedAtom *atom : _file.defined())
+    if (isCandidate(atom)) {
+      _slot[atom] = _atoms.size();
+      _atoms.push_back(atom);
+    }
+  size_t numAtoms = _atoms.size();
+  if (numAtoms < 2)
+    return;
+
+  // Group the candidates by a hash of what equalsConstant compares, then
+  // split the groups into the initial classes.
+  std::vector<uint64_t> hashes(numAtoms);
+  parallel_for(size_t(0), numAtoms, [&](size_t i) {
+    const DefinedAtom *atom = _atoms[i];
+    ArrayRef<uint8_t> content = atom->rawContent();
+    llvm::hash_code hash = llvm::hash_combine(
+        atom->size(), llvm::hash_combine_range(content.begin(), content.end()));
+    for (const Reference *ref : *atom)
+      hash = llvm::hash_combine(hash, ref->offsetInAtom(), ref->kindValue());
+    hashes[i] = hash;
+  });
+  _members.resize(numAtoms);
+  for (unsigned i = 0; i != numAtoms; ++i)
+    _members[i] = i;
+  parallel_sort(_members.begin(), _members.end(), [&](unsigned a, unsigned b) {
+    if (hashes[a] != hashes[b])
+      return hashes[a] < hashes[b];
+    return a < b;
+  });
+  _class[0].resize(numAtoms);
+  _class[1].resize(numAtoms);
+  std::vector<Range> ranges;
+  for (size_t begin = 0; begin != numAtoms;) {
+    size_t end = begin + 1;
+    while (end != numAtoms && hashes[_members[end]] == hashes[_members[begin]])
+      ++end;
+    if (end - begin > 1)
+      ranges.push_back(Range(begin, end));
+    else
+      _class[0][_members[begin]] = begin;
+    begin = end;
+  }
+  auto constantEq = [&](const DefinedAtom *a, const DefinedAtom *b) {
+    return equalsConstant(a, b);
+  };
+  parallel_for(size_t(0), ranges.size(),
+               [&](size_t i) { split(ranges[i], 0, constantEq); });
+
+  // Split the classes until the references of all members of each class
+  // point to the same classes.
+  auto variableEq = [&](const DefinedAtom *a, const DefinedAtom *b) {
+    return equalsVariable(a, b);
+  };
+  for (;;) {
+    ranges = findClasses(_current);
+    unsigned next = _current ^ 1;
+    _class[next] = _class[_current];
+    std::atomic<bool> changed(false);
+    parallel_for(size_t(0), ranges.size(), [&](size_t i) {
+      if (split(ranges[i], next, variableEq))
+        changed = true;
+    });
+    _current = next;
+    if (!changed)
+      break;
+  }
+
+  // Keep the first member of each class, which comes first in the file,
+  // redirect the references to the others and replace them with aliases.
+  llvm::DenseMap<const Atom *, const DefinedAtom *> replacement;
+  std::vector<const DefinedAtom *> aliases;
+  for (const Range &range : findClasses(_current)) {
+    const DefinedAtom *keep = _atoms[_members[range.first]];
+    for (size_t i = range.first + 1; i != range.second; ++i) {
+      const DefinedAtom *folded = _atoms[_members[i]];
+      replacement[folded] = keep;
+      aliases.push_back(new (_file.allocator()) FoldedAtom(*folded, *keep));
+    }
+  }
+  if (replacement.empty())
+    return;
+  SimpleFile::DefinedAtomRange atoms = _file.definedAtoms();
+  parallel_for_each(atoms.begin(), atoms.end(), [&](const DefinedAtom *atom) {
+    for (const Reference *ref : *atom) {
+      auto it = replacement.find(ref->target());
+      if (it != replacement.end())
+        const_cast<Reference *>(ref)->setTarget(it->second);
+    }
+  });
+  _file.removeDefinedAtomsIf([&](const DefinedAtom *atom) {
+    return replacement.count(atom) != 0;
+  });
+  for (const DefinedAtom *alias : aliases)
+    _file.addAtom(*alias);
+}
+
+void ICFPass::perform(std::unique_ptr<SimpleFile> &mergedFile) {
+  if (_ctx.icfMode() == LinkingContext::ICFMode::None)
+    return;
+  ICF(_ctx, *mergedFile).run();
+}
+
+} // end namespace lld
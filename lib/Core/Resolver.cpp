@@ -13,6 +13,7 @@
 #include "lld/Core/Instrumentation.h"
 #include "lld/Core/LLVM.h"
 #include "lld/Core/LinkingContext.h"
+#include "lld/Core/Parallel.h"
 #include "lld/Core/Resolver.h"
 #include "lld/Core/SharedLibraryFile.h"
 #include "lld/Core/SymbolTable.h"
@@ -31,6 +32,7 @@ namespace lld {
 
 bool Resolver::handleFile(File &file) {
   bool undefAdded = false;
+  _linkedFiles.push_back(&file);
   for (const DefinedAtom *atom : file.defined())
     doDefinedAtom(*atom);
   for (const UndefinedAtom *atom : file.undefined()) {
@@ -155,6 +157,10 @@ void Resolver::maybeAddSectionGroupOrGnuLinkOnce(const DefinedAtom &atom) {
     llvm::report_fatal_error("duplicate symbol error");
   }
 
+  // The group is selected. Let the file create its members if it has not
+  // done so yet.
+  const_cast<File &>(atom.file()).loadGroupMembers(atom);
+
   for (const Reference *r : atom) {
     if (r->kindNamespace() == lld::Reference::KindNamespace::all &&
         r->kindValue() == lld::Reference::kindGroupChild) {
@@ -336,6 +342,18 @@ bool Resolver::resolveUndefines() {
   }
 }
 
+// Lets the linked files finish the members of the section groups that were
+// selected. This happens in parallel, as reading the relocations of the
+// members is a large part of reading a file with many groups.
+void Resolver::finishGroupMembers() {
+  ScopedTask task(getDefaultDomain(), "finishGroupMembers");
+  std::function<const Atom *(StringRef)> resolve = [&](StringRef name) {
+    return _symbolTable.findByName(name);
+  };
+  parallel_for_each(_linkedFiles.begin(), _linkedFiles.end(),
+                    [&](File *file) { file->finishGroupMembers(resolve); });
+}
+
 // switch all references to undefined or coalesced away atoms
 // to the new defined atom
 void Resolver::updateReferences() {
@@ -489,6 +507,7 @@ bool Resolver::resolve() {
   updatePreloadArchiveMap();
   if (!resolveUndefines())
     return false;
+  finishGroupMembers();
   updateReferences();
   deadStripOptimize();
   if (checkUndefines())
@@ -204,6 +204,17 @@ static std::error_code parseOrderFile(StringRef orderFilePath,
   return std::error_code();
 }
 
+/// Call graph ordering files have one "caller callee weight" entry per line.
+static std::error_code parseCallGraphOrderingFile(StringRef filePath,
+                                                  MachOLinkingContext &ctx) {
+  ErrorOr<std::unique_ptr<MemoryBuffer>> mb =
+                                   MemoryBuffer::getFileOrSTDIN(filePath);
+  if (std::error_code ec = mb.getError())
+    return ec;
+  ctx.addInputFileDependency(filePath);
+  return ctx.callGraphProfile().parse(mb.get()->getBuffer());
+}
+
 //
 // There are two variants of the  -filelist option:
 //
@@ -423,6 +434,21 @@ bool DarwinLdDriver::parse(int argc, const char *argv[],
   if (parsedArgs->getLastArg(OPT_dead_strip))
     ctx.setDeadStripping(true);
 
+  // Handle -icf=<mode>
+  if (llvm::opt::Arg *icf = parsedArgs->getLastArg(OPT_icf)) {
+    StringRef mode = icf->getValue();
+    if (mode == "all")
+      ctx.setICFMode(LinkingContext::ICFMode::All);
+    else if (mode == "safe")
+      ctx.setICFMode(LinkingContext::ICFMode::Safe);
+    else if (mode == "none")
+      ctx.setICFMode(LinkingContext::ICFMode::None);
+    else {
+      diagnostics << "error: unknown -icf mode: " << mode << "\n";
+      return false;
+    }
+  }
+
   // Handle -all_load
   if (parsedArgs->getLastArg(OPT_all_load))
     globalWholeArchive = true;
@@ -511,6 +537,10 @@ bool DarwinLdDriver::parse(int argc, const char *argv[],
   if (parsedArgs->getLastArg(OPT_demangle))
     ctx.setDemangleSymbols(true);
 
+  // Handle -merge_symbol_strings
+  if (parsedArgs->getLastArg(OPT_merge_symbol_strings))
+    ctx.setMergeSymbolStrings(true);
+
   // Handle -keep_private_externs
   if (parsedArgs->getLastArg(OPT_keep_private_externs)) {
     ctx.setKeepPrivateExterns(true);
@@ -528,6 +558,10 @@ bool DarwinLdDriver::parse(int argc, const char *argv[],
     }
   }
 
+  // Handle -dylib_cache_path <dir>
+  if (llvm::opt::Arg *cache = parsedArgs->getLastArg(OPT_dylib_cache_path))
+    ctx.setDylibCachePath(cache->getValue());
+
   // In -test_file_usage mode, we'll be given an explicit list of paths that
   // exist. We'll also be expected to print out information about how we located
   // libraries and so on that the user specified, but not to actually do any
@@ -544,6 +578,16 @@ bool DarwinLdDriver::parse(int argc, const char *argv[],
     }
   }
 
+  // Handle -test_branch_reach
+  if (llvm::opt::Arg *reach = parsedArgs->getLastArg(OPT_test_branch_reach)) {
+    uint64_t reachVal;
+    if (parseNumberBase16(reach->getValue(), reachVal)) {
+      diagnostics << "error: test_branch_reach expects a hex number\n";
+      return false;
+    }
+    ctx.setTestBranchReach(reachVal);
+  }
+
   // Register possible input file parsers.
   if (!ctx.doNothing()) {
     ctx.registry().addSupportMachOObjects(ctx);
@@ -753,6 +797,17 @@ bool DarwinLdDriver::parse(int argc, const char *argv[],
     }
   }
 
+  // Handle -call_graph_ordering_file <file>
+  if (auto *arg = parsedArgs->getLastArg(OPT_call_graph_ordering_file)) {
+    if (std::error_code ec = parseCallGraphOrderingFile(arg->getValue(), ctx)) {
+      diagnostics << "error: " << ec.message()
+                  << ", processing '-call_graph_ordering_file "
+                  << arg->getValue()
+                  << "'\n";
+      return false;
+    }
+  }
+
   // Handle -rpath <path>
   if (parsedArgs->hasArg(OPT_rpath)) {
     switch (ctx.outputMachOType()) {
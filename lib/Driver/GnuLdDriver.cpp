@@ -24,6 +24,7 @@
 #include "llvm/Option/Arg.h"
 #include "llvm/Option/Option.h"
 #include "llvm/Support/CommandLine.h"
+#include "llvm/Support/Compression.h"
 #include "llvm/Support/Errc.h"
 #include "llvm/Support/FileSystem.h"
 #include "llvm/Support/Host.h"
@@ -147,6 +148,32 @@ static bool parseMaxPageSize(StringRef opt, uint64_t &val) {
   return true;
 }
 
+// Parses --symbol-ordering-file=<file>, which lists one symbol per line.
+static std::error_code parseSymbolOrderingFile(ELFLinkingContext &ctx,
+                                               StringRef path) {
+  ErrorOr<std::unique_ptr<MemoryBuffer>> mb =
+      MemoryBuffer::getFileOrSTDIN(path);
+  if (std::error_code ec = mb.getError())
+    return ec;
+  SmallVector<StringRef, 128> lines;
+  mb.get()->getBuffer().split(lines, "\n");
+  for (StringRef line : lines) {
+    StringRef sym = line.trim();
+    if (!sym.empty())
+      ctx.addOrderedSymbol(sym);
+  }
+  return std::error_code();
+}
+
+static std::error_code parseCallGraphOrderingFile(ELFLinkingContext &ctx,
+                                                  StringRef path) {
+  ErrorOr<std::unique_ptr<MemoryBuffer>> mb =
+      MemoryBuffer::getFileOrSTDIN(path);
+  if (std::error_code ec = mb.getError())
+    return ec;
+  return ctx.callGraphProfile().parse(mb.get()->getBuffer());
+}
+
 bool GnuLdDriver::linkELF(int argc, const char *argv[], raw_ostream &diag) {
   BumpPtrAllocator alloc;
   std::tie(argc, argv) = maybeExpandResponseFiles(argc, argv, alloc);
@@ -506,6 +533,38 @@ bool GnuLdDriver::parse(int argc, const char *argv[],
   if (auto *arg = parsedArgs->getLastArg(OPT_output))
     ctx->setOutputPath(arg->getValue());
 
+  // Handle --icf=<mode>
+  if (auto *arg = parsedArgs->getLastArg(OPT_icf)) {
+    StringRef mode = arg->getValue();
+    if (mode == "all")
+      ctx->setICFMode(LinkingContext::ICFMode::All);
+    else if (mode == "safe")
+      ctx->setICFMode(LinkingContext::ICFMode::Safe);
+    else if (mode == "none")
+      ctx->setICFMode(LinkingContext::ICFMode::None);
+    else {
+      diag << "unknown --icf mode: " << mode << "\n";
+      return false;
+    }
+  }
+
+  // Handle --compress-debug-sections=<format>
+  if (auto *arg = parsedArgs->getLastArg(OPT_compress_debug_sections)) {
+    StringRef format = arg->getValue();
+    if (format == "zlib" || format == "zlib-gabi") {
+      if (!llvm::zlib::isAvailable()) {
+        diag << "--compress-debug-sections: zlib is not available\n";
+        return false;
+      }
+      ctx->setCompressDebugSections(true);
+    } else if (format == "none") {
+      ctx->setCompressDebugSections(false);
+    } else {
+      diag << "unknown --compress-debug-sections format: " << format << "\n";
+      return false;
+    }
+  }
+
   if (parsedArgs->hasArg(OPT_noinhibit_exec))
     ctx->setAllowRemainingUndefines(true);
 
@@ -590,6 +649,10 @@ bool GnuLdDriver::parse(int argc, const char *argv[],
       ctx->setDTFlag(ELFLinkingContext::DTFlag::DT_NOW);
     else if (opt == "origin")
       ctx->setDTFlag(ELFLinkingContext::DTFlag::DT_ORIGIN);
+    else if (opt == "pack-relative-relocs")
+      ctx->setPackRelativeRelocs(true);
+    else if (opt == "nopack-relative-relocs")
+      ctx->setPackRelativeRelocs(false);
     else if (opt.startswith("max-page-size")) {
       // Parse -z max-page-size option.
       // The default page size is considered the minimum page size the user
@@ -634,6 +697,30 @@ bool GnuLdDriver::parse(int argc, const char *argv[],
   for (auto *arg : parsedArgs->filtered(OPT_wrap))
     ctx->addWrapForSymbol(arg->getValue());
 
+  // Support --symbol-ordering-file option.
+  if (auto *arg = parsedArgs->getLastArg(OPT_symbol_ordering_file)) {
+    if (std::error_code ec =
+            parseSymbolOrderingFile(*ctx, arg->getValue())) {
+      diag << "cannot read symbol ordering file " << arg->getValue() << ": "
+           << ec.message() << "\n";
+      return false;
+    }
+  }
+
+  // Support --call-graph-ordering-file option.
+  if (auto *arg = parsedArgs->getLastArg(OPT_call_graph_ordering_file)) {
+    // The profile is an input of the link, so -t lists it as Mach-O lists
+    // it in -dependency_info.
+    if (ctx->logInputFiles())
+      diag << arg->getValue() << "\n";
+    if (std::error_code ec =
+            parseCallGraphOrderingFile(*ctx, arg->getValue())) {
+      diag << "cannot read call graph ordering file " << arg->getValue()
+           << ": " << ec.message() << "\n";
+      return false;
+    }
+  }
+
   // Register possible input file parsers.
   ctx->registry().addSupportELFObjects(*ctx);
   ctx->registry().addSupportArchives(ctx->logInputFiles());
@@ -1081,6 +1081,20 @@ bool WinLinkDriver::parse(int argc, const char *argv[],
     }
   }
 
+  // /call-graph-ordering-file:<file>
+  if (auto *arg = parsedArgs->getLastArg(OPT_call_graph_ordering_file)) {
+    ErrorOr<std::unique_ptr<MemoryBuffer>> buf =
+        MemoryBuffer::getFile(arg->getValue());
+    std::error_code ec = buf.getError();
+    if (!ec)
+      ec = ctx.callGraphProfile().parse(buf.get()->getBuffer());
+    if (ec) {
+      diag << "Cannot read call graph ordering file " << arg->getValue()
+           << ": " << ec.message() << "\n";
+      return false;
+    }
+  }
+
   if (auto *arg = parsedArgs->getLastArg(OPT_manifestfile))
     ctx.setManifestOutputPath(ctx.allocate(arg->getValue()));
 
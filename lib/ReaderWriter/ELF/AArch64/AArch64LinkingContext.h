@@ -89,6 +89,13 @@ public:
       return false;
     }
   }
+
+  bool isPackableRelativeReloc(const Reference &r) const override {
+    if (r.kindNamespace() != Reference::KindNamespace::ELF)
+      return false;
+    assert(r.kindArch() == Reference::KindArch::AArch64);
+    return r.kindValue() == llvm::ELF::R_AARCH64_RELATIVE;
+  }
 };
 } // end namespace elf
 } // end namespace lld
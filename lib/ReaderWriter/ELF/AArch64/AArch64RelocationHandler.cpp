@@ -400,9 +400,9 @@ static void relocR_AARCH64_TLSLE_ADD_TPREL_LO12_NC(uint8_t *location,
 }
 
 std::error_code AArch64TargetRelocationHandler::applyRelocation(
-    ELFWriter &writer, llvm::FileOutputBuffer &buf, const AtomLayout &atom,
+    ELFWriter &writer, uint8_t *buf, const AtomLayout &atom,
     const Reference &ref) const {
-  uint8_t *atomContent = buf.getBufferStart() + atom._fileOffset;
+  uint8_t *atomContent = buf + atom._fileOffset;
   uint8_t *loc = atomContent + ref.offsetInAtom();
   uint64_t target = writer.addressOfAtom(ref.target());
   uint64_t reloc = atom._virtualAddr + ref.offsetInAtom();
@@ -417,6 +417,11 @@ std::error_code AArch64TargetRelocationHandler::applyRelocation(
   case R_AARCH64_ABS64:
     relocR_AARCH64_ABS64(loc, reloc, target, addend);
     break;
+  case R_AARCH64_RELATIVE:
+    // Also store the value in place; the packed .relr.dyn format has no
+    // addend field of its own.
+    relocR_AARCH64_ABS64(loc, reloc, target, addend);
+    break;
   case R_AARCH64_ABS32:
     return relocR_AARCH64_ABS32(loc, reloc, target, addend);
   case R_AARCH64_ABS16:
@@ -429,7 +434,6 @@ std::error_code AArch64TargetRelocationHandler::applyRelocation(
   case R_AARCH64_PREL16:
     return relocR_AARCH64_PREL16(loc, reloc, target, addend);
   // Runtime only relocations. Ignore here.
-  case R_AARCH64_RELATIVE:
   case R_AARCH64_IRELATIVE:
   case R_AARCH64_JUMP_SLOT:
   case R_AARCH64_GLOB_DAT:
@@ -17,7 +17,7 @@ namespace elf {
 
 class AArch64TargetRelocationHandler final : public TargetRelocationHandler {
 public:
-  std::error_code applyRelocation(ELFWriter &, llvm::FileOutputBuffer &,
+  std::error_code applyRelocation(ELFWriter &, uint8_t *,
                                   const AtomLayout &,
                                   const Reference &) const override;
 };
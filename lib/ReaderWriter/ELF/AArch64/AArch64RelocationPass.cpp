@@ -19,6 +19,7 @@
 #include "AArch64RelocationPass.h"
 #include "AArch64LinkingContext.h"
 #include "Atoms.h"
+#include "ReferenceScan.h"
 #include "lld/Core/Simple.h"
 #include "llvm/ADT/DenseMap.h"
 #include "llvm/ADT/STLExtras.h"
@@ -145,6 +146,51 @@ template <class Derived> class AArch64RelocationPass : public Pass {
     }
   }
 
+  /// \brief Returns false if handleReference would leave \p ref alone.
+  static bool mayNeedHandling(const Reference &ref) {
+    if (ref.kindNamespace() != Reference::KindNamespace::ELF)
+      return false;
+    switch (ref.kindValue()) {
+    case R_AARCH64_ABS32:
+    case R_AARCH64_ABS16:
+    case R_AARCH64_ABS64:
+    case R_AARCH64_PREL16:
+    case R_AARCH64_PREL32:
+    case R_AARCH64_PREL64:
+    case R_AARCH64_ADR_PREL_PG_HI21:
+    case R_AARCH64_LDST8_ABS_LO12_NC:
+    case R_AARCH64_LDST16_ABS_LO12_NC:
+    case R_AARCH64_LDST32_ABS_LO12_NC:
+    case R_AARCH64_LDST64_ABS_LO12_NC:
+    case R_AARCH64_LDST128_ABS_LO12_NC:
+    case R_AARCH64_ADD_ABS_LO12_NC:
+    case R_AARCH64_CALL26:
+    case R_AARCH64_JUMP26:
+    case R_AARCH64_CONDBR19:
+    case R_AARCH64_TLSLE_ADD_TPREL_HI12:
+    case R_AARCH64_TLSLE_ADD_TPREL_LO12_NC:
+      return mayRedirectPlainReference(ref.target());
+    case R_AARCH64_GOTREL32:
+    case R_AARCH64_GOTREL64:
+    case R_AARCH64_ADR_GOT_PAGE:
+    case R_AARCH64_LD64_GOT_LO12_NC:
+    case R_AARCH64_TLSIE_ADR_GOTTPREL_PAGE21:
+    case R_AARCH64_TLSIE_LD64_GOTTPREL_LO12_NC:
+      return true;
+    default:
+      return false;
+    }
+  }
+
+  /// \brief Returns true if \p ref is an R_AARCH64_ABS64 that the dynamic
+  /// loader can apply by adding the load address alone.
+  static bool isRelativeCandidate(const DefinedAtom &atom,
+                                  const Reference &ref) {
+    return ref.kindNamespace() == Reference::KindNamespace::ELF &&
+           ref.kindValue() == R_AARCH64_ABS64 &&
+           canUseRelativeReloc(atom, ref.target());
+  }
+
 protected:
   /// \brief get the PLT entry for a given IFUNC Atom.
   ///
@@ -220,7 +266,9 @@ protected:
     auto got = _gotMap.find(da);
     if (got == _gotMap.end()) {
       auto g = new (_file._alloc) AArch64GOTAtom(_file, ".got");
-      g->addReferenceELF_AArch64(R_AARCH64_ABS64, 0, da, 0);
+      bool relative = _relativeRelocs && canUseRelativeReloc(*g, da);
+      g->addReferenceELF_AArch64(
+          relative ? R_AARCH64_RELATIVE : R_AARCH64_ABS64, 0, da, 0);
 #ifndef NDEBUG
       g->_name = "__got_";
       g->_name += da->name();
@@ -233,7 +281,9 @@ protected:
   }
 
 public:
-  AArch64RelocationPass(const ELFLinkingContext &ctx) : _file(ctx), _ctx(ctx) {}
+  AArch64RelocationPass(const ELFLinkingContext &ctx,
+                        bool relativeRelocs = false)
+      : _file(ctx), _ctx(ctx), _relativeRelocs(relativeRelocs) {}
 
   /// \brief Do the pass.
   ///
@@ -268,11 +318,20 @@ public:
             llvm::dbgs()
             << "Defined Atoms"
             << "\n");
-    for (const auto &atom : mf->defined()) {
-      for (const auto &ref : *atom) {
-        handleReference(*atom, *ref);
-      }
-    }
+
+    // Filter out the references that need no GOT or PLT entry in parallel,
+    // then handle the rest serially in their original order. Absolute words
+    // that only need the load address added become R_AARCH64_RELATIVE here.
+    std::vector<AtomReference> refs = scanReferences(
+        *mf, [this](const DefinedAtom &atom, const Reference &ref) {
+          if (_relativeRelocs && isRelativeCandidate(atom, ref)) {
+            const_cast<Reference &>(ref).setKindValue(R_AARCH64_RELATIVE);
+            return false;
+          }
+          return mayNeedHandling(ref);
+        });
+    for (const AtomReference &ar : refs)
+      handleReference(*ar.first, *ar.second);
 
     // Add all created atoms to the link.
     uint64_t ordinal = 0;
@@ -309,6 +368,10 @@ protected:
   ELFPassFile _file;
   const ELFLinkingContext &_ctx;
 
+  /// \brief Use R_AARCH64_RELATIVE for absolute words to atoms defined in the
+  /// link, so that a shared object can be loaded anywhere.
+  const bool _relativeRelocs;
+
   /// \brief Map Atoms to their GOT entries.
   llvm::DenseMap<const Atom *, GOTAtom *> _gotMap;
 
@@ -378,7 +441,9 @@ class AArch64DynamicRelocationPass final
     : public AArch64RelocationPass<AArch64DynamicRelocationPass> {
 public:
   AArch64DynamicRelocationPass(const elf::AArch64LinkingContext &ctx)
-      : AArch64RelocationPass(ctx) {}
+      : AArch64RelocationPass(ctx,
+                              ctx.getOutputELFType() == llvm::ELF::ET_DYN &&
+                                  ctx.packRelativeRelocs()) {}
 
   const PLT0Atom *getPLT0() {
     if (_plt0)
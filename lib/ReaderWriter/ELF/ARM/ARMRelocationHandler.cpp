@@ -571,9 +571,9 @@ static bool fixupUnresolvedWeakCall(uint8_t *location,
 }
 
 std::error_code ARMTargetRelocationHandler::applyRelocation(
-    ELFWriter &writer, llvm::FileOutputBuffer &buf, const AtomLayout &atom,
+    ELFWriter &writer, uint8_t *buf, const AtomLayout &atom,
     const Reference &ref) const {
-  uint8_t *atomContent = buf.getBufferStart() + atom._fileOffset;
+  uint8_t *atomContent = buf + atom._fileOffset;
   uint8_t *loc = atomContent + ref.offsetInAtom();
   uint64_t target = writer.addressOfAtom(ref.target());
   uint64_t reloc = atom._virtualAddr + ref.offsetInAtom();
@@ -21,7 +21,7 @@ class ARMTargetRelocationHandler final : public TargetRelocationHandler {
 public:
   ARMTargetRelocationHandler(ARMTargetLayout &layout) : _armLayout(layout) {}
 
-  std::error_code applyRelocation(ELFWriter &, llvm::FileOutputBuffer &,
+  std::error_code applyRelocation(ELFWriter &, uint8_t *,
                                   const AtomLayout &,
                                   const Reference &) const override;
 
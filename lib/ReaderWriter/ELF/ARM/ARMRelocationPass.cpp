@@ -19,6 +19,7 @@
 #include "ARMRelocationPass.h"
 #include "ARMLinkingContext.h"
 #include "Atoms.h"
+#include "ReferenceScan.h"
 #include "lld/Core/Simple.h"
 #include "llvm/ADT/MapVector.h"
 #include "llvm/ADT/STLExtras.h"
@@ -363,6 +364,34 @@ template <class Derived> class ARMRelocationPass : public Pass {
     }
   }
 
+  /// \brief Returns false if handleReference would leave \p ref alone.
+  static bool mayNeedHandling(const Reference &ref) {
+    if (ref.kindNamespace() != Reference::KindNamespace::ELF)
+      return false;
+    switch (ref.kindValue()) {
+    case R_ARM_ABS32:
+    case R_ARM_REL32:
+    case R_ARM_TARGET1:
+    case R_ARM_MOVW_ABS_NC:
+    case R_ARM_MOVT_ABS:
+    case R_ARM_THM_MOVW_ABS_NC:
+    case R_ARM_THM_MOVT_ABS:
+      return mayRedirectPlainReference(ref.target());
+    case R_ARM_THM_CALL:
+    case R_ARM_CALL:
+    case R_ARM_JUMP24:
+    case R_ARM_THM_JUMP24:
+    case R_ARM_THM_JUMP11:
+    case R_ARM_TLS_IE32:
+    case R_ARM_GOT_BREL:
+      // Branches may need veneers, which depend on the code model of both
+      // ends, so they are always handled.
+      return true;
+    default:
+      return false;
+    }
+  }
+
 protected:
   /// \brief Determine source atom's actual code model.
   ///
@@ -700,12 +729,14 @@ public:
           llvm::dbgs() << " Name of Atom: " << atom->name().str() << "\n";
         });
 
-    // Process all references.
-    for (const auto &atom : mf->defined()) {
-      for (const auto &ref : *atom) {
-        handleReference(*atom, *ref);
-      }
-    }
+    // Filter out the references that need no GOT, PLT or veneer in parallel,
+    // then handle the rest serially in their original order.
+    std::vector<AtomReference> refs = scanReferences(
+        *mf, [](const DefinedAtom &, const Reference &ref) {
+          return mayNeedHandling(ref);
+        });
+    for (const AtomReference &ar : refs)
+      handleReference(*ar.first, *ar.second);
 
     // Add all created atoms to the link.
     uint64_t ordinal = 0;
@@ -172,6 +172,15 @@ public:
   void incrementIterator(const void *&It) const override;
   void addReference(ELFReference<ELFT> *reference);
 
+  /// The references of this atom are [start, end) of the reference list of
+  /// its file.
+  unsigned int referenceStartIndex() const { return _referenceStartIndex; }
+  unsigned int referenceEndIndex() const { return _referenceEndIndex; }
+  void setReferenceRange(unsigned int start, unsigned int end) {
+    _referenceStartIndex = start;
+    _referenceEndIndex = end;
+  }
+
   virtual void setOrdinal(uint64_t ord) { _ordinal = ord; }
 
 protected:
@@ -0,0 +1,84 @@
+//===- lib/ReaderWriter/ELF/Compression.cpp -------------------------------===//
+//
+//                             The LLVM Linker
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#include "Compression.h"
+#include "lld/Core/Parallel.h"
+#include "llvm/Config/config.h"
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+
+#if LLVM_ENABLE_ZLIB == 1 && HAVE_LIBZ
+#include <zlib.h>
+#endif
+
+namespace lld {
+namespace elf {
+
+#if LLVM_ENABLE_ZLIB == 1 && HAVE_LIBZ
+bool zlibCompress(ArrayRef<uint8_t> in, std::vector<uint8_t> &out) {
+  const size_t blockSize = 1 << 20;
+  size_t numBlocks =
+      std::max<size_t>(1, (in.size() + blockSize - 1) / blockSize);
+  std::vector<std::vector<uint8_t>> blocks(numBlocks);
+  std::vector<uLong> checksums(numBlocks);
+  std::atomic<bool> success(true);
+  parallel_for(size_t(0), numBlocks, [&](size_t i) {
+    ArrayRef<uint8_t> block = in.slice(
+        i * blockSize, std::min(blockSize, in.size() - i * blockSize));
+    bool isLast = (i + 1 == numBlocks);
+    z_stream stream;
+    std::memset(&stream, 0, sizeof(stream));
+    // Negative window bits: raw deflate, without zlib header and trailer.
+    if (deflateInit2(&stream, Z_DEFAULT_COMPRESSION, Z_DEFLATED, -15, 8,
+                     Z_DEFAULT_STRATEGY) != Z_OK) {
+      success = false;
+      return;
+    }
+    // deflateBound() does not account for the empty stored block that ends
+    // a sync flush.
+    std::vector<uint8_t> &result = blocks[i];
+    result.resize(deflateBound(&stream, block.size()) + 16);
+    stream.next_in = const_cast<uint8_t *>(block.data());
+    stream.avail_in = block.size();
+    stream.next_out = result.data();
+    stream.avail_out = result.size();
+    int ret = deflate(&stream, isLast ? Z_FINISH : Z_SYNC_FLUSH);
+    if (isLast ? ret != Z_STREAM_END
+               : ret != Z_OK || stream.avail_in || !stream.avail_out)
+      success = false;
+    result.resize(result.size() - stream.avail_out);
+    deflateEnd(&stream);
+    checksums[i] = adler32(adler32(0, Z_NULL, 0), block.data(), block.size());
+  });
+  if (!success)
+    return false;
+
+  uLong checksum = checksums[0];
+  for (size_t i = 1; i < numBlocks; ++i) {
+    size_t len = std::min(blockSize, in.size() - i * blockSize);
+    checksum = adler32_combine(checksum, checksums[i], len);
+  }
+  // CMF (deflate, 32K window) and FLG (default level, no dictionary).
+  out.push_back(0x78);
+  out.push_back(0x9c);
+  for (const std::vector<uint8_t> &block : blocks)
+    out.insert(out.end(), block.begin(), block.end());
+  for (int shift = 24; shift >= 0; shift -= 8)
+    out.push_back((checksum >> shift) & 0xff);
+  return true;
+}
+#else
+bool zlibCompress(ArrayRef<uint8_t> in, std::vector<uint8_t> &out) {
+  return false;
+}
+#endif
+
+} // end namespace elf
+} // end namespace lld
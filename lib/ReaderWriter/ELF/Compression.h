@@ -0,0 +1,36 @@
+//===- lib/ReaderWriter/ELF/Compression.h ---------------------------------===//
+//
+//                             The LLVM Linker
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLD_READER_WRITER_ELF_COMPRESSION_H
+#define LLD_READER_WRITER_ELF_COMPRESSION_H
+
+#include "lld/Core/LLVM.h"
+#include "llvm/ADT/ArrayRef.h"
+#include <cstdint>
+#include <vector>
+
+namespace lld {
+namespace elf {
+
+/// \brief Appends a zlib stream of \p in to \p out, for the contents of
+/// sections compressed by --compress-debug-sections=zlib.
+///
+/// The input is cut into blocks that are deflated independently and in
+/// parallel. Every block but the last ends with a sync flush, which aligns
+/// it to a byte boundary without ending the stream, so that the blocks can
+/// be concatenated. The Adler-32 checksums of the blocks are combined into
+/// the one of the whole input.
+///
+/// Returns false if zlib fails, or if lld was built without zlib.
+bool zlibCompress(ArrayRef<uint8_t> in, std::vector<uint8_t> &out);
+
+} // end namespace elf
+} // end namespace lld
+
+#endif
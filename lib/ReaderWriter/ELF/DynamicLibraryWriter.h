@@ -39,17 +39,19 @@ void DynamicLibraryWriter<ELFT>::buildDynamicSymbolTable(const File &file) {
   // Add all the defined symbols to the dynamic symbol table
   // we need hooks into the Atom to find out which atoms need
   // to be exported
+  std::vector<typename SymbolTable<ELFT>::PendingSymbol> symbols;
   for (auto sec : this->_layout.sections())
     if (auto section = dyn_cast<AtomSection<ELFT>>(sec))
       for (const auto &atom : section->atoms()) {
         const DefinedAtom *da = dyn_cast<const DefinedAtom>(atom->_atom);
         if (da && (da->scope() == DefinedAtom::scopeGlobal))
-          this->_dynamicSymbolTable->addSymbol(atom->_atom, section->ordinal(),
-                                               atom->_virtualAddr, atom);
+          symbols.emplace_back(atom->_atom, section->ordinal(),
+                               atom->_virtualAddr, atom);
       }
 
   for (const UndefinedAtom *a : file.undefined())
-    this->_dynamicSymbolTable->addSymbol(a, ELF::SHN_UNDEF);
+    symbols.emplace_back(a, ELF::SHN_UNDEF);
+  this->_dynamicSymbolTable->addSymbols(symbols);
 
   OutputELFWriter<ELFT>::buildDynamicSymbolTable(file);
 }
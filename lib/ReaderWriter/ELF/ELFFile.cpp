@@ -36,32 +36,56 @@ std::error_code ELFFile<ELFT>::isCompatible(MemoryBufferRef mb,
 template <typename ELFT>
 Atom *ELFFile<ELFT>::findAtom(const Elf_Sym *sourceSym,
                               const Elf_Sym *targetSym) {
+  bool redirect;
+  Atom *target = findLocalAtom(sourceSym, targetSym, redirect);
+  if (!redirect)
+    return target;
+  // Otherwise, create a new undefined symbol and returns it.
+  return getUndefinedAtomForGroupChild(target->name());
+}
+
+template <typename ELFT>
+Atom *ELFFile<ELFT>::findLocalAtom(const Elf_Sym *sourceSym,
+                                   const Elf_Sym *targetSym, bool &redirect) {
+  redirect = false;
   // Return the atom for targetSym if we can do so.
-  Atom *target = _symbolToAtomMapping.lookup(targetSym);
+  Atom *target = lookupAtom(targetSym);
   if (!target)
     // Some realocations (R_ARM_V4BX) do not have a defined
     // target.  For this cases make it points to itself.
-    target = _symbolToAtomMapping.lookup(sourceSym);
+    target = lookupAtom(sourceSym);
 
   if (target->definition() != Atom::definitionRegular)
     return target;
   Atom::Scope scope = llvm::cast<DefinedAtom>(target)->scope();
   if (scope == DefinedAtom::scopeTranslationUnit)
     return target;
-  if (!redirectReferenceUsingUndefAtom(sourceSym, targetSym))
-    return target;
+  redirect = redirectReferenceUsingUndefAtom(sourceSym, targetSym);
+  return target;
+}
 
-  // Otherwise, create a new undefined symbol and returns it.
-  StringRef targetName = target->name();
-  auto it = _undefAtomsForGroupChild.find(targetName);
+template <typename ELFT>
+Atom *ELFFile<ELFT>::getUndefinedAtomForGroupChild(StringRef name) {
+  auto it = _undefAtomsForGroupChild.find(name);
   if (it != _undefAtomsForGroupChild.end())
     return it->getValue();
-  auto atom = new (_readerStorage) SimpleUndefinedAtom(*this, targetName);
-  _undefAtomsForGroupChild[targetName] = atom;
+  auto atom = new (_readerStorage) SimpleUndefinedAtom(*this, name);
+  _undefAtomsForGroupChild[name] = atom;
   addAtom(*atom);
   return atom;
 }
 
+template <typename ELFT>
+Atom *ELFFile<ELFT>::lookupAtom(const Elf_Sym *symbol) {
+  if (Atom *atom = _symbolToAtomMapping.lookup(symbol))
+    return atom;
+  auto it = _groupMemberSections.find(_objFile->getSection(symbol));
+  if (it == _groupMemberSections.end() || it->second._loaded)
+    return nullptr;
+  loadGroupMemberSection(it->second);
+  return _symbolToAtomMapping.lookup(symbol);
+}
+
 template <typename ELFT>
 ErrorOr<StringRef> ELFFile<ELFT>::getSectionName(const Elf_Shdr *shdr) const {
   if (!shdr)
@@ -145,6 +169,8 @@ std::error_code ELFFile<ELFT>::createAtomizableSections() {
 
       _relocationAddendReferences[sHdr] = make_range(rai, rae);
       totalRelocs += std::distance(rai, rae);
+      if (rai != rae)
+        buildRelocationIndex(make_range(rai, rae), _relaIndex[&*rai]);
     } else if (section.sh_type == llvm::ELF::SHT_REL) {
       auto sHdr = _objFile->getSection(section.sh_info);
 
@@ -157,6 +183,8 @@ std::error_code ELFFile<ELFT>::createAtomizableSections() {
 
       _relocationReferences[sHdr] = make_range(ri, re);
       totalRelocs += std::distance(ri, re);
+      if (ri != re)
+        buildRelocationIndex(make_range(ri, re), _relIndex[&*ri]);
     } else {
       _sectionSymbols[&section];
     }
@@ -201,7 +229,7 @@ template <class ELFT> std::error_code ELFFile<ELFT>::createMergeableAtoms() {
                                                   content, tai->_offset);
     atom->setOrdinal(++_ordinal);
     addAtom(*atom);
-    _mergeAtoms.push_back(atom);
+    _mergeAtoms[tai->_shdr].push_back(atom);
   }
   return std::error_code();
 }
@@ -257,11 +285,6 @@ std::error_code ELFFile<ELFT>::createSymbolsFromAtomizableSections() {
 }
 
 template <class ELFT> std::error_code ELFFile<ELFT>::createAtoms() {
-  // Holds all the atoms that are part of the section. They are the targets of
-  // the kindGroupChild reference.
-  llvm::StringMap<std::vector<ELFDefinedAtom<ELFT> *>> atomsForSection;
-
-  // Contains a list of comdat sections for a group.
   for (auto &i : _sectionSymbols) {
     const Elf_Shdr *section = i.first;
     std::vector<Elf_Sym_Iter> &symbols = i.second;
@@ -284,176 +307,293 @@ template <class ELFT> std::error_code ELFFile<ELFT>::createAtoms() {
     if (isGroupSection(section))
       continue;
 
-    bool addAtoms = (!isGnuLinkOnceSection(*sectionName) &&
-                     !isSectionMemberOfGroup(section));
-
-    if (handleSectionWithNoSymbols(section, symbols)) {
-      ELFDefinedAtom<ELFT> *newAtom =
-          createSectionAtom(section, *sectionName, *sectionContents);
-      newAtom->setOrdinal(++_ordinal);
-      if (addAtoms)
-        addAtom(*newAtom);
-      else
-        atomsForSection[*sectionName].push_back(newAtom);
+    if (!isGnuLinkOnceSection(*sectionName) &&
+        !isSectionMemberOfGroup(section)) {
+      std::vector<ELFDefinedAtom<ELFT> *> atoms;
+      if (std::error_code ec =
+              createAtomsForSection(section, *sectionName, *sectionContents,
+                                    symbols, true, _ordinal, atoms))
+        return ec;
+      for (ELFDefinedAtom<ELFT> *atom : atoms)
+        addAtom(*atom);
       continue;
     }
 
-    ELFDefinedAtom<ELFT> *previousAtom = nullptr;
-    ELFReference<ELFT> *anonFollowedBy = nullptr;
-
-    for (auto si = symbols.begin(), se = symbols.end(); si != se; ++si) {
-      auto symbol = *si;
-      StringRef symbolName = "";
+    // The atoms of a group member are the children of the group atom
+    // instead. Most groups are not selected by the resolver, because other
+    // files have the same groups, so only the symbols are read here. The
+    // ordinals of the atoms are reserved now to keep them in file order.
+    GroupMemberSection &member = _groupMemberSections[section];
+    member._section = section;
+    member._sectionName = *sectionName;
+    member._contents = *sectionContents;
+    member._symbols = symbols;
+    member._group = std::make_pair(StringRef(), nullptr);
+    member._ordinal = _ordinal;
+    member._loaded = isMergeableStringSection(section);
+    if (member._loaded) {
+      if (std::error_code ec = createAtomsForSection(
+              section, *sectionName, *sectionContents, symbols, true, _ordinal,
+              member._atoms))
+        return ec;
+      continue;
+    }
+    _ordinal += 2 * symbols.size() + 1;
+    for (Elf_Sym_Iter symbol : symbols) {
+      StringRef symbolName;
       if (symbol->getType() != llvm::ELF::STT_SECTION) {
         auto symName = _objFile->getSymbolName(symbol);
         if (std::error_code ec = symName.getError())
           return ec;
         symbolName = *symName;
       }
+      _groupMemberSymbols[&*symbol] = symbolName;
+    }
+  }
 
-      uint64_t contentSize = symbolContentSize(
-          section, &*symbol, (si + 1 == se) ? nullptr : &**(si + 1));
-
-      // Check to see if we need to add the FollowOn Reference
-      ELFReference<ELFT> *followOn = nullptr;
-      if (previousAtom) {
-        // Replace the followon atom with the anonymous atom that we created,
-        // so that the next symbol that we create is a followon from the
-        // anonymous atom.
-        if (anonFollowedBy) {
-          followOn = anonFollowedBy;
-        } else {
-          followOn = new (_readerStorage)
-              ELFReference<ELFT>(Reference::kindLayoutAfter);
-          previousAtom->addReference(followOn);
-        }
+  for (auto &i : _sectionSymbols)
+    if (std::error_code ec = handleSectionGroup(i.first))
+      return ec;
+  for (auto &i : _sectionSymbols)
+    if (std::error_code ec = handleGnuLinkOnceSection(i.first))
+      return ec;
+
+  updateReferences();
+  return std::error_code();
+}
+
+template <class ELFT>
+std::error_code ELFFile<ELFT>::createAtomsForSection(
+    const Elf_Shdr *section, StringRef sectionName,
+    ArrayRef<uint8_t> sectionContents, std::vector<Elf_Sym_Iter> &symbols,
+    bool assignRelocations, int64_t &ordinal,
+    std::vector<ELFDefinedAtom<ELFT> *> &atoms) {
+  auto createAtom = [&](StringRef name, const Elf_Sym *symbol,
+                        ArrayRef<uint8_t> content) {
+    if (assignRelocations)
+      return createDefinedAtomAndAssignRelocations(
+          name, sectionName, symbol, section, content, sectionContents);
+    return createDefinedAtom(name, sectionName, symbol, section, content,
+                             _references.size(), _references.size(),
+                             _references);
+  };
+
+  if (handleSectionWithNoSymbols(section, symbols)) {
+    ELFDefinedAtom<ELFT> *newAtom =
+        createAtom("", createSectionSymbol(), sectionContents);
+    newAtom->setOrdinal(++ordinal);
+    atoms.push_back(newAtom);
+    return std::error_code();
+  }
+
+  ELFDefinedAtom<ELFT> *previousAtom = nullptr;
+  ELFReference<ELFT> *anonFollowedBy = nullptr;
+
+  for (auto si = symbols.begin(), se = symbols.end(); si != se; ++si) {
+    auto symbol = *si;
+    StringRef symbolName = "";
+    if (symbol->getType() != llvm::ELF::STT_SECTION) {
+      auto symName = _objFile->getSymbolName(symbol);
+      if (std::error_code ec = symName.getError())
+        return ec;
+      symbolName = *symName;
+    }
+
+    uint64_t contentSize = symbolContentSize(
+        section, &*symbol, (si + 1 == se) ? nullptr : &**(si + 1));
+
+    // Check to see if we need to add the FollowOn Reference
+    ELFReference<ELFT> *followOn = nullptr;
+    if (previousAtom) {
+      // Replace the followon atom with the anonymous atom that we created,
+      // so that the next symbol that we create is a followon from the
+      // anonymous atom.
+      if (anonFollowedBy) {
+        followOn = anonFollowedBy;
+      } else {
+        followOn = new (_readerStorage)
+            ELFReference<ELFT>(Reference::kindLayoutAfter);
+        previousAtom->addReference(followOn);
       }
+    }
 
-      ArrayRef<uint8_t> symbolData((const uint8_t *)sectionContents->data() +
-                                       getSymbolValue(&*symbol),
-                                   contentSize);
-
-      // If the linker finds that a section has global atoms that are in a
-      // mergeable section, treat them as defined atoms as they shouldn't be
-      // merged away as well as these symbols have to be part of symbol
-      // resolution
-      if (isMergeableStringSection(section)) {
-        if (symbol->getBinding() != llvm::ELF::STB_GLOBAL)
-          continue;
-        ELFDefinedAtom<ELFT> *atom = createDefinedAtom(
-            symbolName, *sectionName, &**si, section, symbolData,
-            _references.size(), _references.size(), _references);
-        atom->setOrdinal(++_ordinal);
-        if (addAtoms)
-          addAtom(*atom);
-        else
-          atomsForSection[*sectionName].push_back(atom);
+    ArrayRef<uint8_t> symbolData((const uint8_t *)sectionContents.data() +
+                                     getSymbolValue(&*symbol),
+                                 contentSize);
+
+    // If the linker finds that a section has global atoms that are in a
+    // mergeable section, treat them as defined atoms as they shouldn't be
+    // merged away as well as these symbols have to be part of symbol
+    // resolution
+    if (isMergeableStringSection(section)) {
+      if (symbol->getBinding() != llvm::ELF::STB_GLOBAL)
         continue;
-      }
+      ELFDefinedAtom<ELFT> *atom = createDefinedAtom(
+          symbolName, sectionName, &**si, section, symbolData,
+          _references.size(), _references.size(), _references);
+      atom->setOrdinal(++ordinal);
+      atoms.push_back(atom);
+      continue;
+    }
 
-      // Don't allocate content to a weak symbol, as they may be merged away.
-      // Create an anonymous atom to hold the data.
-      ELFDefinedAtom<ELFT> *anonAtom = nullptr;
-      anonFollowedBy = nullptr;
-      if (symbol->getBinding() == llvm::ELF::STB_WEAK) {
-        // Create anonymous new non-weak ELF symbol that holds the symbol
-        // data.
-        auto sym = new (_readerStorage) Elf_Sym(*symbol);
-        sym->setBinding(llvm::ELF::STB_GLOBAL);
-        anonAtom = createDefinedAtomAndAssignRelocations(
-            "", *sectionName, sym, section, symbolData, *sectionContents);
-        symbolData = ArrayRef<uint8_t>();
-
-        // If this is the last atom, let's not create a followon reference.
-        if (anonAtom && (si + 1) != se) {
-          anonFollowedBy = new (_readerStorage)
-              ELFReference<ELFT>(Reference::kindLayoutAfter);
-          anonAtom->addReference(anonFollowedBy);
-        }
+    // Don't allocate content to a weak symbol, as they may be merged away.
+    // Create an anonymous atom to hold the data.
+    ELFDefinedAtom<ELFT> *anonAtom = nullptr;
+    anonFollowedBy = nullptr;
+    if (symbol->getBinding() == llvm::ELF::STB_WEAK) {
+      // Create anonymous new non-weak ELF symbol that holds the symbol
+      // data.
+      auto sym = new (_readerStorage) Elf_Sym(*symbol);
+      sym->setBinding(llvm::ELF::STB_GLOBAL);
+      anonAtom = createAtom("", sym, symbolData);
+      symbolData = ArrayRef<uint8_t>();
+
+      // If this is the last atom, let's not create a followon reference.
+      if (anonAtom && (si + 1) != se) {
+        anonFollowedBy = new (_readerStorage)
+            ELFReference<ELFT>(Reference::kindLayoutAfter);
+        anonAtom->addReference(anonFollowedBy);
       }
+    }
 
-      ELFDefinedAtom<ELFT> *newAtom = createDefinedAtomAndAssignRelocations(
-          symbolName, *sectionName, &*symbol, section, symbolData,
-          *sectionContents);
-      newAtom->setOrdinal(++_ordinal);
+    ELFDefinedAtom<ELFT> *newAtom =
+        createAtom(symbolName, &*symbol, symbolData);
+    newAtom->setOrdinal(++ordinal);
 
-      // If the atom was a weak symbol, let's create a followon reference to
-      // the anonymous atom that we created.
-      if (anonAtom)
-        createEdge(newAtom, anonAtom, Reference::kindLayoutAfter);
+    // If the atom was a weak symbol, let's create a followon reference to
+    // the anonymous atom that we created.
+    if (anonAtom)
+      createEdge(newAtom, anonAtom, Reference::kindLayoutAfter);
 
-      if (previousAtom) {
-        // Set the followon atom to the weak atom that we have created, so
-        // that they would alias when the file gets written.
-        followOn->setTarget(anonAtom ? anonAtom : newAtom);
-      }
+    if (previousAtom) {
+      // Set the followon atom to the weak atom that we have created, so
+      // that they would alias when the file gets written.
+      followOn->setTarget(anonAtom ? anonAtom : newAtom);
+    }
 
-      // The previous atom is always the atom created before unless the atom
-      // is a weak atom.
-      previousAtom = anonAtom ? anonAtom : newAtom;
-
-      if (addAtoms)
-        addAtom(*newAtom);
-      else
-        atomsForSection[*sectionName].push_back(newAtom);
-
-      _symbolToAtomMapping.insert(std::make_pair(&*symbol, newAtom));
-      if (anonAtom) {
-        anonAtom->setOrdinal(++_ordinal);
-        if (addAtoms)
-          addAtom(*anonAtom);
-        else
-          atomsForSection[*sectionName].push_back(anonAtom);
-      }
+    // The previous atom is always the atom created before unless the atom
+    // is a weak atom.
+    previousAtom = anonAtom ? anonAtom : newAtom;
+
+    atoms.push_back(newAtom);
+    _symbolToAtomMapping.insert(std::make_pair(&*symbol, newAtom));
+    if (anonAtom) {
+      anonAtom->setOrdinal(++ordinal);
+      atoms.push_back(anonAtom);
     }
   }
+  return std::error_code();
+}
 
-  for (auto &i : _sectionSymbols)
-    if (std::error_code ec = handleSectionGroup(i.first, atomsForSection))
-      return ec;
-  for (auto &i : _sectionSymbols)
-    if (std::error_code ec = handleGnuLinkOnceSection(i.first, atomsForSection))
-      return ec;
+template <class ELFT>
+void ELFFile<ELFT>::loadGroupMemberSection(GroupMemberSection &member) {
+  int64_t ordinal = member._ordinal;
+  std::error_code ec = createAtomsForSection(
+      member._section, member._sectionName, member._contents, member._symbols,
+      false, ordinal, member._atoms);
+  assert(!ec && "the symbol names were read by createAtoms()");
+  (void)ec;
+  for (ELFDefinedAtom<ELFT> *atom : member._atoms)
+    if (member._group.second)
+      _groupChild[atom->symbol()] = member._group;
+  member._loaded = true;
+}
 
-  updateReferences();
-  return std::error_code();
+template <class ELFT>
+void ELFFile<ELFT>::loadGroupMembers(const DefinedAtom &group) {
+  auto it = _sectionGroups.find(&group);
+  if (it == _sectionGroups.end())
+    return;
+  SectionGroup &sectionGroup = it->second;
+  std::vector<ELFReference<ELFT> *> refs;
+  for (GroupMemberSection *member : sectionGroup._members) {
+    if (!member->_loaded) {
+      loadGroupMemberSection(*member);
+      _loadedGroupMemberSections.push_back(member);
+    }
+    for (ELFDefinedAtom<ELFT> *atom : member->_atoms) {
+      ELFReference<ELFT> *ref =
+          new (_readerStorage) ELFReference<ELFT>(Reference::kindGroupChild);
+      ref->setTarget(atom);
+      refs.push_back(ref);
+    }
+  }
+  unsigned int referenceStart = _references.size();
+  _references.insert(_references.end(), refs.begin(), refs.end());
+  sectionGroup._atom->setReferenceRange(referenceStart, _references.size());
+}
+
+template <class ELFT>
+void ELFFile<ELFT>::finishGroupMembers(
+    const std::function<const Atom *(StringRef)> &resolve) {
+  // Read the relocations of the selected members. The references of an atom
+  // have to be contiguous, so its layout references are moved after them.
+  unsigned int begin = _references.size();
+  for (GroupMemberSection *member : _loadedGroupMemberSections) {
+    for (ELFDefinedAtom<ELFT> *atom : member->_atoms) {
+      unsigned int referenceStart = _references.size();
+      createReferencesForSymbol(atom->symbol(), member->_section,
+                                atom->rawContent(), member->_contents);
+      for (unsigned int i = atom->referenceStartIndex(),
+                        e = atom->referenceEndIndex();
+           i != e; ++i) {
+        ELFReference<ELFT> *ref = _references[i];
+        _references.push_back(ref);
+      }
+      atom->setReferenceRange(referenceStart, _references.size());
+    }
+  }
+  _loadedGroupMemberSections.clear();
+
+  // Bind the new references. A reference that findAtom() would redirect
+  // through an undefined atom is bound to what the name resolved to, as the
+  // resolver is done with undefined atoms.
+  auto bind = [&](ELFReference<ELFT> *ref, const Elf_Sym *symbol) {
+    bool redirect;
+    Atom *target = findLocalAtom(findSymbolForReference(ref), symbol, redirect);
+    if (redirect)
+      if (const Atom *atom = resolve(target->name())) {
+        ref->setTarget(atom);
+        return;
+      }
+    ref->setTarget(target);
+  };
+  for (unsigned int i = begin, e = _references.size(); i != e; ++i) {
+    ELFReference<ELFT> *ref = _references[i];
+    if (ref->kindNamespace() != Reference::KindNamespace::ELF)
+      continue;
+    const Elf_Sym *symbol = _objFile->getSymbol(ref->targetSymbolIndex());
+    const Elf_Shdr *shdr = _objFile->getSection(symbol);
+    if (isMergeableStringSection(shdr))
+      updateReferenceForMergeStringAccess(ref, symbol, shdr);
+    else
+      bind(ref, symbol);
+  }
+  for (ELFReference<ELFT> *ref : _pendingReferences)
+    bind(ref, _objFile->getSymbol(ref->targetSymbolIndex()));
+  _pendingReferences.clear();
 }
 
 template <class ELFT>
-std::error_code ELFFile<ELFT>::handleGnuLinkOnceSection(
-    const Elf_Shdr *section,
-    llvm::StringMap<std::vector<ELFDefinedAtom<ELFT> *>> &atomsForSection) {
+std::error_code
+ELFFile<ELFT>::handleGnuLinkOnceSection(const Elf_Shdr *section) {
   ErrorOr<StringRef> sectionName = this->getSectionName(section);
   if (std::error_code ec = sectionName.getError())
     return ec;
   if (!isGnuLinkOnceSection(*sectionName))
     return std::error_code();
 
-  unsigned int referenceStart = _references.size();
-  std::vector<ELFReference<ELFT> *> refs;
-  for (auto ha : atomsForSection[*sectionName]) {
-    _groupChild[ha->symbol()] = std::make_pair(*sectionName, section);
-    ELFReference<ELFT> *ref =
-        new (_readerStorage) ELFReference<ELFT>(Reference::kindGroupChild);
-    ref->setTarget(ha);
-    refs.push_back(ref);
-  }
-  atomsForSection[*sectionName].clear();
-  // Create a gnu linkonce atom.
-  ELFDefinedAtom<ELFT> *atom = createDefinedAtom(
-      *sectionName, *sectionName, nullptr, section, ArrayRef<uint8_t>(),
-      referenceStart, _references.size(), _references);
-  atom->setOrdinal(++_ordinal);
-  addAtom(*atom);
-  for (auto reference : refs)
-    atom->addReference(reference);
+  // A .gnu.linkonce section is a group by itself, named after the section.
+  auto member = _groupMemberSections.find(section);
+  if (member == _groupMemberSections.end())
+    return std::error_code();
+  createSectionGroup(*sectionName, *sectionName, section,
+                     std::vector<GroupMemberSection *>(1, &member->second));
   return std::error_code();
 }
 
 template <class ELFT>
-std::error_code ELFFile<ELFT>::handleSectionGroup(
-    const Elf_Shdr *section,
-    llvm::StringMap<std::vector<ELFDefinedAtom<ELFT> *>> &atomsForSection) {
+std::error_code ELFFile<ELFT>::handleSectionGroup(const Elf_Shdr *section) {
   ErrorOr<StringRef> sectionName = this->getSectionName(section);
   if (std::error_code ec = sectionName.getError())
     return ec;
@@ -473,7 +613,7 @@ std::error_code ELFFile<ELFT>::handleSectionGroup(
   // member contains the symbol table index of the identifying entry.
   // The sh_flags member of the section header contains 0. The name of
   // the section (sh_name) is not specified.
-  std::vector<StringRef> sectionNames;
+  std::vector<GroupMemberSection *> members;
   const Elf_Word *groupMembers =
       reinterpret_cast<const Elf_Word *>(sectionContents->data());
   const size_t count = section->sh_size / sizeof(Elf_Word);
@@ -482,7 +622,10 @@ std::error_code ELFFile<ELFT>::handleSectionGroup(
     ErrorOr<StringRef> sectionName = _objFile->getSectionName(shdr);
     if (std::error_code ec = sectionName.getError())
       return ec;
-    sectionNames.push_back(*sectionName);
+    // Relocation sections are members too, but have no atoms.
+    auto member = _groupMemberSections.find(shdr);
+    if (member != _groupMemberSections.end())
+      members.push_back(&member->second);
   }
   const Elf_Sym *symbol = _objFile->getSymbol(section->sh_info);
   const Elf_Shdr *symtab = _objFile->getSection(section->sh_link);
@@ -490,28 +633,34 @@ std::error_code ELFFile<ELFT>::handleSectionGroup(
   if (std::error_code ec = symbolName.getError())
     return ec;
 
-  unsigned int referenceStart = _references.size();
-  std::vector<ELFReference<ELFT> *> refs;
-  for (auto name : sectionNames) {
-    for (auto ha : atomsForSection[name]) {
-      _groupChild[ha->symbol()] = std::make_pair(*symbolName, section);
-      ELFReference<ELFT> *ref =
-          new (_readerStorage) ELFReference<ELFT>(Reference::kindGroupChild);
-      ref->setTarget(ha);
-      refs.push_back(ref);
-    }
-    atomsForSection[name].clear();
+  createSectionGroup(*symbolName, *sectionName, section, std::move(members));
+  return std::error_code();
+}
+
+template <class ELFT>
+void ELFFile<ELFT>::createSectionGroup(
+    StringRef signature, StringRef sectionName, const Elf_Shdr *section,
+    std::vector<GroupMemberSection *> members) {
+  // Register the symbols of the members as group children, so that
+  // references from outside the group are redirected by findAtom().
+  for (GroupMemberSection *member : members) {
+    member->_group = std::make_pair(signature, section);
+    for (Elf_Sym_Iter symbol : member->_symbols)
+      _groupChild[&*symbol] = member->_group;
+    for (ELFDefinedAtom<ELFT> *atom : member->_atoms)
+      _groupChild[atom->symbol()] = member->_group;
   }
 
-  // Create an atom for comdat signature.
+  // Create the group atom. Its kindGroupChild references are added by
+  // loadGroupMembers() if the resolver selects the group.
   ELFDefinedAtom<ELFT> *atom = createDefinedAtom(
-      *symbolName, *sectionName, nullptr, section, ArrayRef<uint8_t>(),
-      referenceStart, _references.size(), _references);
+      signature, sectionName, nullptr, section, ArrayRef<uint8_t>(),
+      _references.size(), _references.size(), _references);
   atom->setOrdinal(++_ordinal);
   addAtom(*atom);
-  for (auto reference : refs)
-    atom->addReference(reference);
-  return std::error_code();
+  SectionGroup &group = _sectionGroups[atom];
+  group._atom = atom;
+  group._members = std::move(members);
 }
 
 template <class ELFT> std::error_code ELFFile<ELFT>::createAtomsFromContext() {
@@ -552,7 +701,18 @@ ELFDefinedAtom<ELFT> *ELFFile<ELFT>::createDefinedAtomAndAssignRelocations(
     const Elf_Shdr *section, ArrayRef<uint8_t> symContent,
     ArrayRef<uint8_t> secContent) {
   unsigned int referenceStart = _references.size();
+  createReferencesForSymbol(symbol, section, symContent, secContent);
 
+  // Create the DefinedAtom and add it to the list of DefinedAtoms.
+  return createDefinedAtom(symbolName, sectionName, symbol, section, symContent,
+                           referenceStart, _references.size(), _references);
+}
+
+template <class ELFT>
+void ELFFile<ELFT>::createReferencesForSymbol(const Elf_Sym *symbol,
+                                              const Elf_Shdr *section,
+                                              ArrayRef<uint8_t> symContent,
+                                              ArrayRef<uint8_t> secContent) {
   // Add Rela (those with r_addend) references:
   auto rari = _relocationAddendReferences.find(section);
   if (rari != _relocationAddendReferences.end())
@@ -562,10 +722,6 @@ ELFDefinedAtom<ELFT> *ELFFile<ELFT>::createDefinedAtomAndAssignRelocations(
   auto rri = _relocationReferences.find(section);
   if (rri != _relocationReferences.end())
     createRelocationReferences(symbol, symContent, secContent, rri->second);
-
-  // Create the DefinedAtom and add it to the list of DefinedAtoms.
-  return createDefinedAtom(symbolName, sectionName, symbol, section, symContent,
-                           referenceStart, _references.size(), _references);
 }
 
 template <class ELFT>
@@ -574,15 +730,26 @@ void ELFFile<ELFT>::createRelocationReferences(const Elf_Sym *symbol,
                                                range<Elf_Rela_Iter> rels) {
   bool isMips64EL = _objFile->isMips64EL();
   const auto symValue = getSymbolValue(symbol);
-  for (const auto &rel : rels) {
+  auto add = [&](const Elf_Rela &rel) {
     if (rel.r_offset < symValue || symValue + content.size() <= rel.r_offset)
-      continue;
+      return;
     auto elfRelocation = new (_readerStorage)
         ELFReference<ELFT>(&rel, rel.r_offset - symValue, kindArch(),
                            rel.getType(isMips64EL), rel.getSymbol(isMips64EL));
     addReferenceToSymbol(elfRelocation, symbol);
     _references.push_back(elfRelocation);
+  };
+
+  auto index =
+      rels.empty() ? _relaIndex.end() : _relaIndex.find(&*rels.begin());
+  if (index == _relaIndex.end()) {
+    for (const auto &rel : rels)
+      add(rel);
+    return;
   }
+  for (const Elf_Rela *rel : getRelocationsInRange(
+           index->second, symValue, symValue + content.size()))
+    add(*rel);
 }
 
 template <class ELFT>
@@ -592,9 +759,9 @@ void ELFFile<ELFT>::createRelocationReferences(const Elf_Sym *symbol,
                                                range<Elf_Rel_Iter> rels) {
   bool isMips64EL = _objFile->isMips64EL();
   const auto symValue = getSymbolValue(symbol);
-  for (const auto &rel : rels) {
+  auto add = [&](const Elf_Rel &rel) {
     if (rel.r_offset < symValue || symValue + symContent.size() <= rel.r_offset)
-      continue;
+      return;
     auto elfRelocation = new (_readerStorage)
         ELFReference<ELFT>(rel.r_offset - symValue, kindArch(),
                            rel.getType(isMips64EL), rel.getSymbol(isMips64EL));
@@ -602,7 +769,17 @@ void ELFFile<ELFT>::createRelocationReferences(const Elf_Sym *symbol,
     elfRelocation->setAddend(addend);
     addReferenceToSymbol(elfRelocation, symbol);
     _references.push_back(elfRelocation);
+  };
+
+  auto index = rels.empty() ? _relIndex.end() : _relIndex.find(&*rels.begin());
+  if (index == _relIndex.end()) {
+    for (const auto &rel : rels)
+      add(rel);
+    return;
   }
+  for (const Elf_Rel *rel : getRelocationsInRange(
+           index->second, symValue, symValue + symContent.size()))
+    add(*rel);
 }
 
 template <class ELFT>
@@ -645,11 +822,29 @@ template <class ELFT> void ELFFile<ELFT>::updateReferences() {
     // simply that atom.
     if (isMergeableStringSection(shdr))
       updateReferenceForMergeStringAccess(ri, symbol, shdr);
+    else if (_groupMemberSymbols.count(symbol))
+      updateReferenceToGroupMember(ri, symbol);
     else
       ri->setTarget(findAtom(findSymbolForReference(ri), symbol));
   }
 }
 
+template <class ELFT>
+void ELFFile<ELFT>::updateReferenceToGroupMember(ELFReference<ELFT> *ref,
+                                                 const Elf_Sym *symbol) {
+  // A reference to a global symbol of a group goes through an undefined atom
+  // as findAtom() does, which needs only the name. Other references have to
+  // wait for the target atom.
+  bool isLocal = symbol->getBinding() == llvm::ELF::STB_LOCAL &&
+                 symbol->getVisibility() != llvm::ELF::STV_HIDDEN;
+  if (!isLocal &&
+      redirectReferenceUsingUndefAtom(findSymbolForReference(ref), symbol)) {
+    ref->setTarget(getUndefinedAtomForGroupChild(_groupMemberSymbols[symbol]));
+    return;
+  }
+  _pendingReferences.push_back(ref);
+}
+
 template <class ELFT>
 bool ELFFile<ELFT>::isIgnoredSection(const Elf_Shdr *section) {
   switch (section->sh_type) {
@@ -680,9 +875,7 @@ bool ELFFile<ELFT>::isMergeableStringSection(const Elf_Shdr *section) {
 }
 
 template <class ELFT>
-ELFDefinedAtom<ELFT> *
-ELFFile<ELFT>::createSectionAtom(const Elf_Shdr *section, StringRef sectionName,
-                                 ArrayRef<uint8_t> content) {
+typename ELFFile<ELFT>::Elf_Sym *ELFFile<ELFT>::createSectionSymbol() {
   Elf_Sym *sym = new (_readerStorage) Elf_Sym;
   sym->st_name = 0;
   sym->setBindingAndType(llvm::ELF::STB_LOCAL, llvm::ELF::STT_SECTION);
@@ -690,10 +883,7 @@ ELFFile<ELFT>::createSectionAtom(const Elf_Shdr *section, StringRef sectionName,
   sym->st_shndx = 0;
   sym->st_value = 0;
   sym->st_size = 0;
-  auto *newAtom = createDefinedAtomAndAssignRelocations(
-      "", sectionName, sym, section, content, content);
-  newAtom->setOrdinal(++_ordinal);
-  return newAtom;
+  return sym;
 }
 
 template <class ELFT>
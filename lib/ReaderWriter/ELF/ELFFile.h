@@ -71,14 +71,18 @@ template <class ELFT> class ELFFile : public SimpleFile {
 
   /// \brief find a merge atom given a offset
   ELFMergeAtom<ELFT> *findMergeAtom(const Elf_Shdr *shdr, int64_t offset) {
-    auto it = std::find_if(_mergeAtoms.begin(), _mergeAtoms.end(),
-                           [=](const ELFMergeAtom<ELFT> *a) {
-                             int64_t off = a->offset();
-                             return shdr->sh_name == a->section() &&
-                                    offset >= off &&
-                                    offset <= off + (int64_t)a->size();
-                           });
-    assert(it != _mergeAtoms.end());
+    // Merge atoms of a section are created in increasing offset order and
+    // cover the section contiguously, so the first atom whose end is not
+    // before the offset is the one containing it.
+    auto mi = _mergeAtoms.find(shdr);
+    assert(mi != _mergeAtoms.end());
+    const MergeAtomsT &atoms = mi->second;
+    auto it = std::lower_bound(
+        atoms.begin(), atoms.end(), offset,
+        [](const ELFMergeAtom<ELFT> *a, int64_t off) {
+          return (int64_t)(a->offset() + a->size()) < off;
+        });
+    assert(it != atoms.end() && offset >= (int64_t)(*it)->offset());
     return *it;
   }
 
@@ -118,6 +122,15 @@ public:
   /// \brief Create individual atoms
   std::error_code createAtoms();
 
+  /// \brief Create the atoms of the members of a selected section group or
+  /// .gnu.linkonce section, and make them the children of its group atom.
+  void loadGroupMembers(const DefinedAtom &group) override;
+
+  /// \brief Create the relocation references of the group members loaded
+  /// by loadGroupMembers() and of the references to them.
+  void finishGroupMembers(
+      const std::function<const Atom *(StringRef)> &resolve) override;
+
   // Assuming sourceSymbol has a reference to targetSym, find an atom
   // for targetSym. Usually it's just the atom for targetSym.
   // However, if an atom is in a section group, we may want to return an
@@ -128,11 +141,72 @@ public:
   Atom *findAtom(const Elf_Sym *sourceSym, const Elf_Sym *targetSym);
 
 protected:
+  /// A section that is a member of a section group, or a .gnu.linkonce
+  /// section. doParse() only registers the symbols it defines. Its atoms are
+  /// created when the resolver selects its group, or when the file refers to
+  /// a local symbol in it, and its relocations are read only in the former
+  /// case. Mergeable string sections are split eagerly, as they have no
+  /// relocations.
+  struct GroupMemberSection {
+    const Elf_Shdr *_section;
+    StringRef _sectionName;
+    ArrayRef<uint8_t> _contents;
+    /// The symbols defined in the section, sorted by value.
+    std::vector<Elf_Sym_Iter> _symbols;
+    /// The signature and the section of the group containing the section.
+    std::pair<StringRef, const Elf_Shdr *> _group;
+    /// The ordinals after this one are reserved for the atoms.
+    int64_t _ordinal;
+    bool _loaded;
+    std::vector<ELFDefinedAtom<ELFT> *> _atoms;
+  };
+
+  /// The group atom of a section group or of a .gnu.linkonce section, and
+  /// its member sections in the order they are listed.
+  struct SectionGroup {
+    ELFDefinedAtom<ELFT> *_atom;
+    std::vector<GroupMemberSection *> _members;
+  };
+
+  /// Creates the atoms for the symbols in a section, and appends them to
+  /// \p atoms in layout order. The relocation references are created only if
+  /// \p assignRelocations is true. \p ordinal is the last ordinal used.
+  std::error_code createAtomsForSection(
+      const Elf_Shdr *section, StringRef sectionName,
+      ArrayRef<uint8_t> sectionContents, std::vector<Elf_Sym_Iter> &symbols,
+      bool assignRelocations, int64_t &ordinal,
+      std::vector<ELFDefinedAtom<ELFT> *> &atoms);
+
+  /// Creates the atoms of a group member section without their relocation
+  /// references.
+  void loadGroupMemberSection(GroupMemberSection &member);
+
+  /// Returns the atom for a symbol, creating the atoms of its section if it
+  /// is a group member section that is not loaded yet. Returns null if the
+  /// symbol has no atom.
+  Atom *lookupAtom(const Elf_Sym *symbol);
+
+  /// Returns the atom for targetSym in this file, and sets \p redirect if the
+  /// references to it have to be resolved by name as findAtom() describes.
+  Atom *findLocalAtom(const Elf_Sym *sourceSym, const Elf_Sym *targetSym,
+                      bool &redirect);
+
+  /// Returns the undefined atom through which the references to the group
+  /// member \p name are resolved.
+  Atom *getUndefinedAtomForGroupChild(StringRef name);
+
   ELFDefinedAtom<ELFT> *createDefinedAtomAndAssignRelocations(
       StringRef symbolName, StringRef sectionName, const Elf_Sym *symbol,
       const Elf_Shdr *section, ArrayRef<uint8_t> symContent,
       ArrayRef<uint8_t> secContent);
 
+  /// \brief Create the references for the relocations of \p section that
+  /// apply to the contents of \p symbol.
+  void createReferencesForSymbol(const Elf_Sym *symbol,
+                                 const Elf_Shdr *section,
+                                 ArrayRef<uint8_t> symContent,
+                                 ArrayRef<uint8_t> secContent);
+
   std::error_code doParse() override;
 
   /// \brief Iterate over Elf_Rela relocations list and create references.
@@ -150,6 +224,11 @@ protected:
   /// Reference's target with the Atom pointer it refers to.
   void updateReferences();
 
+  /// \brief Update a reference from a section outside groups to a group
+  /// member section, whose atoms do not exist yet.
+  void updateReferenceToGroupMember(ELFReference<ELFT> *ref,
+                                    const Elf_Sym *symbol);
+
   /// \brief Update the reference if the access corresponds to a merge string
   /// section.
   void updateReferenceForMergeStringAccess(ELFReference<ELFT> *ref,
@@ -166,12 +245,9 @@ protected:
   /// the section into multiple atoms and mark them mergeByContent.
   bool isMergeableStringSection(const Elf_Shdr *section);
 
-  /// \brief Returns a new anonymous atom whose size is equal to the
-  /// section size. That atom will be used to represent the entire
-  /// section that have no symbols.
-  ELFDefinedAtom<ELFT> *createSectionAtom(const Elf_Shdr *section,
-                                          StringRef sectionName,
-                                          ArrayRef<uint8_t> contents);
+  /// \brief Returns a new local section symbol. The atom created for it
+  /// represents the entire contents of a section that have no symbols.
+  Elf_Sym *createSectionSymbol();
 
   /// Returns the symbol's content size. The nextSymbol should be null if the
   /// symbol is the last one in the section.
@@ -210,14 +286,16 @@ protected:
   }
 
   /// Handle creation of atoms for .gnu.linkonce sections.
-  std::error_code handleGnuLinkOnceSection(
-      const Elf_Shdr *section,
-      llvm::StringMap<std::vector<ELFDefinedAtom<ELFT> *>> &atomsForSection);
+  std::error_code handleGnuLinkOnceSection(const Elf_Shdr *section);
 
   // Handle COMDAT scetions.
-  std::error_code handleSectionGroup(
-      const Elf_Shdr *section,
-      llvm::StringMap<std::vector<ELFDefinedAtom<ELFT> *>> &atomsForSection);
+  std::error_code handleSectionGroup(const Elf_Shdr *section);
+
+  /// Creates the group atom for a section group or a .gnu.linkonce section
+  /// whose members are \p members.
+  void createSectionGroup(StringRef signature, StringRef sectionName,
+                          const Elf_Shdr *section,
+                          std::vector<GroupMemberSection *> members);
 
   /// Process the Undefined symbol and create an atom for it.
   ELFUndefinedAtom<ELFT> *createUndefinedAtom(StringRef symName,
@@ -327,6 +405,42 @@ protected:
   bool redirectReferenceUsingUndefAtom(const Elf_Sym *sourceSymbol,
                                        const Elf_Sym *targetSymbol) const;
 
+  /// The relocations of a section in file order, and whether they are sorted
+  /// by offset.
+  template <class RelT> struct RelocationIndex {
+    std::vector<const RelT *> _relocs;
+    bool _sortedByOffset;
+  };
+
+  template <class RelT, class IterT>
+  static void buildRelocationIndex(range<IterT> rels,
+                                   RelocationIndex<RelT> &index) {
+    for (const RelT &rel : rels)
+      index._relocs.push_back(&rel);
+    index._sortedByOffset = std::is_sorted(
+        index._relocs.begin(), index._relocs.end(),
+        [](const RelT *a, const RelT *b) { return a->r_offset < b->r_offset; });
+  }
+
+  /// Returns the relocations in \p index that may apply to [begin, end). If
+  /// the relocations are sorted by offset, as they almost always are, these
+  /// are found with a binary search and are exactly the ones in the range.
+  /// Otherwise all of them are returned and the caller has to filter them.
+  template <class RelT>
+  static ArrayRef<const RelT *>
+  getRelocationsInRange(const RelocationIndex<RelT> &index, uint64_t begin,
+                        uint64_t end) {
+    ArrayRef<const RelT *> relocs = index._relocs;
+    if (!index._sortedByOffset)
+      return relocs;
+    auto before = [](const RelT *rel, uint64_t offset) {
+      return rel->r_offset < offset;
+    };
+    auto lo = std::lower_bound(relocs.begin(), relocs.end(), begin, before);
+    auto hi = std::lower_bound(lo, relocs.end(), end, before);
+    return relocs.slice(lo - relocs.begin(), hi - lo);
+  }
+
   void addReferenceToSymbol(const ELFReference<ELFT> *r, const Elf_Sym *sym) {
     _referenceToSymbol[r] = sym;
   }
@@ -349,6 +463,11 @@ protected:
   _relocationAddendReferences;
   MergedSectionMapT _mergedSectionMap;
   std::unordered_map<const Elf_Shdr *, range<Elf_Rel_Iter>> _relocationReferences;
+  /// Indexes of the ranges above, keyed by the first relocation of the range.
+  /// createRelocationReferences() uses them to find the relocations of each
+  /// symbol without scanning all the relocations of its section.
+  llvm::DenseMap<const Elf_Rela *, RelocationIndex<Elf_Rela>> _relaIndex;
+  llvm::DenseMap<const Elf_Rel *, RelocationIndex<Elf_Rel>> _relIndex;
   std::vector<ELFReference<ELFT> *> _references;
   llvm::DenseMap<const Elf_Sym *, Atom *> _symbolToAtomMapping;
   llvm::DenseMap<const ELFReference<ELFT> *, const Elf_Sym *>
@@ -359,9 +478,24 @@ protected:
       _groupChild;
   llvm::StringMap<Atom *> _undefAtomsForGroupChild;
 
+  /// Group member sections, the names of the symbols defined in those whose
+  /// atoms are created lazily, and the section groups by their group atoms.
+  std::unordered_map<const Elf_Shdr *, GroupMemberSection>
+      _groupMemberSections;
+  llvm::DenseMap<const Elf_Sym *, StringRef> _groupMemberSymbols;
+  llvm::DenseMap<const DefinedAtom *, SectionGroup> _sectionGroups;
+
+  /// Group member sections loaded by loadGroupMembers() whose relocations
+  /// are not read yet.
+  std::vector<GroupMemberSection *> _loadedGroupMemberSections;
+
+  /// References to local symbols in group member sections, which are bound
+  /// by finishGroupMembers().
+  std::vector<ELFReference<ELFT> *> _pendingReferences;
+
   /// \brief Atoms that are created for a section that has the merge property
-  /// set
-  MergeAtomsT _mergeAtoms;
+  /// set, grouped by section and sorted by offset
+  llvm::DenseMap<const Elf_Shdr *, MergeAtomsT> _mergeAtoms;
 
   /// \brief the section and the symbols that are contained within it to create
   /// used to create atoms
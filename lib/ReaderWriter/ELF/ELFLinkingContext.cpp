@@ -11,6 +11,7 @@
 #include "ELFFile.h"
 #include "OrderPass.h"
 #include "TargetHandler.h"
+#include "lld/Core/ICF.h"
 #include "lld/Core/Instrumentation.h"
 #include "lld/Core/SharedLibraryFile.h"
 #include "llvm/ADT/STLExtras.h"
@@ -41,7 +42,11 @@ public:
 };
 
 void ELFLinkingContext::addPasses(PassManager &pm) {
-  pm.add(llvm::make_unique<elf::OrderPass>());
+  // A relocatable output is linked again, so its functions keep their own
+  // addresses.
+  if (icfMode() != ICFMode::None && getOutputELFType() != llvm::ELF::ET_REL)
+    pm.add(llvm::make_unique<ICFPass>(*this));
+  pm.add(llvm::make_unique<elf::OrderPass>(*this));
 }
 
 uint16_t ELFLinkingContext::getOutputMachine() const {
@@ -46,6 +46,7 @@ private:
 //===----------------------------------------------------------------------===//
 template<class ELFT>
 void ExecutableWriter<ELFT>::buildDynamicSymbolTable(const File &file) {
+  std::vector<typename SymbolTable<ELFT>::PendingSymbol> symbols;
   for (auto sec : this->_layout.sections())
     if (auto section = dyn_cast<AtomSection<ELFT>>(sec))
       for (const auto &atom : section->atoms()) {
@@ -57,8 +58,8 @@ void ExecutableWriter<ELFT>::buildDynamicSymbolTable(const File &file) {
             !(this->_ctx.shouldExportDynamic() &&
               da->scope() == Atom::Scope::scopeGlobal))
           continue;
-        this->_dynamicSymbolTable->addSymbol(atom->_atom, section->ordinal(),
-                                             atom->_virtualAddr, atom);
+        symbols.emplace_back(atom->_atom, section->ordinal(),
+                             atom->_virtualAddr, atom);
       }
 
   // Put weak symbols in the dynamic symbol table.
@@ -66,9 +67,10 @@ void ExecutableWriter<ELFT>::buildDynamicSymbolTable(const File &file) {
     for (const UndefinedAtom *a : file.undefined()) {
       if (this->_layout.isReferencedByDefinedAtom(a) &&
           a->canBeNull() != UndefinedAtom::canBeNullNever)
-        this->_dynamicSymbolTable->addSymbol(a, ELF::SHN_UNDEF);
+        symbols.emplace_back(a, ELF::SHN_UNDEF);
     }
   }
+  this->_dynamicSymbolTable->addSymbols(symbols);
 
   OutputELFWriter<ELFT>::buildDynamicSymbolTable(file);
 }
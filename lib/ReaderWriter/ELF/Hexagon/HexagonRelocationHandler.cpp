@@ -197,9 +197,9 @@ static void relocHexGOTREL_32(uint8_t *loc, uint64_t P, uint64_t S, uint64_t A,
 }
 
 std::error_code HexagonTargetRelocationHandler::applyRelocation(
-    ELFWriter &writer, llvm::FileOutputBuffer &buf, const AtomLayout &atom,
+    ELFWriter &writer, uint8_t *buf, const AtomLayout &atom,
     const Reference &ref) const {
-  uint8_t *atomContent = buf.getBufferStart() + atom._fileOffset;
+  uint8_t *atomContent = buf + atom._fileOffset;
   uint8_t *loc = atomContent + ref.offsetInAtom();
   uint64_t target = writer.addressOfAtom(ref.target());
   uint64_t reloc = atom._virtualAddr + ref.offsetInAtom();
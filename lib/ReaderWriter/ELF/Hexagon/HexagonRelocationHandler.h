@@ -21,7 +21,7 @@ public:
   HexagonTargetRelocationHandler(HexagonTargetLayout &layout)
       : _targetLayout(layout) {}
 
-  std::error_code applyRelocation(ELFWriter &, llvm::FileOutputBuffer &,
+  std::error_code applyRelocation(ELFWriter &, uint8_t *,
                                   const AtomLayout &,
                                   const Reference &) const override;
 
@@ -36,8 +36,7 @@ public:
   RelocationHandler(MipsLinkingContext &ctx, MipsTargetLayout<ELFT> &layout)
       : _ctx(ctx), _targetLayout(layout) {}
 
-  std::error_code applyRelocation(ELFWriter &writer,
-                                  llvm::FileOutputBuffer &buf,
+  std::error_code applyRelocation(ELFWriter &writer, uint8_t *buf,
                                   const AtomLayout &atom,
                                   const Reference &ref) const override;
 
@@ -574,7 +573,7 @@ static void relocWrite(uint64_t data, const MipsRelocationParams &params,
 
 template <class ELFT>
 std::error_code RelocationHandler<ELFT>::applyRelocation(
-    ELFWriter &writer, llvm::FileOutputBuffer &buf, const AtomLayout &atom,
+    ELFWriter &writer, uint8_t *buf, const AtomLayout &atom,
     const Reference &ref) const {
   if (ref.kindNamespace() != Reference::KindNamespace::ELF)
     return std::error_code();
@@ -583,7 +582,7 @@ std::error_code RelocationHandler<ELFT>::applyRelocation(
   uint64_t gpAddr = _targetLayout.getGPAddr();
   bool isGpDisp = ref.target()->name() == "_gp_disp";
 
-  uint8_t *atomContent = buf.getBufferStart() + atom._fileOffset;
+  uint8_t *atomContent = buf + atom._fileOffset;
   uint8_t *location = atomContent + ref.offsetInAtom();
   uint64_t tgtAddr = writer.addressOfAtom(ref.target());
   uint64_t relAddr = atom._virtualAddr + ref.offsetInAtom();
@@ -10,6 +10,7 @@
 #include "MipsELFFile.h"
 #include "MipsLinkingContext.h"
 #include "MipsRelocationPass.h"
+#include "ReferenceScan.h"
 #include "llvm/ADT/DenseSet.h"
 
 using namespace lld;
@@ -381,6 +382,15 @@ private:
   void collectReferenceInfo(const MipsELFDefinedAtom<ELFT> &atom,
                             Reference &ref);
 
+  /// \brief Returns false if collectReferenceInfo() would ignore the
+  /// reference. Called concurrently.
+  bool hasReferenceInfo(const MipsELFDefinedAtom<ELFT> &atom,
+                        const Reference &ref) const;
+
+  /// \brief Returns false if handleReference() would leave the reference
+  /// alone. Called concurrently.
+  bool mayNeedHandling(const Reference &ref) const;
+
   void handlePlain(const MipsELFDefinedAtom<ELFT> &atom, Reference &ref);
   void handle26(const MipsELFDefinedAtom<ELFT> &atom, Reference &ref);
   void handleGOT(Reference &ref);
@@ -425,16 +435,25 @@ RelocationPass<ELFT>::RelocationPass(MipsLinkingContext &ctx)
 
 template <typename ELFT>
 void RelocationPass<ELFT>::perform(std::unique_ptr<SimpleFile> &mf) {
-  for (const auto &atom : mf->defined())
-    for (const auto &ref : *atom)
-      collectReferenceInfo(*cast<MipsELFDefinedAtom<ELFT>>(atom),
-                           const_cast<Reference &>(*ref));
+  // Both walks over the references first drop, in parallel, the references
+  // they have nothing to do for. The remaining ones are processed serially
+  // in their original order, so the created atoms keep a stable order.
+  std::vector<AtomReference> infoRefs = scanReferences(
+      *mf, [this](const DefinedAtom &atom, const Reference &ref) {
+        return hasReferenceInfo(cast<MipsELFDefinedAtom<ELFT>>(atom), ref);
+      });
+  for (const AtomReference &ar : infoRefs)
+    collectReferenceInfo(*cast<MipsELFDefinedAtom<ELFT>>(ar.first),
+                         const_cast<Reference &>(*ar.second));
 
   // Process all references.
-  for (const auto &atom : mf->defined())
-    for (const auto &ref : *atom)
-      handleReference(*cast<MipsELFDefinedAtom<ELFT>>(atom),
-                      const_cast<Reference &>(*ref));
+  std::vector<AtomReference> refs = scanReferences(
+      *mf, [this](const DefinedAtom &, const Reference &ref) {
+        return mayNeedHandling(ref);
+      });
+  for (const AtomReference &ar : refs)
+    handleReference(*cast<MipsELFDefinedAtom<ELFT>>(ar.first),
+                    const_cast<Reference &>(*ar.second));
 
   // Create R_MIPS_REL32 relocations.
   for (auto *ref : _rel32Candidates) {
@@ -644,6 +663,45 @@ void RelocationPass<ELFT>::collectReferenceInfo(
     _requiresPtrEquality.insert(ref.target());
 }
 
+template <typename ELFT>
+bool RelocationPass<ELFT>::hasReferenceInfo(
+    const MipsELFDefinedAtom<ELFT> &atom, const Reference &ref) const {
+  if (!ref.target())
+    return false;
+  if (ref.kindNamespace() != Reference::KindNamespace::ELF)
+    return false;
+  if (ref.kindValue() == R_MIPS_EH && this->_ctx.mipsPcRelEhRel())
+    return true;
+  return isConstrainSym(atom, ref.kindValue());
+}
+
+template <typename ELFT>
+bool RelocationPass<ELFT>::mayNeedHandling(const Reference &ref) const {
+  if (!ref.target())
+    return false;
+  if (ref.kindNamespace() != Reference::KindNamespace::ELF)
+    return false;
+  switch (ref.kindValue()) {
+  case R_MIPS_32:
+  case R_MIPS_PC32:
+  case R_MIPS_HI16:
+  case R_MIPS_LO16:
+  case R_MIPS_PCHI16:
+  case R_MIPS_PCLO16:
+  case R_MICROMIPS_HI16:
+  case R_MICROMIPS_LO16:
+    // handlePlain() only acts on symbols which may be preempted.
+    return isDynamic(ref.target());
+  case R_MIPS_GOT_OFST:
+  case R_MICROMIPS_GOT_OFST:
+    return false;
+  default:
+    // Everything else is either handled by handleReference() or ignored by
+    // it cheaply.
+    return true;
+  }
+}
+
 template <typename ELFT>
 bool RelocationPass<ELFT>::isLocal(const Atom *a) const {
   if (auto *da = dyn_cast<DefinedAtom>(a))
@@ -10,19 +10,65 @@
 #ifndef LLD_READER_WRITER_ELF_ORDER_PASS_H
 #define LLD_READER_WRITER_ELF_ORDER_PASS_H
 
+#include "lld/Core/AtomOrder.h"
 #include "lld/Core/Parallel.h"
+#include "lld/ReaderWriter/ELFLinkingContext.h"
+#include "llvm/ADT/DenseMap.h"
 #include <limits>
 
 namespace lld {
 namespace elf {
 
-/// \brief This pass sorts atoms by file and atom ordinals.
+/// \brief This pass sorts atoms by file and atom ordinals. If a symbol
+/// ordering file was given, atoms defining the listed symbols come first.
+/// If a call graph profile was given, the functions it mentions follow, in
+/// the order computed by the profile.
 class OrderPass : public Pass {
 public:
+  explicit OrderPass(const ELFLinkingContext &ctx) : _ctx(ctx) {}
+
   void perform(std::unique_ptr<SimpleFile> &file) override {
-    parallel_sort(file->definedAtoms().begin(), file->definedAtoms().end(),
-                  DefinedAtom::compareByPosition);
+    SimpleFile::DefinedAtomRange atoms = file->definedAtoms();
+    parallel_sort(atoms.begin(), atoms.end(), DefinedAtom::compareByPosition);
+    if (_ctx.hasSymbolOrder() || !_ctx.callGraphProfile().empty())
+      applySymbolOrder(atoms);
   }
+
+private:
+  /// Moves the atoms of listed and profiled symbols to the front. Atoms of an
+  /// input section move as a whole; see orderLayoutChains.
+  void applySymbolOrder(SimpleFile::DefinedAtomRange atoms) {
+    const unsigned unordered = std::numeric_limits<unsigned>::max();
+    std::vector<const DefinedAtom *> sorted(atoms.begin(), atoms.end());
+    size_t numAtoms = sorted.size();
+
+    std::vector<unsigned> order(numAtoms, unordered);
+    parallel_for(size_t(0), numAtoms, [&](size_t i) {
+      StringRef name = sorted[i]->name();
+      if (!name.empty())
+        _ctx.findSymbolOrder(name, order[i]);
+    });
+
+    const CallGraphProfile &profile = _ctx.callGraphProfile();
+    if (!profile.empty()) {
+      llvm::DenseMap<const DefinedAtom *, unsigned> rank;
+      unsigned next = _ctx.numOrderedSymbols();
+      for (const DefinedAtom *atom : profile.sortAtoms(sorted))
+        rank[atom] = next++;
+      for (size_t i = 0; i != numAtoms; ++i) {
+        if (order[i] != unordered)
+          continue;
+        auto it = rank.find(sorted[i]);
+        if (it != rank.end())
+          order[i] = it->second;
+      }
+    }
+
+    orderLayoutChains(sorted, order);
+    std::copy(sorted.begin(), sorted.end(), atoms.begin());
+  }
+
+  const ELFLinkingContext &_ctx;
 };
 }
 }
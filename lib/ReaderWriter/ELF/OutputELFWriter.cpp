@@ -86,14 +86,18 @@ void OutputELFWriter<ELFT>::buildChunks(const File &file) {
 template <class ELFT>
 void OutputELFWriter<ELFT>::buildStaticSymbolTable(const File &file) {
   ScopedTask task(getDefaultDomain(), "buildStaticSymbolTable");
+  typedef typename SymbolTable<ELFT>::PendingSymbol PendingSymbol;
+  std::vector<PendingSymbol> symbols;
   for (auto sec : _layout.sections())
     if (auto section = dyn_cast<AtomSection<ELFT>>(sec))
       for (const auto &atom : section->atoms())
-        _symtab->addSymbol(atom->_atom, section->ordinal(), atom->_virtualAddr);
+        symbols.emplace_back(atom->_atom, section->ordinal(),
+                             atom->_virtualAddr);
   for (auto &atom : _layout.absoluteAtoms())
-    _symtab->addSymbol(atom->_atom, ELF::SHN_ABS, atom->_virtualAddr);
+    symbols.emplace_back(atom->_atom, ELF::SHN_ABS, atom->_virtualAddr);
   for (const UndefinedAtom *a : file.undefined())
-    _symtab->addSymbol(a, ELF::SHN_UNDEF);
+    symbols.emplace_back(a, ELF::SHN_UNDEF);
+  _symtab->addSymbols(symbols);
 }
 
 // Returns the DSO name for a given input file if it's a shared library
@@ -107,6 +111,15 @@ StringRef OutputELFWriter<ELFT>::maybeGetSOName(Node *node) {
   return "";
 }
 
+template <class ELFT> StringRef OutputELFWriter<ELFT>::getLibcSOName() {
+  for (const std::unique_ptr<Node> &node : _ctx.getNodes()) {
+    StringRef soname = maybeGetSOName(node.get());
+    if (soname.startswith("libc.so."))
+      return soname;
+  }
+  return "";
+}
+
 template <class ELFT>
 void OutputELFWriter<ELFT>::buildDynamicSymbolTable(const File &file) {
   ScopedTask task(getDefaultDomain(), "buildDynamicSymbolTable");
@@ -201,6 +214,25 @@ template <class ELFT> void OutputELFWriter<ELFT>::buildSectionHeaderTable() {
   }
 }
 
+template <class ELFT> void OutputELFWriter<ELFT>::compressDebugSections() {
+  ScopedTask task(getDefaultDomain(), "compressDebugSections");
+  bool compressed = false;
+  for (auto outputSection : _layout.outputSections()) {
+    if (!outputSection->name().startswith(".debug") ||
+        (outputSection->flags() & llvm::ELF::SHF_ALLOC))
+      continue;
+    // Sections are compressed one by one, so an output section made of
+    // several of them would get several compression headers.
+    auto sections = outputSection->sections();
+    if (std::distance(sections.begin(), sections.end()) != 1)
+      continue;
+    if (auto section = dyn_cast<AtomSection<ELFT>>(*sections.begin()))
+      compressed |= section->compress(this);
+  }
+  if (compressed)
+    _layout.reassignFileOffsets();
+}
+
 template <class ELFT>
 void OutputELFWriter<ELFT>::assignSectionsWithNoSegments() {
   ScopedTask task(getDefaultDomain(), "assignSectionsWithNoSegments");
@@ -302,6 +334,19 @@ template <class ELFT> void OutputELFWriter<ELFT>::createDefaultSections() {
     _dynamicSymbolTable->setStringSection(_dynamicStringTable.get());
     _dynamicTable->setSymbolTable(_dynamicSymbolTable.get());
     _dynamicTable->setHashTable(_hashTable.get());
+    // A glibc that cannot apply DT_RELR would run the output with its
+    // pointers unrelocated. Needing GLIBC_ABI_DT_RELR makes it refuse the
+    // output instead.
+    StringRef libc = _layout.hasRelrTable() ? getLibcSOName() : "";
+    if (!libc.empty()) {
+      _versionNeed.reset(new (_alloc) VersionNeedSection<ELFT>(
+          _ctx, ".gnu.version_r",
+          TargetLayout<ELFT>::ORDER_DYNAMIC_VERSION_NEED,
+          _dynamicStringTable.get()));
+      _versionNeed->addNeed(libc, "GLIBC_ABI_DT_RELR");
+      _layout.addSection(_versionNeed.get());
+      _dynamicTable->setVersionNeedSection(_versionNeed.get());
+    }
     if (_layout.hasDynamicRelocationTable())
       _layout.getDynamicRelocationTable()->setSymbolTable(
           _dynamicSymbolTable.get());
@@ -373,6 +418,11 @@ std::error_code OutputELFWriter<ELFT>::buildOutput(const File &file) {
   // Finalize the layout by calling the finalize() functions
   _layout.finalize();
 
+  // Relocations must be applied to the debug sections before they are
+  // compressed, so this comes once everything has an address.
+  if (_ctx.compressDebugSections())
+    compressDebugSections();
+
   // build Section Header table
   buildSectionHeaderTable();
 
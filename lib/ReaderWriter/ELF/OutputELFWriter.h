@@ -72,6 +72,10 @@ protected:
   // Build the section header table
   virtual void buildSectionHeaderTable();
 
+  // Compress the debug sections (--compress-debug-sections) and move the
+  // sections that follow them in the file
+  virtual void compressDebugSections();
+
   // Assign sections that have no segments such as the symbol table,
   // section header table, string table etc
   virtual void assignSectionsWithNoSegments();
@@ -139,11 +143,16 @@ protected:
   unique_bump_ptr<DynamicSymbolTable<ELFT>> _dynamicSymbolTable;
   unique_bump_ptr<StringTable<ELFT>> _dynamicStringTable;
   unique_bump_ptr<HashSection<ELFT>> _hashTable;
+  unique_bump_ptr<VersionNeedSection<ELFT>> _versionNeed;
   llvm::StringSet<> _soNeeded;
   /// @}
 
 private:
   static StringRef maybeGetSOName(Node *node);
+
+  /// \brief Returns the DT_NEEDED name of glibc's libc.so, or an empty
+  /// string if the output is not linked against it.
+  StringRef getLibcSOName();
 };
 
 } // namespace elf
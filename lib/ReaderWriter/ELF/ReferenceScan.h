@@ -0,0 +1,101 @@
+//===- lib/ReaderWriter/ELF/ReferenceScan.h -------------------------------===//
+//
+//                             The LLVM Linker
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLD_READER_WRITER_ELF_REFERENCE_SCAN_H
+#define LLD_READER_WRITER_ELF_REFERENCE_SCAN_H
+
+#include "lld/Core/DefinedAtom.h"
+#include "lld/Core/File.h"
+#include "lld/Core/Parallel.h"
+#include "lld/Core/SharedLibraryAtom.h"
+#include <utility>
+#include <vector>
+
+namespace lld {
+namespace elf {
+
+typedef std::pair<const DefinedAtom *, const Reference *> AtomReference;
+
+/// \brief Walk the references of all defined atoms in \p file in parallel and
+/// return the ones for which \p filter returns true, in the order a serial
+/// walk would have visited them.
+///
+/// Relocation passes use this to split their work in two: a parallel
+/// classification phase that drops the references which need no GOT, PLT or
+/// copy entry, and a serial phase that creates those entries in a stable
+/// order. \p filter is called concurrently. It may update the reference it is
+/// given, but must not touch any other state.
+template <class Filter>
+std::vector<AtomReference> scanReferences(const File &file, Filter filter) {
+  const File::AtomVector<DefinedAtom> &atoms = file.defined();
+  const size_t chunkSize = 256;
+  size_t numChunks = (atoms.size() + chunkSize - 1) / chunkSize;
+  std::vector<std::vector<AtomReference>> found(numChunks);
+  {
+    TaskGroup tg;
+    for (size_t chunk = 0; chunk != numChunks; ++chunk) {
+      tg.spawn([&, chunk] {
+        size_t end = std::min(atoms.size(), (chunk + 1) * chunkSize);
+        for (size_t i = chunk * chunkSize; i != end; ++i)
+          for (const Reference *ref : *atoms[i])
+            if (filter(*atoms[i], *ref))
+              found[chunk].push_back(std::make_pair(atoms[i], ref));
+      });
+    }
+    tg.sync();
+  }
+
+  std::vector<AtomReference> result;
+  size_t total = 0;
+  for (const std::vector<AtomReference> &refs : found)
+    total += refs.size();
+  result.reserve(total);
+  for (const std::vector<AtomReference> &refs : found)
+    result.insert(result.end(), refs.begin(), refs.end());
+  return result;
+}
+
+/// \brief Returns true if a plain data or branch relocation to \p target may
+/// have to be redirected to a PLT, IFUNC or copy-relocated entry. Relocations
+/// to ordinary defined atoms never are.
+inline bool mayRedirectPlainReference(const Atom *target) {
+  if (!target)
+    return false;
+  if (isa<SharedLibraryAtom>(target))
+    return true;
+  if (const auto *da = dyn_cast<DefinedAtom>(target))
+    return da->contentType() == DefinedAtom::typeResolver;
+  return false;
+}
+
+/// \brief Returns true if an absolute word relocation in \p atom to \p target
+/// can become a relative dynamic relocation in a position-independent output.
+/// The target has to be an ordinary atom defined in the link, which lld binds
+/// locally, and the word has to be writable, since no DT_TEXTREL is emitted
+/// for it.
+inline bool canUseRelativeReloc(const DefinedAtom &atom, const Atom *target) {
+  if ((atom.permissions() & DefinedAtom::permRW_) != DefinedAtom::permRW_)
+    return false;
+  const auto *da = dyn_cast_or_null<DefinedAtom>(target);
+  if (!da)
+    return false;
+  switch (da->contentType()) {
+  case DefinedAtom::typeResolver:
+  case DefinedAtom::typeThreadData:
+  case DefinedAtom::typeThreadZeroFill:
+    return false;
+  default:
+    return true;
+  }
+}
+
+} // end namespace elf
+} // end namespace lld
+
+#endif
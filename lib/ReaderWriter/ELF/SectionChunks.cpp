@@ -8,14 +8,24 @@
 //===----------------------------------------------------------------------===//
 
 #include "SectionChunks.h"
+#include "Compression.h"
 #include "TargetLayout.h"
 #include "lld/Core/Parallel.h"
 #include "llvm/ADT/ArrayRef.h"
+#include "llvm/ADT/MapVector.h"
+#include "llvm/Config/config.h"
 #include "llvm/Support/Dwarf.h"
 
 namespace lld {
 namespace elf {
 
+// The packed relative relocation format is newer than llvm/Support/ELF.h.
+enum : uint32_t { SHT_RELR = 19 };
+enum : int64_t { DT_RELRSZ = 35, DT_RELR = 36, DT_RELRENT = 37 };
+
+// So are compressed sections.
+enum : uint32_t { SHF_COMPRESSED = 0x800, ELFCOMPRESS_ZLIB = 1 };
+
 template <class ELFT>
 Section<ELFT>::Section(const ELFLinkingContext &ctx, StringRef sectionName,
                        StringRef chunkName, typename Chunk<ELFT>::Kind k)
@@ -248,6 +258,17 @@ template <class ELFT>
 void AtomSection<ELFT>::write(ELFWriter *writer, TargetLayout<ELFT> &layout,
                               llvm::FileOutputBuffer &buffer) {
   uint8_t *chunkBuffer = buffer.getBufferStart();
+  if (!_compressedContent.empty()) {
+    std::memcpy(chunkBuffer + this->fileOffset(), _compressedContent.data(),
+                _compressedContent.size());
+    return;
+  }
+  writeAtoms(writer, chunkBuffer, 0);
+}
+
+template <class ELFT>
+void AtomSection<ELFT>::writeAtoms(ELFWriter *writer, uint8_t *buf,
+                                   uint64_t base) {
   bool success = true;
   parallel_for_each(_atoms.begin(), _atoms.end(), [&](AtomLayout *ai) {
     DEBUG_WITH_TYPE("Section", llvm::dbgs()
@@ -261,13 +282,14 @@ void AtomSection<ELFT>::write(ELFWriter *writer, TargetLayout<ELFT> &layout,
     uint64_t contentSize = content.size();
     if (contentSize == 0)
       return;
-    uint8_t *atomContent = chunkBuffer + ai->_fileOffset;
+    AtomLayout atom(ai->_atom, ai->_fileOffset - base, ai->_virtualAddr);
+    uint8_t *atomContent = buf + atom._fileOffset;
     std::memcpy(atomContent, content.data(), contentSize);
     const TargetRelocationHandler &relHandler =
         this->_ctx.getTargetHandler().getRelocationHandler();
     for (const auto ref : *definedAtom) {
       if (std::error_code ec =
-              relHandler.applyRelocation(*writer, buffer, *ai, *ref)) {
+              relHandler.applyRelocation(*writer, buf, atom, *ref)) {
         printError(ec.message(), *ai, *ref);
         success = false;
       }
@@ -277,6 +299,47 @@ void AtomSection<ELFT>::write(ELFWriter *writer, TargetLayout<ELFT> &layout,
     llvm::report_fatal_error("relocating output");
 }
 
+template <class ELFT> bool AtomSection<ELFT>::compress(ELFWriter *writer) {
+#if LLVM_ENABLE_ZLIB == 1 && HAVE_LIBZ
+  typedef typename llvm::object::ELFDataTypeTypedefHelper<ELFT>::Elf_Word
+      Elf_Word;
+  typedef typename llvm::object::ELFDataTypeTypedefHelper<ELFT>::Elf_Addr
+      Elf_Addr;
+
+  uint64_t size = this->fileSize();
+  std::vector<uint8_t> content(size);
+  writeAtoms(writer, content.data(), this->fileOffset());
+
+  // Elf64_Chdr has a reserved word after ch_type; Elf32_Chdr does not.
+  size_t headerSize = 2 * sizeof(Elf_Word) + 2 * sizeof(Elf_Addr);
+  if (!ELFT::Is64Bits)
+    headerSize -= sizeof(Elf_Word);
+  std::vector<uint8_t> result(headerSize);
+  if (!zlibCompress(content, result) || result.size() >= size)
+    return false;
+  uint8_t *header = result.data();
+  *reinterpret_cast<Elf_Word *>(header) = ELFCOMPRESS_ZLIB;
+  header += sizeof(Elf_Word);
+  if (ELFT::Is64Bits) {
+    *reinterpret_cast<Elf_Word *>(header) = 0;
+    header += sizeof(Elf_Word);
+  }
+  *reinterpret_cast<Elf_Addr *>(header) = size;
+  header += sizeof(Elf_Addr);
+  *reinterpret_cast<Elf_Addr *>(header) = this->alignment();
+
+  _compressedContent = std::move(result);
+  this->_fsize = _compressedContent.size();
+  this->_flags |= SHF_COMPRESSED;
+  if (this->_outputSection)
+    this->_outputSection->setFlag(this->_outputSection->flags() |
+                                  SHF_COMPRESSED);
+  return true;
+#else
+  return false;
+#endif
+}
+
 template <class ELFT>
 void OutputSection<ELFT>::appendSection(Section<ELFT> *section) {
   if (section->alignment() > _alignment)
@@ -300,6 +363,7 @@ StringTable<ELFT>::StringTable(const ELFLinkingContext &ctx, const char *str,
   // the string table has a NULL entry for which
   // add an empty string
   _strings.push_back("");
+  _stringOffsets.push_back(0);
   this->_fsize = 1;
   this->_alignment = 1;
   this->setOrder(order);
@@ -313,30 +377,106 @@ StringTable<ELFT>::StringTable(const ELFLinkingContext &ctx, const char *str,
 template <class ELFT> uint64_t StringTable<ELFT>::addString(StringRef symname) {
   if (symname.empty())
     return 0;
-  StringMapTIter stringIter = _stringMap.find(symname);
-  if (stringIter == _stringMap.end()) {
+  StringMapT &stringMap = getShard(symname);
+  StringMapTIter stringIter = stringMap.find(symname);
+  if (stringIter == stringMap.end()) {
     _strings.push_back(symname);
     uint64_t offset = this->_fsize;
+    _stringOffsets.push_back(offset);
     this->_fsize += symname.size() + 1;
     if (this->_flags & SHF_ALLOC)
       this->_msize = this->_fsize;
-    _stringMap[symname] = offset;
+    stringMap[symname] = offset;
     return offset;
   }
   return stringIter->second;
 }
 
+template <class ELFT>
+void StringTable<ELFT>::addStrings(ArrayRef<StringRef> names,
+                                   llvm::MutableArrayRef<uint64_t> offsets) {
+  assert(names.size() == offsets.size());
+  size_t numNames = names.size();
+
+  // Bucket the names by shard, keeping the input order within each bucket.
+  std::vector<unsigned> hashes(numNames);
+  parallel_for(0, numNames, [&](size_t i) {
+    hashes[i] = llvm::HashString(names[i]);
+  });
+  std::vector<uint32_t> shardNames[NumShards];
+  for (size_t i = 0; i != numNames; ++i)
+    if (!names[i].empty())
+      shardNames[hashes[i] % NumShards].push_back(i);
+
+  // Phase one: deduplicate each shard on its own thread. firstUse[i] is the
+  // index of the first name in this batch that is equal to names[i], or
+  // numNames if the string was already in the table, in which case offsets[i]
+  // is final already.
+  std::vector<size_t> firstUse(numNames, numNames);
+  {
+    TaskGroup tg;
+    for (unsigned shard = 0; shard != NumShards; ++shard) {
+      tg.spawn([&, shard] {
+        const StringMapT &stringMap = _stringMaps[shard];
+        llvm::DenseMap<StringRef, size_t, StringRefMappingInfo> seen;
+        for (size_t i : shardNames[shard]) {
+          auto existing = stringMap.find(names[i]);
+          if (existing != stringMap.end()) {
+            offsets[i] = existing->second;
+            continue;
+          }
+          firstUse[i] = seen.insert(std::make_pair(names[i], i)).first->second;
+        }
+      });
+    }
+    tg.sync();
+  }
+
+  // Phase two: assign offsets to new strings in input order, which is the
+  // order addString would have appended them in.
+  for (size_t i = 0; i != numNames; ++i) {
+    if (names[i].empty()) {
+      offsets[i] = 0;
+      continue;
+    }
+    if (firstUse[i] != i)
+      continue;
+    offsets[i] = this->_fsize;
+    _strings.push_back(names[i]);
+    _stringOffsets.push_back(this->_fsize);
+    this->_fsize += names[i].size() + 1;
+  }
+  if (this->_flags & SHF_ALLOC)
+    this->_msize = this->_fsize;
+
+  parallel_for(0, numNames, [&](size_t i) {
+    if (firstUse[i] != numNames && firstUse[i] != i)
+      offsets[i] = offsets[firstUse[i]];
+  });
+
+  // Record the new strings so that later lookups find them.
+  TaskGroup tg;
+  for (unsigned shard = 0; shard != NumShards; ++shard) {
+    tg.spawn([&, shard] {
+      StringMapT &stringMap = _stringMaps[shard];
+      for (size_t i : shardNames[shard])
+        if (firstUse[i] == i)
+          stringMap[names[i]] = offsets[i];
+    });
+  }
+  tg.sync();
+}
+
 template <class ELFT>
 void StringTable<ELFT>::write(ELFWriter *writer, TargetLayout<ELFT> &,
                               llvm::FileOutputBuffer &buffer) {
   uint8_t *chunkBuffer = buffer.getBufferStart();
   uint8_t *dest = chunkBuffer + this->fileOffset();
-  for (auto si : _strings) {
-    memcpy(dest, si.data(), si.size());
-    dest += si.size();
-    memcpy(dest, "", 1);
-    dest += 1;
-  }
+  parallel_for(0, _strings.size(), [&](size_t i) {
+    StringRef str = _strings[i];
+    memcpy(dest + _stringOffsets[i], str.data(), str.size());
+    dest[_stringOffsets[i] + str.size()] = '\0';
+  });
 }
 
 /// ELF Symbol Table
@@ -453,20 +593,9 @@ void SymbolTable<ELFT>::addUndefinedAtom(Elf_Sym &sym,
   sym.setBindingAndType(binding, type);
 }
 
-/// Add a symbol to the symbol Table, definedAtoms which get added to the symbol
-/// section don't have their virtual addresses set at the time of adding the
-/// symbol to the symbol table(Example: dynamic symbols), the addresses needs
-/// to be updated in the table before writing the dynamic symbol table
-/// information
 template <class ELFT>
-void SymbolTable<ELFT>::addSymbol(const Atom *atom, int32_t sectionIndex,
-                                  uint64_t addr, const AtomLayout *atomLayout) {
-  Elf_Sym symbol;
-
-  if (atom->name().empty())
-    return;
-
-  symbol.st_name = _stringSection->addString(atom->name());
+bool SymbolTable<ELFT>::buildSymbol(Elf_Sym &symbol, const Atom *atom,
+                                    int32_t sectionIndex, uint64_t addr) {
   symbol.st_size = 0;
   symbol.st_shndx = sectionIndex;
   symbol.st_value = 0;
@@ -486,11 +615,30 @@ void SymbolTable<ELFT>::addSymbol(const Atom *atom, int32_t sectionIndex,
   // If --discard-all is on, don't add to the symbol table
   // symbols with local binding.
   if (this->_ctx.discardLocals() && symbol.getBinding() == llvm::ELF::STB_LOCAL)
-    return;
+    return false;
 
   // Temporary locals are all the symbols which name starts with .L.
   // This is defined by the ELF standard.
   if (this->_ctx.discardTempLocals() && atom->name().startswith(".L"))
+    return false;
+  return true;
+}
+
+/// Add a symbol to the symbol Table, definedAtoms which get added to the symbol
+/// section don't have their virtual addresses set at the time of adding the
+/// symbol to the symbol table(Example: dynamic symbols), the addresses needs
+/// to be updated in the table before writing the dynamic symbol table
+/// information
+template <class ELFT>
+void SymbolTable<ELFT>::addSymbol(const Atom *atom, int32_t sectionIndex,
+                                  uint64_t addr, const AtomLayout *atomLayout) {
+  Elf_Sym symbol;
+
+  if (atom->name().empty())
+    return;
+
+  symbol.st_name = _stringSection->addString(atom->name());
+  if (!buildSymbol(symbol, atom, sectionIndex, addr))
     return;
 
   _symbolTable.push_back(SymbolEntry(atom, symbol, atomLayout));
@@ -499,6 +647,41 @@ void SymbolTable<ELFT>::addSymbol(const Atom *atom, int32_t sectionIndex,
     this->_msize = this->_fsize;
 }
 
+template <class ELFT>
+void SymbolTable<ELFT>::addSymbols(ArrayRef<PendingSymbol> pending) {
+  size_t numSymbols = pending.size();
+
+  // Names go into the string table first, as addSymbol does, even for
+  // symbols that end up being discarded.
+  std::vector<StringRef> names(numSymbols);
+  std::vector<uint64_t> nameOffsets(numSymbols);
+  parallel_for(0, numSymbols,
+               [&](size_t i) { names[i] = pending[i]._atom->name(); });
+  _stringSection->addStrings(names, nameOffsets);
+
+  // Phase one: build the entries in parallel.
+  std::vector<Elf_Sym> symbols(numSymbols);
+  std::vector<uint8_t> keep(numSymbols);
+  parallel_for(0, numSymbols, [&](size_t i) {
+    if (names[i].empty())
+      return;
+    const PendingSymbol &p = pending[i];
+    symbols[i].st_name = nameOffsets[i];
+    keep[i] = buildSymbol(symbols[i], p._atom, p._sectionIndex, p._addr);
+  });
+
+  // Phase two: append the surviving entries in input order.
+  size_t numKept = std::count(keep.begin(), keep.end(), 1);
+  _symbolTable.reserve(_symbolTable.size() + numKept);
+  for (size_t i = 0; i != numSymbols; ++i)
+    if (keep[i])
+      _symbolTable.push_back(
+          SymbolEntry(pending[i]._atom, symbols[i], pending[i]._atomLayout));
+  this->_fsize += numKept * sizeof(Elf_Sym);
+  if (this->_flags & SHF_ALLOC)
+    this->_msize = this->_fsize;
+}
+
 template <class ELFT> void SymbolTable<ELFT>::finalize(bool sort) {
   // sh_info should be one greater than last symbol with STB_LOCAL binding
   // we sort the symbol table to keep all local symbols at the beginning
@@ -524,10 +707,10 @@ void SymbolTable<ELFT>::write(ELFWriter *writer, TargetLayout<ELFT> &,
                               llvm::FileOutputBuffer &buffer) {
   uint8_t *chunkBuffer = buffer.getBufferStart();
   uint8_t *dest = chunkBuffer + this->fileOffset();
-  for (const auto &sti : _symbolTable) {
-    memcpy(dest, &sti._symbol, sizeof(Elf_Sym));
-    dest += sizeof(Elf_Sym);
-  }
+  parallel_for(0, _symbolTable.size(), [&](size_t i) {
+    memcpy(dest + i * sizeof(Elf_Sym), &_symbolTable[i]._symbol,
+           sizeof(Elf_Sym));
+  });
 }
 
 template <class ELFT>
@@ -656,7 +839,7 @@ template <class ELFT>
 void RelocationTable<ELFT>::writeRela(ELFWriter *writer, Elf_Rela &r,
                                       const DefinedAtom &atom,
                                       const Reference &ref) {
-  r.setSymbolAndType(getSymbolIndex(ref.target()), ref.kindValue(), false);
+  r.setSymbolAndType(getSymbolIndex(ref), ref.kindValue(), false);
   r.r_offset = writer->addressOfAtom(&atom) + ref.offsetInAtom();
   // The addend is used only by relative relocations
   if (this->_ctx.isRelativeReloc(ref))
@@ -669,7 +852,7 @@ template <class ELFT>
 void RelocationTable<ELFT>::writeRel(ELFWriter *writer, Elf_Rel &r,
                                      const DefinedAtom &atom,
                                      const Reference &ref) {
-  r.setSymbolAndType(getSymbolIndex(ref.target()), ref.kindValue(), false);
+  r.setSymbolAndType(getSymbolIndex(ref), ref.kindValue(), false);
   r.r_offset = writer->addressOfAtom(&atom) + ref.offsetInAtom();
 }
 
@@ -679,6 +862,168 @@ uint32_t RelocationTable<ELFT>::getSymbolIndex(const Atom *a) {
                       : (uint32_t)STN_UNDEF;
 }
 
+template <class ELFT>
+uint32_t RelocationTable<ELFT>::getSymbolIndex(const Reference &r) {
+  // A relocation that only adds the load address names no symbol.
+  if (this->_ctx.isPackableRelativeReloc(r))
+    return STN_UNDEF;
+  return getSymbolIndex(r.target());
+}
+
+template <class ELFT>
+RelrSection<ELFT>::RelrSection(const ELFLinkingContext &ctx, StringRef str,
+                               int32_t order)
+    : Section<ELFT>(ctx, str, "RelrSection") {
+  this->setOrder(order);
+  this->_flags = SHF_ALLOC;
+  this->_type = SHT_RELR;
+  this->_entSize = sizeof(Elf_Addr);
+  this->_alignment = sizeof(Elf_Addr);
+}
+
+template <class ELFT>
+bool RelrSection<ELFT>::canPack(const DefinedAtom &da, const Reference &r) {
+  const uint64_t wordSize = sizeof(Elf_Addr);
+  DefinedAtom::Alignment align = da.alignment();
+  // Without DT_TEXTREL the loader will not write to read-only pages.
+  if ((da.permissions() & DefinedAtom::permRW_) != DefinedAtom::permRW_)
+    return false;
+  return (align.value % wordSize) == 0 && (align.modulus % wordSize) == 0 &&
+         (r.offsetInAtom() % wordSize) == 0;
+}
+
+/// \brief Append the packed encoding of the sorted, unique, word-aligned
+/// \p offsets to \p out.
+static void encodeRelr(ArrayRef<uint64_t> offsets, uint64_t wordSize,
+                       std::vector<uint64_t> &out) {
+  const uint64_t wordsPerBitmap = wordSize * 8 - 1;
+  size_t i = 0, e = offsets.size();
+  while (i != e) {
+    out.push_back(offsets[i]);
+    uint64_t base = offsets[i++] + wordSize;
+    for (;;) {
+      uint64_t bitmap = 0;
+      for (; i != e; ++i) {
+        uint64_t delta = (offsets[i] - base) / wordSize;
+        if (delta >= wordsPerBitmap)
+          break;
+        bitmap |= uint64_t(1) << delta;
+      }
+      if (!bitmap)
+        break;
+      out.push_back((bitmap << 1) | 1);
+      base += wordsPerBitmap * wordSize;
+    }
+  }
+}
+
+template <class ELFT> void RelrSection<ELFT>::doPreFlight() {
+  // Atom offsets are still relative to their sections at this point.
+  llvm::MapVector<const AtomSection<ELFT> *, std::vector<uint64_t>> offsets;
+  for (const Relocation &rel : _relocs)
+    offsets[rel._section].push_back(rel._atomLayout->_fileOffset +
+                                    rel._ref->offsetInAtom());
+  _entries.clear();
+  _groups.clear();
+  for (auto &kv : offsets) {
+    std::vector<uint64_t> &v = kv.second;
+    std::sort(v.begin(), v.end());
+    v.erase(std::unique(v.begin(), v.end()), v.end());
+    size_t begin = _entries.size();
+    encodeRelr(v, sizeof(Elf_Addr), _entries);
+    _groups.push_back({kv.first, begin, _entries.size()});
+  }
+  this->_fsize = _entries.size() * sizeof(Elf_Addr);
+  this->_msize = this->_fsize;
+}
+
+template <class ELFT>
+void RelrSection<ELFT>::write(ELFWriter *writer, TargetLayout<ELFT> &layout,
+                              llvm::FileOutputBuffer &buffer) {
+  // Address words must be increasing, so emit the sections in address order.
+  std::vector<Group> groups(_groups);
+  std::sort(groups.begin(), groups.end(), [](const Group &a, const Group &b) {
+    return a._section->virtualAddr() < b._section->virtualAddr();
+  });
+  Elf_Addr *dest = reinterpret_cast<Elf_Addr *>(buffer.getBufferStart() +
+                                                this->fileOffset());
+  for (const Group &g : groups) {
+    uint64_t base = g._section->virtualAddr();
+    for (size_t i = g._begin; i != g._end; ++i) {
+      uint64_t word = _entries[i];
+      *dest++ = (word & 1) ? word : base + word;
+    }
+  }
+}
+
+template <class ELFT>
+VersionNeedSection<ELFT>::VersionNeedSection(
+    const ELFLinkingContext &ctx, StringRef str, int32_t order,
+    StringTable<ELFT> *dynamicStringTable)
+    : Section<ELFT>(ctx, str, "VersionNeedSection"),
+      _stringTable(dynamicStringTable) {
+  this->setOrder(order);
+  this->_flags = SHF_ALLOC;
+  this->_type = SHT_GNU_verneed;
+  this->_alignment = sizeof(typename Elf_Verneed::Elf_Word);
+}
+
+template <class ELFT>
+void VersionNeedSection<ELFT>::addNeed(StringRef soname, StringRef version) {
+  auto it = std::find_if(_needs.begin(), _needs.end(), [&](const Need &n) {
+    return n._soname == soname;
+  });
+  if (it == _needs.end()) {
+    _needs.push_back({soname, (uint32_t)_stringTable->addString(soname), {}});
+    it = _needs.end() - 1;
+    this->_fsize += sizeof(Elf_Verneed);
+  }
+  it->_versions.push_back({(uint32_t)llvm::object::elf_hash(version),
+                           (uint32_t)_stringTable->addString(version)});
+  this->_fsize += sizeof(Elf_Vernaux);
+  this->_msize = this->_fsize;
+}
+
+template <class ELFT> void VersionNeedSection<ELFT>::finalize() {
+  this->_link = _stringTable->ordinal();
+  this->_info = _needs.size();
+  if (this->_outputSection) {
+    this->_outputSection->setType(this->_type);
+    this->_outputSection->setLink(this->_link);
+    this->_outputSection->setInfo(this->_info);
+  }
+}
+
+template <class ELFT>
+void VersionNeedSection<ELFT>::write(ELFWriter *writer,
+                                     TargetLayout<ELFT> &layout,
+                                     llvm::FileOutputBuffer &buffer) {
+  uint8_t *dest = buffer.getBufferStart() + this->fileOffset();
+  // Version indexes 0 and 1 mean local and global, so needs start at 2.
+  uint16_t index = 2;
+  for (size_t i = 0, e = _needs.size(); i != e; ++i) {
+    const Need &need = _needs[i];
+    auto *vn = reinterpret_cast<Elf_Verneed *>(dest);
+    vn->vn_version = VER_NEED_CURRENT;
+    vn->vn_cnt = need._versions.size();
+    vn->vn_file = need._file;
+    vn->vn_aux = sizeof(Elf_Verneed);
+    vn->vn_next = i + 1 == e ? 0
+                             : sizeof(Elf_Verneed) +
+                                   need._versions.size() * sizeof(Elf_Vernaux);
+    dest += sizeof(Elf_Verneed);
+    for (size_t j = 0, je = need._versions.size(); j != je; ++j) {
+      auto *vna = reinterpret_cast<Elf_Vernaux *>(dest);
+      vna->vna_hash = need._versions[j]._hash;
+      vna->vna_flags = 0;
+      vna->vna_other = index++;
+      vna->vna_name = need._versions[j]._name;
+      vna->vna_next = j + 1 == je ? 0 : sizeof(Elf_Vernaux);
+      dest += sizeof(Elf_Vernaux);
+    }
+  }
+}
+
 template <class ELFT>
 DynamicTable<ELFT>::DynamicTable(const ELFLinkingContext &ctx,
                                  TargetLayout<ELFT> &layout, StringRef str,
@@ -732,6 +1077,15 @@ template <class ELFT> void DynamicTable<ELFT>::createDefaultEntries() {
     if (_layout.getDynamicRelocationTable()->canModifyReadonlySection())
       _dt_textrel = addEntry(DT_TEXTREL, 0);
   }
+  if (_layout.hasRelrTable()) {
+    _dt_relr = addEntry(DT_RELR, 0);
+    _dt_relrsz = addEntry(DT_RELRSZ, 0);
+    _dt_relrent = addEntry(DT_RELRENT, 0);
+  }
+  if (_versionNeed) {
+    _dt_verneed = addEntry(DT_VERNEED, 0);
+    _dt_verneednum = addEntry(DT_VERNEEDNUM, _versionNeed->numNeeds());
+  }
   if (_layout.hasPLTRelocationTable()) {
     _dt_pltrelsz = addEntry(DT_PLTRELSZ, 0);
     _dt_pltgot = addEntry(getGotPltTag(), 0);
@@ -794,6 +1148,14 @@ template <class ELFT> void DynamicTable<ELFT>::updateDynamicTable() {
     _entries[_dt_relasz].d_un.d_val = relaTbl->memSize();
     _entries[_dt_relaent].d_un.d_val = relaTbl->getEntSize();
   }
+  if (_layout.hasRelrTable()) {
+    auto relrTbl = _layout.getRelrTable();
+    _entries[_dt_relr].d_un.d_val = relrTbl->virtualAddr();
+    _entries[_dt_relrsz].d_un.d_val = relrTbl->memSize();
+    _entries[_dt_relrent].d_un.d_val = relrTbl->getEntSize();
+  }
+  if (_versionNeed)
+    _entries[_dt_verneed].d_un.d_val = _versionNeed->virtualAddr();
   if (_layout.hasPLTRelocationTable()) {
     auto relaTbl = _layout.getPLTRelocationTable();
     _entries[_dt_jmprel].d_un.d_val = relaTbl->virtualAddr();
@@ -981,9 +1343,11 @@ INSTANTIATE(HashSection);
 INSTANTIATE(InterpSection);
 INSTANTIATE(OutputSection);
 INSTANTIATE(RelocationTable);
+INSTANTIATE(RelrSection);
 INSTANTIATE(Section);
 INSTANTIATE(StringTable);
 INSTANTIATE(SymbolTable);
+INSTANTIATE(VersionNeedSection);
 
 } // end namespace elf
 } // end namespace lld
@@ -183,6 +183,14 @@ public:
   void write(ELFWriter *writer, TargetLayout<ELFT> &layout,
              llvm::FileOutputBuffer &buffer) override;
 
+  /// \brief Replaces the contents of the section by a zlib stream preceded
+  /// by an ELF compression header, and sets SHF_COMPRESSED. Relocations are
+  /// applied first, so this is called once addresses and file offsets are
+  /// known; the file offsets of the following sections must then be
+  /// reassigned. Returns false, leaving the section unchanged, if zlib is
+  /// not available or does not make the section smaller.
+  bool compress(ELFWriter *writer);
+
   static bool classof(const Chunk<ELFT> *c) {
     return c->kind() == Chunk<ELFT>::Kind::AtomSection;
   }
@@ -193,8 +201,13 @@ protected:
   int32_t _contentPermissions;
   bool _isLoadedInMemory = true;
   std::vector<AtomLayout *> _atoms;
+  std::vector<uint8_t> _compressedContent;
   mutable std::mutex _outputMutex;
 
+  /// Copies the atoms to \p buf and applies their relocations. Atoms are
+  /// written at their file offsets minus \p base.
+  void writeAtoms(ELFWriter *writer, uint8_t *buf, uint64_t base);
+
   void printError(const std::string &errorStr, const AtomLayout &atom,
                   const Reference &ref) const;
 };
@@ -289,13 +302,27 @@ public:
 
   uint64_t addString(StringRef symname);
 
+  /// \brief Add all \p names to the table and store the offset of each of
+  /// them in \p offsets. The result is the same as calling addString on each
+  /// name in turn, but names are deduplicated and laid out in parallel.
+  void addStrings(ArrayRef<StringRef> names,
+                  llvm::MutableArrayRef<uint64_t> offsets);
+
   void write(ELFWriter *writer, TargetLayout<ELFT> &layout,
              llvm::FileOutputBuffer &buffer) override;
 
-  void setNumEntries(int64_t numEntries) { _stringMap.resize(numEntries); }
+  void setNumEntries(int64_t numEntries) {
+    for (StringMapT &shard : _stringMaps)
+      shard.resize(numEntries / NumShards);
+  }
 
 private:
+  // The string map is split into shards by hash value so that addStrings can
+  // deduplicate each shard on a separate thread.
+  enum { NumShards = 64 };
+
   std::vector<StringRef> _strings;
+  std::vector<uint64_t> _stringOffsets;
 
   struct StringRefMappingInfo {
     static StringRef getEmptyKey() { return StringRef(); }
@@ -310,7 +337,11 @@ private:
   typedef typename llvm::DenseMap<StringRef, uint64_t, StringRefMappingInfo>
       StringMapT;
   typedef typename StringMapT::iterator StringMapTIter;
-  StringMapT _stringMap;
+  StringMapT _stringMaps[NumShards];
+
+  StringMapT &getShard(StringRef str) {
+    return _stringMaps[llvm::HashString(str) % NumShards];
+  }
 };
 
 /// \brief The SymbolTable class represents the symbol table in a ELF file
@@ -336,6 +367,24 @@ public:
   void addSymbol(const Atom *atom, int32_t sectionIndex, uint64_t addr = 0,
                  const AtomLayout *layout = nullptr);
 
+  /// \brief A symbol waiting to be added by addSymbols.
+  struct PendingSymbol {
+    PendingSymbol(const Atom *a, int32_t sectionIndex, uint64_t addr = 0,
+                  const AtomLayout *layout = nullptr)
+        : _atom(a), _sectionIndex(sectionIndex), _addr(addr),
+          _atomLayout(layout) {}
+
+    const Atom *_atom;
+    int32_t _sectionIndex;
+    uint64_t _addr;
+    const AtomLayout *_atomLayout;
+  };
+
+  /// \brief Add symbols in bulk. This has the same effect as calling
+  /// addSymbol for each element in order, but the symbols and their names
+  /// are built in parallel.
+  void addSymbols(ArrayRef<PendingSymbol> symbols);
+
   /// \brief Get the symbol table index for an Atom. If it's not in the symbol
   /// table, return STN_UNDEF.
   uint32_t getSymbolTableIndex(const Atom *a) const {
@@ -374,6 +423,11 @@ public:
   StringTable<ELFT> *getStringTable() const { return _stringSection; }
 
 protected:
+  /// \brief Fill in every field of \p symbol but st_name. Returns false if
+  /// the symbol should be left out of the table.
+  bool buildSymbol(Elf_Sym &symbol, const Atom *atom, int32_t sectionIndex,
+                   uint64_t addr);
+
   struct SymbolEntry {
     SymbolEntry(const Atom *a, const Elf_Sym &sym, const AtomLayout *layout)
         : _atom(a), _atomLayout(layout), _symbol(sym) {}
@@ -440,11 +494,104 @@ protected:
   virtual void writeRel(ELFWriter *writer, Elf_Rel &r, const DefinedAtom &atom,
                         const Reference &ref);
   uint32_t getSymbolIndex(const Atom *a);
+  uint32_t getSymbolIndex(const Reference &r);
 
 private:
   std::vector<std::pair<const DefinedAtom *, const Reference *>> _relocs;
 };
 
+/// \brief Relative relocations in the packed SHT_RELR format (.relr.dyn).
+///
+/// The table is a sequence of words. An even word is the address of a word to
+/// relocate. An odd word is a bitmap: bit i (i >= 1) marks the word i - 1
+/// words past the last location covered, and each bitmap covers wordbits - 1
+/// words. The loader adds the load base to every marked word, so the addend
+/// has to be stored in place.
+///
+/// The words are encoded per input section using section-relative offsets in
+/// doPreFlight, so the size is known before addresses are assigned. write()
+/// only rebases the address words.
+template <class ELFT> class RelrSection : public Section<ELFT> {
+public:
+  typedef typename llvm::object::ELFDataTypeTypedefHelper<ELFT>::Elf_Addr
+      Elf_Addr;
+
+  RelrSection(const ELFLinkingContext &ctx, StringRef str, int32_t order);
+
+  /// \brief Returns true if the word \p r relocates in \p da is writable and
+  /// guaranteed to be word-aligned in the output, as the format requires.
+  static bool canPack(const DefinedAtom &da, const Reference &r);
+
+  void addRelocation(const AtomSection<ELFT> *section, const AtomLayout *al,
+                     const Reference &r) {
+    _relocs.push_back({section, al, &r});
+  }
+
+  void doPreFlight() override;
+
+  void write(ELFWriter *writer, TargetLayout<ELFT> &layout,
+             llvm::FileOutputBuffer &buffer) override;
+
+private:
+  struct Relocation {
+    const AtomSection<ELFT> *_section;
+    const AtomLayout *_atomLayout;
+    const Reference *_ref;
+  };
+
+  // The words encoding the relocations in one input section.
+  struct Group {
+    const AtomSection<ELFT> *_section;
+    size_t _begin;
+    size_t _end;
+  };
+
+  std::vector<Relocation> _relocs;
+  std::vector<uint64_t> _entries;
+  std::vector<Group> _groups;
+};
+
+/// \brief Versions needed from shared objects (.gnu.version_r).
+///
+/// lld does not version symbols, so the only needs recorded are versions
+/// that stand for a loader feature, like GLIBC_ABI_DT_RELR: a loader that
+/// lacks the version refuses to load the output.
+template <class ELFT> class VersionNeedSection : public Section<ELFT> {
+public:
+  typedef llvm::object::Elf_Verneed_Impl<ELFT> Elf_Verneed;
+  typedef llvm::object::Elf_Vernaux_Impl<ELFT> Elf_Vernaux;
+
+  VersionNeedSection(const ELFLinkingContext &ctx, StringRef str,
+                     int32_t order, StringTable<ELFT> *dynamicStringTable);
+
+  /// \brief Records that the output needs \p version from the shared object
+  /// \p soname, which has to be one of the DT_NEEDED entries.
+  void addNeed(StringRef soname, StringRef version);
+
+  /// \returns the number of shared objects versions are needed from.
+  uint32_t numNeeds() const { return _needs.size(); }
+
+  void finalize() override;
+
+  void write(ELFWriter *writer, TargetLayout<ELFT> &layout,
+             llvm::FileOutputBuffer &buffer) override;
+
+private:
+  struct Version {
+    uint32_t _hash;
+    uint32_t _name;
+  };
+
+  struct Need {
+    StringRef _soname;
+    uint32_t _file;
+    std::vector<Version> _versions;
+  };
+
+  StringTable<ELFT> *_stringTable;
+  std::vector<Need> _needs;
+};
+
 template <class ELFT> class HashSection;
 
 template <class ELFT> class DynamicTable : public Section<ELFT> {
@@ -482,6 +629,10 @@ public:
 
   void setHashTable(HashSection<ELFT> *hsh) { _hashTable = hsh; }
 
+  void setVersionNeedSection(VersionNeedSection<ELFT> *verneed) {
+    _versionNeed = verneed;
+  }
+
   virtual void updateDynamicTable();
 
 protected:
@@ -502,6 +653,11 @@ private:
   std::size_t _dt_rela;
   std::size_t _dt_relasz;
   std::size_t _dt_relaent;
+  std::size_t _dt_relr;
+  std::size_t _dt_relrsz;
+  std::size_t _dt_relrent;
+  std::size_t _dt_verneed;
+  std::size_t _dt_verneednum;
   std::size_t _dt_strsz;
   std::size_t _dt_syment;
   std::size_t _dt_pltrelsz;
@@ -518,6 +674,7 @@ private:
   TargetLayout<ELFT> &_layout;
   DynamicSymbolTable<ELFT> *_dynamicSymbolTable;
   HashSection<ELFT> *_hashTable;
+  VersionNeedSection<ELFT> *_versionNeed = nullptr;
 
   const AtomLayout *getInitAtomLayout();
 
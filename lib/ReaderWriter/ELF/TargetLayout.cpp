@@ -9,6 +9,8 @@
 
 #include "TargetLayout.h"
 #include "llvm/ADT/ArrayRef.h"
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/SmallVector.h"
 #include "llvm/ADT/StringSwitch.h"
 #include "llvm/Support/Errc.h"
 
@@ -142,7 +144,9 @@ TargetLayout<ELFT>::getSegmentType(Section<ELFT> *section) const {
   case ORDER_HASH:
   case ORDER_DYNAMIC_SYMBOLS:
   case ORDER_DYNAMIC_STRINGS:
+  case ORDER_DYNAMIC_VERSION_NEED:
   case ORDER_DYNAMIC_RELOCS:
+  case ORDER_DYNAMIC_RELR:
   case ORDER_DYNAMIC_PLT_RELOCS:
   case ORDER_REL:
   case ORDER_INIT:
@@ -188,7 +192,9 @@ bool TargetLayout<ELFT>::hasOutputSegment(Section<ELFT> *section) {
   case ORDER_HASH:
   case ORDER_DYNAMIC_SYMBOLS:
   case ORDER_DYNAMIC_STRINGS:
+  case ORDER_DYNAMIC_VERSION_NEED:
   case ORDER_DYNAMIC_RELOCS:
+  case ORDER_DYNAMIC_RELR:
   case ORDER_DYNAMIC_PLT_RELOCS:
   case ORDER_REL:
   case ORDER_INIT:
@@ -247,6 +253,7 @@ TargetLayout<ELFT>::getSection(StringRef sectionName, int32_t contentType,
   newSec->setArchiveNameOrPath(da->file().archivePath());
   newSec->setMemberNameOrPath(da->file().memberPath());
   _sections.push_back(newSec);
+  _atomLayoutsByNameValid = false;
   _sectionMap.insert(std::make_pair(sectionKey, newSec));
   return newSec;
 }
@@ -267,10 +274,17 @@ ErrorOr<const AtomLayout *> TargetLayout<ELFT>::addAtom(const Atom *atom) {
     AtomSection<ELFT> *section =
         getSection(sectionName, contentType, permissions, definedAtom);
 
-    // Add runtime relocations to the .rela section.
+    // Add runtime relocations to the .rela section. With
+    // -z pack-relative-relocs, word-aligned relative relocations go into
+    // .relr.dyn instead once the atom's offset is known.
+    SmallVector<const Reference *, 4> packedRelocs;
     for (const auto &reloc : *definedAtom) {
       bool isLocalReloc = true;
-      if (_ctx.isDynamicRelocation(*reloc)) {
+      if (_ctx.packRelativeRelocs() && _ctx.isPackableRelativeReloc(*reloc) &&
+          RelrSection<ELFT>::canPack(*definedAtom, *reloc)) {
+        packedRelocs.push_back(reloc);
+        isLocalReloc = false;
+      } else if (_ctx.isDynamicRelocation(*reloc)) {
         getDynamicRelocationTable()->addRelocation(*definedAtom, *reloc);
         isLocalReloc = false;
       } else if (_ctx.isPLTRelocation(*reloc)) {
@@ -292,15 +306,22 @@ ErrorOr<const AtomLayout *> TargetLayout<ELFT>::addAtom(const Atom *atom) {
 
       _referencedDynAtoms.insert(reloc->target());
     }
-    return section->appendAtom(atom);
+    _atomLayoutsByNameValid = false;
+    const AtomLayout *al = section->appendAtom(atom);
+    for (const Reference *reloc : packedRelocs)
+      getRelrTable()->addRelocation(section, al, *reloc);
+    return al;
   }
 
   const AbsoluteAtom *absoluteAtom = cast<AbsoluteAtom>(atom);
   // Absolute atoms are not part of any section, they are global for the whole
   // link
-  _absoluteAtoms.push_back(
-      new (_allocator) AtomLayout(absoluteAtom, 0, absoluteAtom->value()));
-  return _absoluteAtoms.back();
+  AtomLayout *al =
+      new (_allocator) AtomLayout(absoluteAtom, 0, absoluteAtom->value());
+  _absoluteAtoms.push_back(al);
+  // The first absolute atom with a given name wins.
+  _absoluteAtomsByName.insert(std::make_pair(absoluteAtom->name(), al));
+  return al;
 }
 
 /// Output sections with the same name into a OutputSection
@@ -515,6 +536,29 @@ template <class ELFT> void TargetLayout<ELFT>::assignVirtualAddress() {
     if (section && TargetLayout<ELFT>::hasOutputSegment(section))
       section->assignFileOffsets(section->fileOffset());
   }
+  assignOutputSectionFileOffsets();
+  // Set the virtual addr of the merged Sections
+  for (auto osi : _outputSections) {
+    uint64_t sectionstartaddr = 0;
+    uint64_t startaddr = 0;
+    uint64_t sectionsize = 0;
+    bool isFirstSection = true;
+    for (auto si : osi->sections()) {
+      if (isFirstSection) {
+        startaddr = si->virtualAddr();
+        isFirstSection = false;
+      }
+      sectionstartaddr = si->virtualAddr();
+      sectionsize = si->memSize();
+    }
+    sectionsize = (sectionstartaddr - startaddr) + sectionsize;
+    osi->setMemSize(sectionsize);
+    osi->setAddr(startaddr);
+  }
+}
+
+template <class ELFT>
+void TargetLayout<ELFT>::assignOutputSectionFileOffsets() {
   // Set the size of the merged Sections
   for (auto osi : _outputSections) {
     uint64_t sectionfileoffset = 0;
@@ -533,24 +577,28 @@ template <class ELFT> void TargetLayout<ELFT>::assignVirtualAddress() {
     osi->setFileOffset(startFileOffset);
     osi->setSize(sectionsize);
   }
-  // Set the virtual addr of the merged Sections
-  for (auto osi : _outputSections) {
-    uint64_t sectionstartaddr = 0;
-    uint64_t startaddr = 0;
-    uint64_t sectionsize = 0;
-    bool isFirstSection = true;
-    for (auto si : osi->sections()) {
-      if (isFirstSection) {
-        startaddr = si->virtualAddr();
-        isFirstSection = false;
-      }
-      sectionstartaddr = si->virtualAddr();
-      sectionsize = si->memSize();
-    }
-    sectionsize = (sectionstartaddr - startaddr) + sectionsize;
-    osi->setMemSize(sectionsize);
-    osi->setAddr(startaddr);
+}
+
+template <class ELFT> void TargetLayout<ELFT>::reassignFileOffsets() {
+  llvm::DenseMap<Section<ELFT> *, uint64_t> oldOffsets;
+  for (auto &si : _sections)
+    if (auto *section = dyn_cast<Section<ELFT>>(si))
+      if (TargetLayout<ELFT>::hasOutputSegment(section))
+        oldOffsets[section] = section->fileOffset();
+  uint64_t fileoffset = 0;
+  for (auto &si : _segments) {
+    if ((si->segmentType() != llvm::ELF::PT_LOAD) &&
+        (si->segmentType() != llvm::ELF::PT_NULL))
+      continue;
+    si->assignFileOffsets(fileoffset);
+    fileoffset = si->fileOffset() + si->fileSize();
   }
+  // The atom offsets are absolute by now, so move them by the distance their
+  // section moved.
+  for (auto &kv : oldOffsets)
+    if (kv.first->fileOffset() != kv.second)
+      kv.first->assignFileOffsets(kv.first->fileOffset() - kv.second);
+  assignOutputSectionFileOffsets();
 }
 
 template <class ELFT>
@@ -579,6 +627,8 @@ void TargetLayout<ELFT>::assignFileOffsetsForMiscSections() {
 }
 
 template <class ELFT> void TargetLayout<ELFT>::sortInputSections() {
+  _atomLayoutsByNameValid = false;
+
   // First, sort according to default layout's order
   std::stable_sort(
       _sections.begin(), _sections.end(),
@@ -587,22 +637,25 @@ template <class ELFT> void TargetLayout<ELFT>::sortInputSections() {
   if (!_linkerScriptSema.hasLayoutCommands())
     return;
 
-  // Sort the sections by their order as defined by the linker script
-  std::stable_sort(
-      this->_sections.begin(), this->_sections.end(),
-      [this](Chunk<ELFT> *A, Chunk<ELFT> *B) {
-        auto *a = dyn_cast<Section<ELFT>>(A);
-        auto *b = dyn_cast<Section<ELFT>>(B);
-
-        if (a == nullptr)
-          return false;
-        if (b == nullptr)
-          return true;
-
-        return _linkerScriptSema.less(
-            {a->archivePath(), a->memberPath(), a->inputSectionName()},
-            {b->archivePath(), b->memberPath(), b->inputSectionName()});
-      });
+  // Sort the sections by their order as defined by the linker script. Chunks
+  // that are not sections go last.
+  auto sectionsEnd = std::stable_partition(
+      _sections.begin(), _sections.end(),
+      [](Chunk<ELFT> *c) { return isa<Section<ELFT>>(c); });
+  std::vector<script::Sema::SectionKey> keys;
+  keys.reserve(sectionsEnd - _sections.begin());
+  for (auto i = _sections.begin(); i != sectionsEnd; ++i) {
+    auto *sec = cast<Section<ELFT>>(*i);
+    keys.push_back(
+        {sec->archivePath(), sec->memberPath(), sec->inputSectionName()});
+  }
+  std::vector<size_t> order = _linkerScriptSema.getLayoutPermutation(keys);
+  std::vector<Chunk<ELFT> *> sorted;
+  sorted.reserve(order.size());
+  for (size_t i : order)
+    sorted.push_back(_sections[i]);
+  std::copy(sorted.begin(), sorted.end(), _sections.begin());
+
   // Now try to arrange sections with no mapping rules to sections with
   // similar content
   auto p = this->_sections.begin();
@@ -618,34 +671,53 @@ template <class ELFT> void TargetLayout<ELFT>::sortInputSections() {
 
     ++p;
   }
-  // For all sections that have no assigned rule id, try to move them near a
-  // section with similar contents
-  if (p != this->_sections.begin()) {
-    for (; p != this->_sections.end(); ++p) {
-      auto q = p;
-      --q;
-      while (q != this->_sections.begin() &&
-             (*q)->getContentType() != (*p)->getContentType())
-        --q;
-      if ((*q)->getContentType() != (*p)->getContentType())
-        continue;
-      ++q;
-      for (auto i = p; i != q;) {
-        auto next = i--;
-        std::iter_swap(i, next);
-      }
-    }
+  if (p == this->_sections.begin())
+    return;
+
+  // Each section with no assigned rule id goes right after the last section
+  // before it with similar contents, if there is one. Moving them one at a
+  // time is quadratic, so collect the sections that follow each such anchor
+  // and rebuild the list in one pass. The anchor for a content type is the
+  // last mapped section of that type or, failing that, the first unmapped
+  // one, which stays in place.
+  llvm::DenseMap<int, Chunk<ELFT> *> anchors;
+  for (auto i = this->_sections.begin(); i != p; ++i)
+    anchors[(*i)->getContentType()] = *i;
+  llvm::DenseMap<Chunk<ELFT> *, std::vector<Chunk<ELFT> *>> followers;
+  std::vector<Chunk<ELFT> *> unmoved(this->_sections.begin(), p);
+  for (auto i = p, e = this->_sections.end(); i != e; ++i) {
+    auto anchor = anchors.insert(std::make_pair((*i)->getContentType(), *i));
+    if (anchor.second)
+      unmoved.push_back(*i);
+    else
+      followers[anchor.first->second].push_back(*i);
+  }
+  auto out = this->_sections.begin();
+  for (Chunk<ELFT> *c : unmoved) {
+    *out++ = c;
+    auto f = followers.find(c);
+    if (f != followers.end())
+      out = std::copy(f->second.begin(), f->second.end(), out);
   }
 }
 
 template <class ELFT>
 const AtomLayout *
 TargetLayout<ELFT>::findAtomLayoutByName(StringRef name) const {
+  if (!_atomLayoutsByNameValid)
+    buildAtomLayoutIndex();
+  return _atomLayoutsByName.lookup(name);
+}
+
+template <class ELFT> void TargetLayout<ELFT>::buildAtomLayoutIndex() const {
+  // Walk the sections in layout order and keep the first atom for each name,
+  // which is what a linear search over the sections would find.
+  _atomLayoutsByName.clear();
   for (auto sec : _sections)
-    if (auto section = dyn_cast<Section<ELFT>>(sec))
-      if (auto *al = section->findAtomLayoutByName(name))
-        return al;
-  return nullptr;
+    if (auto section = dyn_cast<AtomSection<ELFT>>(sec))
+      for (AtomLayout *al : section->atoms())
+        _atomLayoutsByName.insert(std::make_pair(al->_atom->name(), al));
+  _atomLayoutsByNameValid = true;
 }
 
 template <class ELFT>
@@ -686,6 +758,16 @@ RelocationTable<ELFT> *TargetLayout<ELFT>::getPLTRelocationTable() {
   return _pltRelocationTable.get();
 }
 
+template <class ELFT> RelrSection<ELFT> *TargetLayout<ELFT>::getRelrTable() {
+  if (!_relrTable) {
+    _relrTable = unique_bump_ptr<RelrSection<ELFT>>(
+        new (_allocator) RelrSection<ELFT>(_ctx, ".relr.dyn",
+                                           ORDER_DYNAMIC_RELR));
+    addSection(_relrTable.get());
+  }
+  return _relrTable.get();
+}
+
 template <class ELFT> uint64_t TargetLayout<ELFT>::getTLSSize() const {
   for (const auto &phdr : *_programHeader)
     if (phdr->p_type == llvm::ELF::PT_TLS)
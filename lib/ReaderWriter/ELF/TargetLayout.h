@@ -44,7 +44,9 @@ public:
     ORDER_HASH = 30,
     ORDER_DYNAMIC_SYMBOLS = 40,
     ORDER_DYNAMIC_STRINGS = 50,
+    ORDER_DYNAMIC_VERSION_NEED = 51,
     ORDER_DYNAMIC_RELOCS = 52,
+    ORDER_DYNAMIC_RELR = 53,
     ORDER_DYNAMIC_PLT_RELOCS = 54,
     ORDER_INIT = 60,
     ORDER_PLT = 70,
@@ -198,12 +200,7 @@ public:
 
   /// \brief find a absolute atom given a name
   AtomLayout *findAbsoluteAtom(StringRef name) {
-    auto iter = std::find_if(
-        _absoluteAtoms.begin(), _absoluteAtoms.end(),
-        [=](const AtomLayout *a) { return a->_atom->name() == name; });
-    if (iter == _absoluteAtoms.end())
-      return nullptr;
-    return *iter;
+    return _absoluteAtomsByName.lookup(name);
   }
 
   // Output sections with the same name into a OutputSection
@@ -227,11 +224,20 @@ public:
   /// \brief associates a virtual address to the segment, section, and the atom
   virtual void assignVirtualAddress();
 
+  /// \brief Lays out the segments in the file again after the size of some
+  /// sections changed, and moves the sections and their atoms accordingly.
+  /// Virtual addresses are left unchanged, so only sections that are not
+  /// loaded may change size.
+  void reassignFileOffsets();
+
   void assignFileOffsetsForMiscSections();
 
   range<AbsoluteAtomIterT> absoluteAtoms() { return _absoluteAtoms; }
 
-  void addSection(Chunk<ELFT> *c) { _sections.push_back(c); }
+  void addSection(Chunk<ELFT> *c) {
+    _sections.push_back(c);
+    _atomLayoutsByNameValid = false;
+  }
 
   void finalize() {
     ScopedTask task(getDefaultDomain(), "Finalize layout");
@@ -265,6 +271,8 @@ public:
 
   bool hasPLTRelocationTable() const { return !!_pltRelocationTable; }
 
+  bool hasRelrTable() const { return !!_relrTable; }
+
   /// \brief Get or create the dynamic relocation table. All relocations in this
   /// table are processed at startup.
   RelocationTable<ELFT> *getDynamicRelocationTable();
@@ -272,6 +280,10 @@ public:
   /// \brief Get or create the PLT relocation table. Referenced by DT_JMPREL.
   RelocationTable<ELFT> *getPLTRelocationTable();
 
+  /// \brief Get or create the packed relative relocation table, used for
+  /// -z pack-relative-relocs. Referenced by DT_RELR.
+  RelrSection<ELFT> *getRelrTable();
+
   uint64_t getTLSSize() const;
 
   bool isReferencedByDefinedAtom(const Atom *a) const {
@@ -283,6 +295,10 @@ public:
   }
 
 protected:
+  /// \brief Sets the file offsets and sizes of the output sections from those
+  /// of their sections.
+  void assignOutputSectionFileOffsets();
+
   /// \brief TargetLayouts may use these functions to reorder the input sections
   /// in a order defined by their ABI.
   virtual void finalizeOutputSectionLayout() {}
@@ -302,6 +318,9 @@ protected:
 
   virtual uint64_t getLookupSectionFlags(const OutputSection<ELFT> *os) const;
 
+  /// \brief Build the name index used by findAtomLayoutByName.
+  void buildAtomLayoutIndex() const;
+
 protected:
   llvm::BumpPtrAllocator _allocator;
   SectionMapT _sectionMap;
@@ -315,7 +334,13 @@ protected:
   ProgramHeader<ELFT> *_programHeader;
   unique_bump_ptr<RelocationTable<ELFT>> _dynamicRelocationTable;
   unique_bump_ptr<RelocationTable<ELFT>> _pltRelocationTable;
+  unique_bump_ptr<RelrSection<ELFT>> _relrTable;
   std::vector<AtomLayout *> _absoluteAtoms;
+  llvm::StringMap<AtomLayout *> _absoluteAtomsByName;
+  // Name to atom layout index for all sections, built on first lookup and
+  // dropped whenever atoms or sections are added or reordered.
+  mutable llvm::StringMap<const AtomLayout *> _atomLayoutsByName;
+  mutable bool _atomLayoutsByNameValid = false;
   AtomSetT _referencedDynAtoms;
   llvm::StringSet<> _copiedDynSymNames;
   ELFLinkingContext &_ctx;
@@ -29,6 +29,37 @@ void X86_64LinkingContext::addPasses(PassManager &pm) {
   ELFLinkingContext::addPasses(pm);
 }
 
+// R_X86_64_PC32 is also used by RIP-relative instructions such as LEA, which
+// take the address of their target, so it is a call only if it is the operand
+// of a CALL, JMP or Jcc with a 32-bit displacement. The ModRM byte of a
+// RIP-relative operand never looks like one of these opcodes. Only code is
+// decoded, since a byte of data may happen to equal one of them.
+bool X86_64LinkingContext::isCallReference(const DefinedAtom &atom,
+                                           const Reference &r) const {
+  if (r.kindNamespace() != Reference::KindNamespace::ELF)
+    return false;
+  if (atom.contentType() != DefinedAtom::typeCode)
+    return false;
+  assert(r.kindArch() == Reference::KindArch::x86_64);
+  switch (r.kindValue()) {
+  case llvm::ELF::R_X86_64_PLT32:
+    return true;
+  case llvm::ELF::R_X86_64_PC32: {
+    ArrayRef<uint8_t> content = atom.rawContent();
+    uint64_t offset = r.offsetInAtom();
+    if (offset == 0 || offset > content.size())
+      return false;
+    uint8_t opcode = content[offset - 1];
+    if (opcode == 0xE8 || opcode == 0xE9) // CALL, JMP
+      return true;
+    return offset >= 2 && content[offset - 2] == 0x0F &&
+           (opcode & 0xF0) == 0x80; // Jcc
+  }
+  default:
+    return false;
+  }
+}
+
 std::unique_ptr<ELFLinkingContext>
 elf::createX86_64LinkingContext(llvm::Triple triple) {
   if (triple.getArch() == llvm::Triple::x86_64)
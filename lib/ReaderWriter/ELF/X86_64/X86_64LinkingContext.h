@@ -96,6 +96,16 @@ public:
       return false;
     }
   }
+
+  bool isCallReference(const DefinedAtom &atom,
+                       const Reference &r) const override;
+
+  bool isPackableRelativeReloc(const Reference &r) const override {
+    if (r.kindNamespace() != Reference::KindNamespace::ELF)
+      return false;
+    assert(r.kindArch() == Reference::KindArch::x86_64);
+    return r.kindValue() == llvm::ELF::R_X86_64_RELATIVE;
+  }
 };
 } // end namespace elf
 } // end namespace lld
@@ -62,9 +62,9 @@ static void relocPC64(uint8_t *location, uint64_t P, uint64_t S, uint64_t A) {
 }
 
 std::error_code X86_64TargetRelocationHandler::applyRelocation(
-    ELFWriter &writer, llvm::FileOutputBuffer &buf, const AtomLayout &atom,
+    ELFWriter &writer, uint8_t *buf, const AtomLayout &atom,
     const Reference &ref) const {
-  uint8_t *atomContent = buf.getBufferStart() + atom._fileOffset;
+  uint8_t *atomContent = buf + atom._fileOffset;
   uint8_t *loc = atomContent + ref.offsetInAtom();
   uint64_t target = writer.addressOfAtom(ref.target());
   uint64_t reloc = atom._virtualAddr + ref.offsetInAtom();
@@ -78,6 +78,11 @@ std::error_code X86_64TargetRelocationHandler::applyRelocation(
   case R_X86_64_64:
     reloc64(loc, reloc, target, ref.addend());
     break;
+  case R_X86_64_RELATIVE:
+    // Also store the value in place; the packed .relr.dyn format has no
+    // addend field of its own.
+    reloc64(loc, reloc, target, ref.addend());
+    break;
   case R_X86_64_PC32:
   case R_X86_64_GOTPCREL:
     relocPC32(loc, reloc, target, ref.addend());
@@ -135,7 +140,6 @@ std::error_code X86_64TargetRelocationHandler::applyRelocation(
     break;
   }
   // Runtime only relocations. Ignore here.
-  case R_X86_64_RELATIVE:
   case R_X86_64_IRELATIVE:
   case R_X86_64_JUMP_SLOT:
   case R_X86_64_GLOB_DAT:
@@ -21,7 +21,7 @@ public:
   X86_64TargetRelocationHandler(X86_64TargetLayout &layout)
       : _tlsSize(0), _layout(layout) {}
 
-  std::error_code applyRelocation(ELFWriter &, llvm::FileOutputBuffer &,
+  std::error_code applyRelocation(ELFWriter &, uint8_t *,
                                   const AtomLayout &,
                                   const Reference &) const override;
 
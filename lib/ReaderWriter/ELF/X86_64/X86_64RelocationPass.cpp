@@ -21,6 +21,7 @@
 
 #include "X86_64RelocationPass.h"
 #include "Atoms.h"
+#include "ReferenceScan.h"
 #include "X86_64LinkingContext.h"
 #include "lld/Core/Simple.h"
 #include "llvm/ADT/DenseMap.h"
@@ -135,6 +136,41 @@ template <class Derived> class RelocationPass : public Pass {
     }
   }
 
+  /// \brief Returns false if handleReference would leave \p ref alone.
+  static bool mayNeedHandling(const Reference &ref) {
+    if (ref.kindNamespace() != Reference::KindNamespace::ELF)
+      return false;
+    switch (ref.kindValue()) {
+    case R_X86_64_16:
+    case R_X86_64_32:
+    case R_X86_64_32S:
+    case R_X86_64_64:
+    case R_X86_64_PC16:
+    case R_X86_64_PC32:
+    case R_X86_64_PC64:
+      return mayRedirectPlainReference(ref.target());
+    case R_X86_64_PLT32:
+    case R_X86_64_GOT32:
+    case R_X86_64_GOTPC32:
+    case R_X86_64_GOTPCREL:
+    case R_X86_64_GOTOFF64:
+    case R_X86_64_GOTTPOFF:
+    case R_X86_64_TLSGD:
+      return true;
+    default:
+      return false;
+    }
+  }
+
+  /// \brief Returns true if \p ref is an R_X86_64_64 that the dynamic loader
+  /// can apply by adding the load address alone.
+  static bool isRelativeCandidate(const DefinedAtom &atom,
+                                  const Reference &ref) {
+    return ref.kindNamespace() == Reference::KindNamespace::ELF &&
+           ref.kindValue() == R_X86_64_64 &&
+           canUseRelativeReloc(atom, ref.target());
+  }
+
 protected:
   /// \brief get the PLT entry for a given IFUNC Atom.
   ///
@@ -215,7 +251,9 @@ protected:
     auto got = _gotMap.find(da);
     if (got == _gotMap.end()) {
       auto g = new (_file._alloc) X86_64GOTAtom(_file, ".got");
-      g->addReferenceELF_x86_64(R_X86_64_64, 0, da, 0);
+      bool relative = _relativeRelocs && canUseRelativeReloc(*g, da);
+      g->addReferenceELF_x86_64(relative ? R_X86_64_RELATIVE : R_X86_64_64, 0,
+                                da, 0);
 #ifndef NDEBUG
       g->_name = "__got_";
       g->_name += da->name();
@@ -243,7 +281,8 @@ protected:
   }
 
 public:
-  RelocationPass(const ELFLinkingContext &ctx) : _file(ctx), _ctx(ctx) {}
+  RelocationPass(const ELFLinkingContext &ctx, bool relativeRelocs = false)
+      : _file(ctx), _ctx(ctx), _relativeRelocs(relativeRelocs) {}
 
   /// \brief Do the pass.
   ///
@@ -253,12 +292,26 @@ public:
   ///
   /// After all references are handled, the atoms created during that are all
   /// added to mf.
+  ///
+  /// Most references need no GOT or PLT entry, so they are filtered out in
+  /// parallel first. The rest are handled serially in their original order so
+  /// that the created atoms come out in a stable order. Absolute words that
+  /// only need the load address added are turned into R_X86_64_RELATIVE
+  /// while filtering, as they need no new atom.
   void perform(std::unique_ptr<SimpleFile> &mf) override {
     ScopedTask task(getDefaultDomain(), "X86-64 GOT/PLT Pass");
+    std::vector<AtomReference> refs = scanReferences(
+        *mf, [this](const DefinedAtom &atom, const Reference &ref) {
+          if (_relativeRelocs && isRelativeCandidate(atom, ref)) {
+            const_cast<Reference &>(ref).setKindValue(R_X86_64_RELATIVE);
+            return false;
+          }
+          return mayNeedHandling(ref);
+        });
+
     // Process all references.
-    for (const auto &atom : mf->defined())
-      for (const auto &ref : *atom)
-        handleReference(*atom, *ref);
+    for (const AtomReference &ar : refs)
+      handleReference(*ar.first, *ar.second);
 
     // Add all created atoms to the link.
     uint64_t ordinal = 0;
@@ -299,6 +352,10 @@ protected:
   ELFPassFile _file;
   const ELFLinkingContext &_ctx;
 
+  /// \brief Use R_X86_64_RELATIVE for absolute words to atoms defined in the
+  /// link, so that a shared object can be loaded anywhere.
+  const bool _relativeRelocs;
+
   /// \brief Map Atoms to their GOT entries.
   llvm::DenseMap<const Atom *, GOTAtom *> _gotMap;
 
@@ -374,7 +431,8 @@ class DynamicRelocationPass final
     : public RelocationPass<DynamicRelocationPass> {
 public:
   DynamicRelocationPass(const elf::X86_64LinkingContext &ctx)
-      : RelocationPass(ctx) {}
+      : RelocationPass(ctx, ctx.getOutputELFType() == llvm::ELF::ET_DYN &&
+                                ctx.packRelativeRelocs()) {}
 
   const PLT0Atom *getPLT0() {
     if (_plt0)
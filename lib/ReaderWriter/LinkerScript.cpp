@@ -13,6 +13,7 @@
 //===----------------------------------------------------------------------===//
 
 #include "lld/ReaderWriter/LinkerScript.h"
+#include "lld/Core/Parallel.h"
 
 namespace lld {
 namespace script {
@@ -241,24 +242,45 @@ static llvm::ErrorOr<uint64_t> parseNum(StringRef str) {
   return res;
 }
 
-bool Lexer::canStartNumber(char c) const {
-  return '0' <= c && c <= '9';
-}
+namespace {
+// Character classes recognized by the lexer: number start, number
+// continuation ([xX] = hex marker, [hHoO] = type suffix, [MK] = scale suffix),
+// name start and name continuation.
+enum CharClass : uint8_t { NS = 1, NC = 2, AS = 4, AC = 8 };
+} // end anonymous namespace
 
-bool Lexer::canContinueNumber(char c) const {
-  // [xX] = hex marker, [hHoO] = type suffix, [MK] = scale suffix.
-  return strchr("0123456789ABCDEFabcdefxXhHoOMK", c);
-}
+// Classes of each character, indexed by its unsigned value. Characters outside
+// of ASCII belong to no class.
+static const uint8_t charClasses[256] = {
+  0,        0,        0,        0,        0,        0,        0,        0,
+  0,        0,        0,        0,        0,        0,        0,        0,
+  0,        0,        0,        0,        0,        0,        0,        0,
+  0,        0,        0,        0,        0,        0,        0,        0,
+  0,        0,        0,        0,        AS|AC,    0,        0,        0,
+  0,        0,        AS|AC,    AC,       0,        AC,       AS|AC,    AS|AC,
+  NS|NC|AC, NS|NC|AC, NS|NC|AC, NS|NC|AC, NS|NC|AC, NS|NC|AC, NS|NC|AC, NS|NC|AC,
+  NS|NC|AC, NS|NC|AC, AC,       0,        0,        AC,       0,        AC,
+  0,        NC|AS|AC, NC|AS|AC, NC|AS|AC, NC|AS|AC, NC|AS|AC, NC|AS|AC, AS|AC,
+  NC|AS|AC, AS|AC,    AS|AC,    NC|AS|AC, AS|AC,    NC|AS|AC, AS|AC,    NC|AS|AC,
+  AS|AC,    AS|AC,    AS|AC,    AS|AC,    AS|AC,    AS|AC,    AS|AC,    AS|AC,
+  NC|AS|AC, AS|AC,    AS|AC,    AC,       AS|AC,    AC,       0,        AS|AC,
+  0,        NC|AS|AC, NC|AS|AC, NC|AS|AC, NC|AS|AC, NC|AS|AC, NC|AS|AC, AS|AC,
+  NC|AS|AC, AS|AC,    AS|AC,    AS|AC,    AS|AC,    AS|AC,    AS|AC,    NC|AS|AC,
+  AS|AC,    AS|AC,    AS|AC,    AS|AC,    AS|AC,    AS|AC,    AS|AC,    AS|AC,
+  NC|AS|AC, AS|AC,    AS|AC,    0,        0,        0,        AC,       0,
+};
 
-bool Lexer::canStartName(char c) const {
-  return strchr(
-    "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz_.$/\\*", c);
+static bool hasCharClass(char c, uint8_t cls) {
+  return charClasses[static_cast<unsigned char>(c)] & cls;
 }
 
-bool Lexer::canContinueName(char c) const {
-  return strchr("ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz"
-                "0123456789_.$/\\~=+[]*?-:", c);
-}
+bool Lexer::canStartNumber(char c) const { return hasCharClass(c, NS); }
+
+bool Lexer::canContinueNumber(char c) const { return hasCharClass(c, NC); }
+
+bool Lexer::canStartName(char c) const { return hasCharClass(c, AS); }
+
+bool Lexer::canContinueName(char c) const { return hasCharClass(c, AC); }
 
 /// Helper function to split a StringRef in two at the nth character.
 /// The StringRef s is updated, while the function returns the n first
@@ -517,7 +539,7 @@ void Lexer::skipWhitespace() {
       _buffer = _buffer.drop_front();
       break;
     // Potential comment.
-    case '/':
+    case '/': {
       if (_buffer.size() <= 1 || _buffer[1] != '*')
         return;
       // Skip starting /*
@@ -526,15 +548,12 @@ void Lexer::skipWhitespace() {
       if (!_buffer.empty() && _buffer[0] == '/')
         _buffer = _buffer.drop_front();
 
-      // Scan for /'s. We're done if it is preceded by a *.
-      while (true) {
-        if (_buffer.empty())
-          break;
-        _buffer = _buffer.drop_front();
-        if (_buffer.data()[-1] == '/' && _buffer.data()[-2] == '*')
-          break;
-      }
+      // Skip past the closing */, or to the end of the buffer.
+      size_t end = _buffer.find("*/");
+      _buffer = _buffer.drop_front(end == StringRef::npos ? _buffer.size()
+                                                          : end + 2);
       break;
+    }
     default:
       return;
     }
@@ -584,13 +603,8 @@ void Unary::dump(raw_ostream &os) const {
   os << ")";
 }
 
-ErrorOr<int64_t> Unary::evalExpr(SymbolTableTy &symbolTable) const {
-  auto child = _child->evalExpr(symbolTable);
-  if (child.getError())
-    return child.getError();
-
-  int64_t childRes = *child;
-  switch (_op) {
+static int64_t applyUnary(Unary::Operation op, int64_t childRes) {
+  switch (op) {
   case Unary::Minus:
     return -childRes;
   case Unary::Not:
@@ -600,6 +614,13 @@ ErrorOr<int64_t> Unary::evalExpr(SymbolTableTy &symbolTable) const {
   llvm_unreachable("");
 }
 
+ErrorOr<int64_t> Unary::evalExpr(SymbolTableTy &symbolTable) const {
+  auto child = _child->evalExpr(symbolTable);
+  if (child.getError())
+    return child.getError();
+  return applyUnary(_op, *child);
+}
+
 // BinOp functions
 void BinOp::dump(raw_ostream &os) const {
   os << "(";
@@ -654,6 +675,28 @@ void BinOp::dump(raw_ostream &os) const {
   os << ")";
 }
 
+static int64_t applyBinOp(BinOp::Operation op, int64_t lhsRes,
+                          int64_t rhsRes) {
+  switch(op) {
+  case BinOp::And:                 return lhsRes & rhsRes;
+  case BinOp::CompareDifferent:    return lhsRes != rhsRes;
+  case BinOp::CompareEqual:        return lhsRes == rhsRes;
+  case BinOp::CompareGreater:      return lhsRes > rhsRes;
+  case BinOp::CompareGreaterEqual: return lhsRes >= rhsRes;
+  case BinOp::CompareLess:         return lhsRes < rhsRes;
+  case BinOp::CompareLessEqual:    return lhsRes <= rhsRes;
+  case BinOp::Div:                 return lhsRes / rhsRes;
+  case BinOp::Mul:                 return lhsRes * rhsRes;
+  case BinOp::Or:                  return lhsRes | rhsRes;
+  case BinOp::Shl:                 return lhsRes << rhsRes;
+  case BinOp::Shr:                 return lhsRes >> rhsRes;
+  case BinOp::Sub:                 return lhsRes - rhsRes;
+  case BinOp::Sum:                 return lhsRes + rhsRes;
+  }
+
+  llvm_unreachable("");
+}
+
 ErrorOr<int64_t> BinOp::evalExpr(SymbolTableTy &symbolTable) const {
   auto lhs = _lhs->evalExpr(symbolTable);
   if (lhs.getError())
@@ -661,28 +704,7 @@ ErrorOr<int64_t> BinOp::evalExpr(SymbolTableTy &symbolTable) const {
   auto rhs = _rhs->evalExpr(symbolTable);
   if (rhs.getError())
     return rhs.getError();
-
-  int64_t lhsRes = *lhs;
-  int64_t rhsRes = *rhs;
-
-  switch(_op) {
-  case And:                 return lhsRes & rhsRes;
-  case CompareDifferent:    return lhsRes != rhsRes;
-  case CompareEqual:        return lhsRes == rhsRes;
-  case CompareGreater:      return lhsRes > rhsRes;
-  case CompareGreaterEqual: return lhsRes >= rhsRes;
-  case CompareLess:         return lhsRes < rhsRes;
-  case CompareLessEqual:    return lhsRes <= rhsRes;
-  case Div:                 return lhsRes / rhsRes;
-  case Mul:                 return lhsRes * rhsRes;
-  case Or:                  return lhsRes | rhsRes;
-  case Shl:                 return lhsRes << rhsRes;
-  case Shr:                 return lhsRes >> rhsRes;
-  case Sub:                 return lhsRes - rhsRes;
-  case Sum:                 return lhsRes + rhsRes;
-  }
-
-  llvm_unreachable("");
+  return applyBinOp(_op, *lhs, *rhs);
 }
 
 // TernaryConditional functions
@@ -704,6 +726,54 @@ TernaryConditional::evalExpr(SymbolTableTy &symbolTable) const {
   return _falseExpr->evalExpr(symbolTable);
 }
 
+// CompiledExpr functions
+ErrorOr<int64_t> CompiledExpr::eval(ArrayRef<Slot> slots) const {
+  SmallVector<int64_t, 16> stack;
+  size_t pc = 0;
+  while (pc != _code.size()) {
+    const Insn &insn = _code[pc++];
+    switch (insn._kind) {
+    case Insn::Push:
+      stack.push_back(insn._operand);
+      break;
+    case Insn::Load: {
+      const Slot &slot = slots[insn._operand];
+      if (!slot._defined)
+        return LinkerScriptReaderError::unknown_symbol_in_expr;
+      stack.push_back(slot._value);
+      break;
+    }
+    case Insn::UnaryOp:
+      stack.back() =
+          applyUnary(static_cast<Unary::Operation>(insn._op), stack.back());
+      break;
+    case Insn::BinaryOp: {
+      int64_t rhs = stack.pop_back_val();
+      stack.back() = applyBinOp(static_cast<BinOp::Operation>(insn._op),
+                                stack.back(), rhs);
+      break;
+    }
+    case Insn::JumpIfZero:
+      if (stack.pop_back_val() == 0)
+        pc = insn._operand;
+      break;
+    case Insn::Jump:
+      pc = insn._operand;
+      break;
+    case Insn::Call:
+      return LinkerScriptReaderError::unrecognized_function_in_expr;
+    }
+  }
+  assert(stack.size() == 1 && "Unbalanced expression program");
+  return stack.back();
+}
+
+void CompiledExpr::getLoadedSlots(SmallVectorImpl<unsigned> &slots) const {
+  for (const Insn &insn : _code)
+    if (insn._kind == Insn::Load)
+      slots.push_back(insn._operand);
+}
+
 // SymbolAssignment functions
 void SymbolAssignment::dump(raw_ostream &os) const {
   int numParen = 0;
@@ -2145,11 +2215,13 @@ Extern *Parser::parseExtern() {
 Sema::Sema()
     : _scripts(), _layoutCommands(), _memberToLayoutOrder(),
       _memberNameWildcards(), _cacheSectionOrder(), _cacheExpressionOrder(),
-      _deliveredExprs(), _symbolTable() {}
+      _deliveredExprs() {}
 
 void Sema::perform() {
   for (auto &parser : _scripts)
     perform(parser->get());
+  compilePatterns();
+  compileExpressions();
 }
 
 bool Sema::less(const SectionKey &lhs, const SectionKey &rhs) const {
@@ -2216,19 +2288,29 @@ Sema::getExprs(const SectionKey &key) {
 
 std::error_code Sema::evalExpr(const SymbolAssignment *assgn,
                                uint64_t &curPos) {
-  _symbolTable[StringRef(".")] = curPos;
+  auto id = _assignmentIds.find(assgn);
+  assert(id != _assignmentIds.end() && "Expression was not compiled");
+  const CompiledAssignment &compiled = _assignments[id->second];
+  // The location counter is never assigned a precomputed value, so there is
+  // nothing left to do for those.
+  if (compiled._isConstant)
+    return std::error_code();
+
+  _slots[0]._value = curPos;
+  _slots[0]._defined = true;
 
-  auto ans = assgn->expr()->evalExpr(_symbolTable);
+  auto ans = compiled._expr.eval(_slots);
   if (ans.getError())
     return ans.getError();
   uint64_t result = *ans;
 
-  if (assgn->symbol() == ".") {
+  if (compiled._slot == 0) {
     curPos = result;
     return std::error_code();
   }
 
-  _symbolTable[assgn->symbol()] = result;
+  _slots[compiled._slot]._value = result;
+  _slots[compiled._slot]._defined = true;
   return std::error_code();
 }
 
@@ -2249,9 +2331,10 @@ const llvm::StringSet<> &Sema::getScriptDefinedSymbols() const {
 }
 
 uint64_t Sema::getLinkerScriptExprValue(StringRef name) const {
-  auto it = _symbolTable.find(name);
-  assert (it != _symbolTable.end() && "Invalid symbol name!");
-  return it->second;
+  auto it = _symbolSlots.find(name);
+  assert (it != _symbolSlots.end() && _slots[it->second]._defined &&
+          "Invalid symbol name!");
+  return _slots[it->second]._value;
 }
 
 void Sema::dump() const {
@@ -2271,66 +2354,149 @@ void Sema::dump() const {
   }
 }
 
-/// Given a string "pattern" with wildcard characters, return true if it
-/// matches "name". This function is useful when checking if a given name
-/// pattern written in the linker script, i.e. ".text*", should match
-/// ".text.anytext".
-static bool wildcardMatch(StringRef pattern, StringRef name) {
-  auto i = name.begin();
+static bool hasWildcard(StringRef name) {
+  for (auto ch : name)
+    if (ch == '*' || ch == '?' || ch == '[' || ch == '\\')
+      return true;
+  return false;
+}
 
-  // Check if each char in pattern also appears in our input name, handling
-  // special wildcard characters.
-  for (auto j = pattern.begin(), e = pattern.end(); j != e; ++j) {
-    if (i == name.end())
-      return false;
+WildcardPattern::WildcardPattern(StringRef pattern) : _pattern(pattern) {
+  if (!hasWildcard(pattern)) {
+    _kind = Kind::Exact;
+    _literal = pattern;
+    return;
+  }
+  if (pattern == "*") {
+    _kind = Kind::Any;
+    return;
+  }
+  StringRef prefix = pattern.drop_back();
+  if (pattern.back() == '*' && !hasWildcard(prefix)) {
+    _kind = Kind::Prefix;
+    _literal = prefix;
+    return;
+  }
 
-    switch (*j) {
+  // A '*' matches one or more characters, so we compile it as '?' followed by
+  // a gap of zero or more characters. Each gap starts a new segment.
+  _kind = Kind::General;
+  _segments.push_back(0);
+  for (size_t i = 0, e = pattern.size(); i != e; ++i) {
+    Element elem;
+    elem._char = pattern[i];
+    elem._type = Element::Char;
+    switch (pattern[i]) {
     case '*':
-      while (!wildcardMatch(pattern.drop_front(j - pattern.begin() + 1),
-                            name.drop_front(i - name.begin() + 1))) {
-        if (i == name.end())
-          return false;
-        ++i;
-      }
-      break;
+      elem._type = Element::AnyChar;
+      _elements.push_back(elem);
+      _segments.push_back(_elements.size());
+      continue;
     case '?':
-      // Matches any character
+      elem._type = Element::AnyChar;
       break;
     case '[': {
-      // Matches a range of characters specified between brackets
-      size_t end = pattern.find(']', j - pattern.begin());
-      if (end == pattern.size())
-        return false;
-
-      StringRef chars = pattern.slice(j - pattern.begin(), end);
-      if (chars.find(i) == StringRef::npos)
-        return false;
-
-      j = pattern.begin() + end;
+      size_t close = pattern.find(']', i + 1);
+      if (close == StringRef::npos)
+        break;
+      elem._type = Element::CharSet;
+      elem._set = pattern.slice(i + 1, close);
+      i = close;
       break;
     }
     case '\\':
-      ++j;
-      if (*j != *i)
+      if (i + 1 != e)
+        elem._char = pattern[++i];
+      break;
+    }
+    _elements.push_back(elem);
+  }
+  _segments.push_back(_elements.size());
+}
+
+static bool matchCharSet(StringRef set, char c) {
+  for (size_t i = 0, e = set.size(); i != e; ++i) {
+    if (i + 2 < e && set[i + 1] == '-') {
+      if (set[i] <= c && c <= set[i + 2])
+        return true;
+      i += 2;
+      continue;
+    }
+    if (set[i] == c)
+      return true;
+  }
+  return false;
+}
+
+/// Returns true if segment \p seg matches \p name at \p pos. The caller makes
+/// sure the segment fits.
+bool WildcardPattern::matchSegment(size_t seg, StringRef name,
+                                   size_t pos) const {
+  for (size_t i = _segments[seg], e = _segments[seg + 1]; i != e; ++i, ++pos) {
+    const Element &elem = _elements[i];
+    switch (elem._type) {
+    case Element::Char:
+      if (name[pos] != elem._char)
         return false;
       break;
-    default:
-      // No wildcard character means we must match exactly the same char
-      if (*j != *i)
+    case Element::AnyChar:
+      break;
+    case Element::CharSet:
+      if (!matchCharSet(elem._set, name[pos]))
         return false;
       break;
     }
-    ++i;
+  }
+  return true;
+}
+
+/// Given a name, return true if the pattern matches it. This is useful when
+/// checking if a given name pattern written in the linker script, i.e.
+/// ".text*", should match ".text.anytext".
+bool WildcardPattern::match(StringRef name) const {
+  switch (_kind) {
+  case Kind::Exact:
+    return name == _literal;
+  case Kind::Prefix:
+    return name.size() > _literal.size() && name.startswith(_literal);
+  case Kind::Any:
+    return !name.empty();
+  case Kind::General:
+    break;
   }
 
-  // If our pattern has't consumed the entire string, it is not a match
-  return i == name.end();
+  // The first segment is anchored at the start of the name and the last one
+  // at the end. The ones in between are matched at their leftmost position,
+  // which is enough since the gaps between them can absorb any characters.
+  size_t numSegments = _segments.size() - 1;
+  size_t firstSize = segmentSize(0);
+  if (numSegments == 1)
+    return name.size() == firstSize && matchSegment(0, name, 0);
+  size_t lastSize = segmentSize(numSegments - 1);
+  if (name.size() < firstSize + lastSize || !matchSegment(0, name, 0))
+    return false;
+  size_t lastPos = name.size() - lastSize;
+  if (!matchSegment(numSegments - 1, name, lastPos))
+    return false;
+  size_t pos = firstSize;
+  for (size_t seg = 1; seg + 1 < numSegments; ++seg) {
+    size_t size = segmentSize(seg);
+    for (;;) {
+      if (pos + size > lastPos)
+        return false;
+      if (matchSegment(seg, name, pos))
+        break;
+      ++pos;
+    }
+    pos += size;
+  }
+  return true;
 }
 
 int Sema::matchSectionName(int id, const SectionKey &key) const {
   const InputSectionsCmd *cmd = dyn_cast<InputSectionsCmd>(_layoutCommands[id]);
 
-  if (!cmd || !wildcardMatch(cmd->archiveName(), key.archivePath))
+  if (!cmd || !getPattern(cmd).match(key.archivePath))
     return -1;
 
   while ((size_t)++id < _layoutCommands.size() &&
@@ -2338,9 +2504,7 @@ int Sema::matchSectionName(int id, const SectionKey &key) const {
     if (isa<InputSectionSortedGroup>(_layoutCommands[id]))
       continue;
 
-    const InputSectionName *in =
-        dyn_cast<InputSectionName>(_layoutCommands[id]);
-    if (wildcardMatch(in->name(), key.sectionName))
+    if (getPattern(_layoutCommands[id]).match(key.sectionName))
       return id;
   }
   return -1;
@@ -2358,46 +2522,87 @@ int Sema::getLayoutOrder(const SectionKey &key, bool coarse) const {
       return entry->second;
   }
 
+  int exprOrder;
+  int order = findLayoutOrder(key, exprOrder);
+  _cacheSectionOrder.insert(std::make_pair(key, order));
+  _cacheExpressionOrder.insert(std::make_pair(key, exprOrder));
+  return coarse ? order : exprOrder;
+}
+
+int Sema::findLayoutOrder(const SectionKey &key, int &exprOrder) const {
   // Try to match exact file name
   auto range = _memberToLayoutOrder.equal_range(key.memberPath);
   for (auto I = range.first, E = range.second; I != E; ++I) {
     int order = I->second;
-    int exprOrder = -1;
-
-    if ((exprOrder = matchSectionName(order, key)) >= 0) {
-      if (coarse) {
-        _cacheSectionOrder.insert(std::make_pair(key, order));
-        return order;
-      }
-      _cacheExpressionOrder.insert(std::make_pair(key, exprOrder));
-      return exprOrder;
-    }
+    if ((exprOrder = matchSectionName(order, key)) >= 0)
+      return order;
   }
 
   // If we still couldn't find a rule for this input section, try to match
-  // wildcards
-  for (auto I = _memberNameWildcards.begin(), E = _memberNameWildcards.end();
-       I != E; ++I) {
-    if (!wildcardMatch(I->first, key.memberPath))
+  // wildcards. Only the rules with a section name pattern that may match are
+  // tried.
+  SmallVector<unsigned, 16> rules;
+  getCandidateRules(key.sectionName, rules);
+  for (unsigned rule : rules) {
+    const std::pair<WildcardPattern, int> &entry = _memberNameWildcards[rule];
+    if (!entry.first.match(key.memberPath))
       continue;
-    int order = I->second;
-    int exprOrder = -1;
-
-    if ((exprOrder = matchSectionName(order, key)) >= 0) {
-      if (coarse) {
-        _cacheSectionOrder.insert(std::make_pair(key, order));
-        return order;
-      }
-      _cacheExpressionOrder.insert(std::make_pair(key, exprOrder));
-      return exprOrder;
-    }
+    int order = entry.second;
+    if ((exprOrder = matchSectionName(order, key)) >= 0)
+      return order;
   }
 
-  _cacheSectionOrder.insert(std::make_pair(key, -1));
-  _cacheExpressionOrder.insert(std::make_pair(key, -1));
+  exprOrder = -1;
   return -1;
 }
 
+std::vector<size_t> Sema::getLayoutPermutation(ArrayRef<SectionKey> keys) {
+  size_t numKeys = keys.size();
+  std::vector<int> orders(numKeys);
+  std::vector<int> exprOrders(numKeys);
+  parallel_for(0, numKeys, [&](size_t i) {
+    orders[i] = findLayoutOrder(keys[i], exprOrders[i]);
+  });
+  for (size_t i = 0; i != numKeys; ++i) {
+    _cacheSectionOrder.insert(std::make_pair(keys[i], orders[i]));
+    _cacheExpressionOrder.insert(std::make_pair(keys[i], exprOrders[i]));
+  }
+
+  // Group the mapped sections by rule. The keys are unique, so the parallel
+  // sort gives the same order a stable sort would.
+  std::vector<std::pair<int, size_t>> mapped;
+  for (size_t i = 0; i != numKeys; ++i)
+    if (orders[i] >= 0)
+      mapped.push_back(std::make_pair(orders[i], i));
+  parallel_sort(mapped.begin(), mapped.end(),
+                std::less<std::pair<int, size_t>>());
+
+  // Order the sections within each rule as written in the rule.
+  std::vector<size_t> result(mapped.size());
+  std::vector<std::pair<size_t, size_t>> groups;
+  for (size_t i = 0, e = mapped.size(); i != e; ++i) {
+    result[i] = mapped[i].second;
+    if (i == 0 || mapped[i].first != mapped[i - 1].first)
+      groups.push_back(std::make_pair(i, i + 1));
+    else
+      groups.back().second = i + 1;
+  }
+  parallel_for(0, groups.size(), [&](size_t g) {
+    int order = mapped[groups[g].first].first;
+    std::stable_sort(result.begin() + groups[g].first,
+                     result.begin() + groups[g].second,
+                     [&](size_t a, size_t b) {
+                       return localCompare(order, keys[a], keys[b]);
+                     });
+  });
+
+  // Sections without a mapping rule keep their relative order at the end.
+  for (size_t i = 0; i != numKeys; ++i)
+    if (orders[i] < 0)
+      result.push_back(i);
+  return result;
+}
+
 static bool compareSortedNames(WildcardSortMode sortMode, StringRef lhs,
                                StringRef rhs) {
   switch (sortMode) {
@@ -2420,11 +2625,11 @@ static bool compareSortedNames(WildcardSortMode sortMode, StringRef lhs,
   return false;
 }
 
-static bool sortedGroupContains(const InputSectionSortedGroup *cmd,
-                                const Sema::SectionKey &key) {
+bool Sema::sortedGroupContains(const InputSectionSortedGroup *cmd,
+                               const SectionKey &key) const {
   for (const InputSection *child : *cmd) {
     if (auto i = dyn_cast<InputSectionName>(child)) {
-      if (wildcardMatch(i->name(), key.sectionName))
+      if (getPattern(i).match(key.sectionName))
         return true;
       continue;
     }
@@ -2461,10 +2666,11 @@ bool Sema::localCompare(int order, const SectionKey &lhs,
     if (auto i = dyn_cast<InputSectionName>(inputSection)) {
       // If both match, return false (both have equal priority)
       // If rhs match, return false (rhs has higher priority)
-      if (wildcardMatch(i->name(), rhs.sectionName))
+      const WildcardPattern &pattern = getPattern(i);
+      if (pattern.match(rhs.sectionName))
         return false;
       //  If lhs matches first, it has priority over rhs
-      if (wildcardMatch(i->name(), lhs.sectionName))
+      if (pattern.match(lhs.sectionName))
         return true;
       continue;
     }
@@ -2490,13 +2696,6 @@ bool Sema::localCompare(int order, const SectionKey &lhs,
   return false;
 }
 
-static bool hasWildcard(StringRef name) {
-  for (auto ch : name)
-    if (ch == '*' || ch == '?' || ch == '[' || ch == '\\')
-      return true;
-  return false;
-}
-
 void Sema::linearizeAST(const InputSection *inputSection) {
   if (isa<InputSectionName>(inputSection)) {
     _layoutCommands.push_back(inputSection);
@@ -2515,8 +2714,8 @@ void Sema::linearizeAST(const InputSectionsCmd *inputSections) {
   StringRef memberName = inputSections->memberName();
   // Populate our maps for fast lookup of InputSectionsCmd
   if (hasWildcard(memberName))
-    _memberNameWildcards.push_back(
-        std::make_pair(memberName, (int)_layoutCommands.size()));
+    _memberNameWildcards.push_back(std::make_pair(
+        WildcardPattern(memberName), (int)_layoutCommands.size()));
   else if (!memberName.empty())
     _memberToLayoutOrder.insert(
         std::make_pair(memberName.str(), (int)_layoutCommands.size()));
@@ -2560,5 +2759,228 @@ void Sema::perform(const LinkerScript *ls) {
   }
 }
 
+static void compileSortedGroup(
+    const InputSectionSortedGroup *group,
+    llvm::DenseMap<const Command *, WildcardPattern> &patterns) {
+  for (const InputSection *child : *group) {
+    if (auto *in = dyn_cast<InputSectionName>(child))
+      patterns[in] = WildcardPattern(in->name());
+    else
+      compileSortedGroup(cast<InputSectionSortedGroup>(child), patterns);
+  }
+}
+
+void Sema::compilePatterns() {
+  _patterns.clear();
+  for (const Command *c : _layoutCommands) {
+    if (auto *cmd = dyn_cast<InputSectionsCmd>(c)) {
+      _patterns[cmd] = WildcardPattern(cmd->archiveName());
+      // localCompare walks the sorted groups of a command as well.
+      for (const InputSection *in : *cmd)
+        if (auto *group = dyn_cast<InputSectionSortedGroup>(in))
+          compileSortedGroup(group, _patterns);
+    } else if (auto *in = dyn_cast<InputSectionName>(c)) {
+      _patterns[in] = WildcardPattern(in->name());
+    }
+  }
+
+  _exactNameRules.clear();
+  _prefixNameRules.clear();
+  _prefixLengths.clear();
+  _otherNameRules.clear();
+  for (unsigned rule = 0, e = _memberNameWildcards.size(); rule != e; ++rule) {
+    bool isOther = false;
+    size_t id = _memberNameWildcards[rule].second;
+    while (++id < _layoutCommands.size() &&
+           isa<InputSection>(_layoutCommands[id])) {
+      if (!isa<InputSectionName>(_layoutCommands[id]))
+        continue;
+      const WildcardPattern &pattern = getPattern(_layoutCommands[id]);
+      std::vector<unsigned> *rules = nullptr;
+      if (pattern.isExact()) {
+        rules = &_exactNameRules[pattern.literal()];
+      } else if (pattern.isPrefix()) {
+        rules = &_prefixNameRules[pattern.literal()];
+        _prefixLengths.push_back(pattern.literal().size());
+      } else {
+        isOther = true;
+        continue;
+      }
+      if (rules->empty() || rules->back() != rule)
+        rules->push_back(rule);
+    }
+    if (isOther)
+      _otherNameRules.push_back(rule);
+  }
+  std::sort(_prefixLengths.begin(), _prefixLengths.end());
+  _prefixLengths.erase(
+      std::unique(_prefixLengths.begin(), _prefixLengths.end()),
+      _prefixLengths.end());
+}
+
+unsigned Sema::getSymbolSlot(StringRef name) {
+  auto it = _symbolSlots.find(name);
+  if (it != _symbolSlots.end())
+    return it->second;
+  unsigned slot = _slots.size();
+  _symbolSlots[name] = slot;
+  _slots.emplace_back();
+  return slot;
+}
+
+void Sema::compileExpr(const Expression *expr, CompiledExpr &out) {
+  typedef CompiledExpr::Insn Insn;
+  std::vector<Insn> &code = out._code;
+  auto emit = [&](Insn::Kind kind, uint8_t op, int64_t operand) {
+    Insn insn = {kind, op, operand};
+    code.push_back(insn);
+    return code.size() - 1;
+  };
+  auto isPush = [&](size_t i) { return code[i]._kind == Insn::Push; };
+
+  size_t start = code.size();
+  switch (expr->getKind()) {
+  case Expression::Kind::Constant:
+    emit(Insn::Push, 0, cast<Constant>(expr)->value());
+    return;
+  case Expression::Kind::Symbol:
+    emit(Insn::Load, 0, getSymbolSlot(cast<Symbol>(expr)->name()));
+    return;
+  case Expression::Kind::FunctionCall:
+    emit(Insn::Call, 0, 0);
+    return;
+  case Expression::Kind::Unary: {
+    auto *unary = cast<Unary>(expr);
+    compileExpr(unary->child(), out);
+    if (code.size() == start + 1 && isPush(start))
+      code[start]._operand = applyUnary(unary->op(), code[start]._operand);
+    else
+      emit(Insn::UnaryOp, unary->op(), 0);
+    return;
+  }
+  case Expression::Kind::BinOp: {
+    auto *binOp = cast<BinOp>(expr);
+    compileExpr(binOp->lhs(), out);
+    compileExpr(binOp->rhs(), out);
+    // Divisions by zero are left to evaluation time.
+    if (code.size() == start + 2 && isPush(start) && isPush(start + 1) &&
+        !(binOp->op() == BinOp::Div && code[start + 1]._operand == 0)) {
+      code[start]._operand = applyBinOp(binOp->op(), code[start]._operand,
+                                        code[start + 1]._operand);
+      code.pop_back();
+      return;
+    }
+    emit(Insn::BinaryOp, binOp->op(), 0);
+    return;
+  }
+  case Expression::Kind::TernaryConditional: {
+    auto *ternary = cast<TernaryConditional>(expr);
+    compileExpr(ternary->conditional(), out);
+    if (code.size() == start + 1 && isPush(start)) {
+      int64_t cond = code[start]._operand;
+      code.pop_back();
+      compileExpr(cond ? ternary->trueExpr() : ternary->falseExpr(), out);
+      return;
+    }
+    size_t jumpToFalse = emit(Insn::JumpIfZero, 0, 0);
+    compileExpr(ternary->trueExpr(), out);
+    size_t jumpToEnd = emit(Insn::Jump, 0, 0);
+    code[jumpToFalse]._operand = code.size();
+    compileExpr(ternary->falseExpr(), out);
+    code[jumpToEnd]._operand = code.size();
+    return;
+  }
+  }
+  llvm_unreachable("Unknown expression kind");
+}
+
+void Sema::compileExpressions() {
+  _assignments.clear();
+  _assignmentIds.clear();
+  _symbolSlots.clear();
+  _slots.clear();
+  getSymbolSlot(".");
+
+  for (const Command *c : _layoutCommands) {
+    auto *assgn = dyn_cast<SymbolAssignment>(c);
+    if (!assgn)
+      continue;
+    CompiledAssignment compiled;
+    compileExpr(assgn->expr(), compiled._expr);
+    compiled._slot = getSymbolSlot(assgn->symbol());
+    compiled._isConstant = false;
+    _assignmentIds[assgn] = _assignments.size();
+    _assignments.push_back(std::move(compiled));
+  }
+
+  // A symbol that is assigned once, by an expression that only reads other
+  // such symbols, has the same value in every layout pass. Evaluate those
+  // here in dependency order, which also resolves forward references among
+  // them. Everything else is left to evaluation in script order.
+  const int multipleDefs = -2;
+  std::vector<int> definer(_slots.size(), -1);
+  for (unsigned i = 0, e = _assignments.size(); i != e; ++i) {
+    int &def = definer[_assignments[i]._slot];
+    def = (def == -1) ? (int)i : multipleDefs;
+  }
+
+  std::vector<unsigned> pending(_assignments.size());
+  std::vector<std::vector<unsigned>> readers(_slots.size());
+  std::vector<unsigned> ready;
+  for (unsigned i = 0, e = _assignments.size(); i != e; ++i) {
+    const CompiledAssignment &compiled = _assignments[i];
+    if (compiled._slot == 0 || definer[compiled._slot] < 0)
+      continue;
+    SmallVector<unsigned, 8> reads;
+    compiled._expr.getLoadedSlots(reads);
+    std::sort(reads.begin(), reads.end());
+    reads.erase(std::unique(reads.begin(), reads.end()), reads.end());
+    bool isCandidate = true;
+    for (unsigned slot : reads)
+      if (slot == 0 || definer[slot] < 0)
+        isCandidate = false;
+    if (!isCandidate)
+      continue;
+    pending[i] = reads.size();
+    for (unsigned slot : reads)
+      readers[slot].push_back(i);
+    if (reads.empty())
+      ready.push_back(i);
+  }
+
+  while (!ready.empty()) {
+    CompiledAssignment &compiled = _assignments[ready.back()];
+    ready.pop_back();
+    // Errors are reported when evalExpr() evaluates the assignment again.
+    auto ans = compiled._expr.eval(_slots);
+    if (ans.getError())
+      continue;
+    _slots[compiled._slot]._value = *ans;
+    _slots[compiled._slot]._defined = true;
+    compiled._isConstant = true;
+    for (unsigned reader : readers[compiled._slot])
+      if (--pending[reader] == 0)
+        ready.push_back(reader);
+  }
+}
+
+void Sema::getCandidateRules(StringRef sectionName,
+                             SmallVectorImpl<unsigned> &rules) const {
+  auto exact = _exactNameRules.find(sectionName);
+  if (exact != _exactNameRules.end())
+    rules.append(exact->second.begin(), exact->second.end());
+  for (size_t len : _prefixLengths) {
+    // Prefix patterns need at least one more character for their '*'.
+    if (len >= sectionName.size())
+      break;
+    auto prefix = _prefixNameRules.find(sectionName.substr(0, len));
+    if (prefix != _prefixNameRules.end())
+      rules.append(prefix->second.begin(), prefix->second.end());
+  }
+  rules.append(_otherNameRules.begin(), _otherNameRules.end());
+  std::sort(rules.begin(), rules.end());
+  rules.erase(std::unique(rules.begin(), rules.end()), rules.end());
+}
+
 } // End namespace script
 } // end namespace lld
@@ -86,6 +86,13 @@ public:
   /// __eh_frame.
   virtual Reference::KindValue unwindRefToEhFrameKind() = 0;
 
+  /// References from an entry of a compressed __unwind_info page to its
+  /// function and to the first function of the page. The low 24 bits of the
+  /// entry hold the offset between the two: the first reference adds the
+  /// address of its target to them and the second subtracts it.
+  virtual Reference::KindValue unwindEntryRefToFunctionKind() = 0;
+  virtual Reference::KindValue unwindEntryRefToPageStartKind() = 0;
+
   virtual const Atom *fdeTargetFunction(const DefinedAtom *fde);
 
   /// Used by normalizedFromAtoms() to know where to generated rebasing and
@@ -158,7 +165,9 @@ public:
     return false;
   }
 
-  /// Copy raw content then apply all fixup References on an Atom.
+  /// Copy raw content then apply all fixup References on an Atom. Called
+  /// concurrently for different atoms, so it must not modify shared state,
+  /// and neither may the find functions passed to it.
   virtual void generateAtomContent(const DefinedAtom &atom, bool relocatable,
                                    FindAddressForAtom findAddress,
                                    FindAddressForAtom findSectionAddress,
@@ -210,6 +219,23 @@ public:
     llvm_unreachable("shims only support on arm");
   }
 
+  /// Used by BranchIslandPass. Returns how many bytes a branch of this kind
+  /// can reach in either direction, or zero if the reference is not a
+  /// branch that a branch island can extend.
+  virtual uint64_t branchReach(const Reference &) { return 0; }
+
+  /// Used by BranchIslandPass. Returns the reach of the shortest branch of
+  /// the architecture, which bounds the distance between branch islands.
+  virtual uint64_t minBranchReach() { return 0; }
+
+  /// Used by BranchIslandPass. Creates an atom that only branches to
+  /// \p target, to be placed within reach of distant branch sites.
+  virtual const DefinedAtom *createBranchIsland(MachOFile &file,
+                                                StringRef name,
+                                                const Atom &target) {
+    llvm_unreachable("branch islands only supported on arm and arm64");
+  }
+
   /// Does a given unwind-cfi atom represent a CIE (as opposed to an FDE).
   static bool isDwarfCIE(bool isBig, const DefinedAtom *atom);
 
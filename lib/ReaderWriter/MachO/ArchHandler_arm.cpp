@@ -63,6 +63,14 @@ public:
     return invalid;
   }
 
+  Reference::KindValue unwindEntryRefToFunctionKind() override {
+    return invalid;
+  }
+
+  Reference::KindValue unwindEntryRefToPageStartKind() override {
+    return invalid;
+  }
+
   uint32_t dwarfCompactUnwindType() override {
     // FIXME
     return -1;
@@ -131,9 +139,20 @@ public:
   const DefinedAtom *createShim(MachOFile &file, bool thumbToArm,
                                 const DefinedAtom &) override;
 
+  uint64_t branchReach(const Reference &) override;
+  uint64_t minBranchReach() override { return thumbBranchReach; }
+  const DefinedAtom *createBranchIsland(MachOFile &file, StringRef name,
+                                        const Atom &target) override;
+
 private:
   friend class Thumb2ToArmShimAtom;
   friend class ArmToThumbShimAtom;
+  friend class ArmBranchIslandAtom;
+
+  // Thumb2 branches reach +/-16MB and arm branches +/-32MB. Stay a little
+  // short of that.
+  static const uint64_t thumbBranchReach = (1 << 24) - 16;
+  static const uint64_t armBranchReach = (1 << 25) - 16;
 
   static const Registry::KindStrings _sKindStrings[];
   static const StubInfo              _sStubInfoArmPIC;
@@ -311,6 +330,21 @@ bool ArchHandler_arm::isNonCallBranch(const Reference &ref) {
   }
 }
 
+uint64_t ArchHandler_arm::branchReach(const Reference &ref) {
+  if (ref.kindNamespace() != Reference::KindNamespace::mach_o)
+    return 0;
+  switch (ref.kindValue()) {
+  case thumb_b22:
+  case thumb_bl22:
+    return thumbBranchReach;
+  case arm_b24:
+  case arm_bl24:
+    return armBranchReach;
+  default:
+    return 0;
+  }
+}
+
 bool ArchHandler_arm::isPairedReloc(const Relocation &reloc) {
   switch (reloc.type) {
   case ARM_RELOC_SECTDIFF:
@@ -1017,6 +1051,7 @@ void ArchHandler_arm::generateAtomContent(const DefinedAtom &atom,
   // Copy raw bytes.
   memcpy(atomContentBuffer, atom.rawContent().data(), atom.size());
   // Apply fix-ups.
+  uint64_t atomAddress = findAddress(atom);
   bool thumbMode = false;
   for (const Reference *ref : atom) {
     uint32_t offset = ref->offsetInAtom();
@@ -1027,7 +1062,6 @@ void ArchHandler_arm::generateAtomContent(const DefinedAtom &atom,
       targetAddress = findAddress(*target);
       targetIsThumb = isThumbFunction(*defTarg);
     }
-    uint64_t atomAddress = findAddress(atom);
     uint64_t fixupAddress = atomAddress + offset;
     if (relocatable) {
       applyFixupRelocatable(*ref, &atomContentBuffer[offset], fixupAddress,
@@ -1511,6 +1545,64 @@ const DefinedAtom *ArchHandler_arm::createShim(MachOFile &file,
 }
 
 
+/// A branch island is in the mode of its target, so that the branch in it
+/// never needs to switch modes, and call sites switch modes as they would
+/// for the target itself.
+class ArmBranchIslandAtom : public SimpleDefinedAtom {
+public:
+  ArmBranchIslandAtom(MachOFile &file, StringRef name, const Atom &target,
+                      bool thumb)
+      : SimpleDefinedAtom(file), _name(name), _thumb(thumb) {
+    if (thumb) {
+      addReference(Reference::KindNamespace::mach_o, Reference::KindArch::ARM,
+                   ArchHandler_arm::modeThumbCode, 0, this, 0);
+      addReference(Reference::KindNamespace::mach_o, Reference::KindArch::ARM,
+                   ArchHandler_arm::thumb_b22, 0, &target, 0);
+    } else {
+      addReference(Reference::KindNamespace::mach_o, Reference::KindArch::ARM,
+                   ArchHandler_arm::arm_b24, 0, &target, 0);
+    }
+  }
+
+  StringRef name() const override {
+    return _name;
+  }
+
+  ContentType contentType() const override {
+    return DefinedAtom::typeCode;
+  }
+
+  Alignment alignment() const override { return 4; }
+
+  uint64_t size() const override {
+    return 4;
+  }
+
+  ContentPermissions permissions() const override {
+    return DefinedAtom::permR_X;
+  }
+
+  ArrayRef<uint8_t> rawContent() const override {
+    static const uint8_t thumbBytes[] =
+    { 0x00, 0xF0, 0x00, 0xB8 };     //  b.w target
+    static const uint8_t armBytes[] =
+    { 0x00, 0x00, 0x00, 0xEA };     //  b target
+    return llvm::makeArrayRef(_thumb ? thumbBytes : armBytes, size());
+  }
+private:
+  StringRef _name;
+  bool _thumb;
+};
+
+const DefinedAtom *ArchHandler_arm::createBranchIsland(MachOFile &file,
+                                                       StringRef name,
+                                                       const Atom &target) {
+  const DefinedAtom *daTarget = dyn_cast<DefinedAtom>(&target);
+  bool thumb = daTarget && isThumbFunction(*daTarget);
+  return new (file.allocator()) ArmBranchIslandAtom(file, name, target, thumb);
+}
+
+
 std::unique_ptr<mach_o::ArchHandler> ArchHandler::create_arm() {
   return std::unique_ptr<mach_o::ArchHandler>(new ArchHandler_arm());
 }
@@ -89,6 +89,11 @@ public:
     return false;
   }
 
+  uint64_t branchReach(const Reference &) override;
+  uint64_t minBranchReach() override { return branch26Reach; }
+  const DefinedAtom *createBranchIsland(MachOFile &file, StringRef name,
+                                        const Atom &target) override;
+
   bool isPointer(const Reference &) override;
   bool isPairedReloc(const normalized::Relocation &) override;
 
@@ -114,6 +119,14 @@ public:
     return unwindInfoToEhFrame;
   }
 
+  Reference::KindValue unwindEntryRefToFunctionKind() override {
+    return unwindInfoEntryToFunction;
+  }
+
+  Reference::KindValue unwindEntryRefToPageStartKind() override {
+    return unwindInfoEntryToPageStart;
+  }
+
   uint32_t dwarfCompactUnwindType() override {
     return 0x03000000;
   }
@@ -158,9 +171,14 @@ public:
                                 normalized::Relocations &relocs) override;
 
 private:
+  friend class Arm64BranchIslandAtom;
+
   static const Registry::KindStrings _sKindStrings[];
   static const StubInfo _sStubInfo;
 
+  // B and BL reach +/-128MB. Stay a little short of that.
+  static const uint64_t branch26Reach = (1 << 27) - 16;
+
   enum Arm64Kind : Reference::KindValue {
     invalid,               /// for error condition
 
@@ -195,6 +213,10 @@ private:
                            /// relocatable object (yay for implicit contracts!).
     unwindInfoToEhFrame,   /// Fix low 24 bits of compact unwind encoding to
                            /// refer to __eh_frame entry.
+    unwindInfoEntryToFunction,  /// Add address of function to low 24 bits of
+                                /// compressed __unwind_info entry.
+    unwindInfoEntryToPageStart, /// Subtract address of first function of page
+                                /// from low 24 bits of compressed entry.
   };
 
   void applyFixupFinal(const Reference &ref, uint8_t *location,
@@ -244,6 +266,8 @@ const Registry::KindStrings ArchHandler_arm64::_sKindStrings[] = {
   LLD_KIND_STRING_ENTRY(imageOffsetGot),
   LLD_KIND_STRING_ENTRY(unwindFDEToFunction),
   LLD_KIND_STRING_ENTRY(unwindInfoToEhFrame),
+  LLD_KIND_STRING_ENTRY(unwindInfoEntryToFunction),
+  LLD_KIND_STRING_ENTRY(unwindInfoEntryToPageStart),
 
   LLD_KIND_STRING_END
 };
@@ -298,6 +322,15 @@ bool ArchHandler_arm64::isCallSite(const Reference &ref) {
   return (ref.kindValue() == branch26);
 }
 
+uint64_t ArchHandler_arm64::branchReach(const Reference &ref) {
+  if (ref.kindNamespace() != Reference::KindNamespace::mach_o)
+    return 0;
+  assert(ref.kindArch() == Reference::KindArch::AArch64);
+  if (ref.kindValue() != branch26)
+    return 0;
+  return branch26Reach;
+}
+
 bool ArchHandler_arm64::isPointer(const Reference &ref) {
   if (ref.kindNamespace() != Reference::KindNamespace::mach_o)
     return false;
@@ -502,6 +535,7 @@ void ArchHandler_arm64::generateAtomContent(
   // Copy raw bytes.
   memcpy(atomContentBuffer, atom.rawContent().data(), atom.size());
   // Apply fix-ups.
+  uint64_t atomAddress = findAddress(atom);
   for (const Reference *ref : atom) {
     uint32_t offset = ref->offsetInAtom();
     const Atom *target = ref->target();
@@ -509,7 +543,6 @@ void ArchHandler_arm64::generateAtomContent(
     uint64_t targetAddress = 0;
     if (isa<DefinedAtom>(target))
       targetAddress = findAddress(*target);
-    uint64_t atomAddress = findAddress(atom);
     uint64_t fixupAddress = atomAddress + offset;
     if (relocatable) {
       applyFixupRelocatable(*ref, &atomContentBuffer[offset], fixupAddress,
@@ -620,6 +653,14 @@ void ArchHandler_arm64::applyFixupFinal(const Reference &ref, uint8_t *loc,
     assert(value64 < 0xffffffU && "offset in __eh_frame too large");
     *loc32 = (*loc32 & 0xff000000U) | value64;
     return;
+  case unwindInfoEntryToFunction:
+    *loc32 = (*loc32 & 0xff000000U) |
+             ((*loc32 + targetAddress + ref.addend()) & 0x00ffffffU);
+    return;
+  case unwindInfoEntryToPageStart:
+    *loc32 = (*loc32 & 0xff000000U) |
+             ((*loc32 - targetAddress + ref.addend()) & 0x00ffffffU);
+    return;
   case invalid:
     // Fall into llvm_unreachable().
     break;
@@ -685,6 +726,8 @@ void ArchHandler_arm64::applyFixupRelocatable(const Reference &ref,
   case imageOffset:
   case imageOffsetGot:
   case unwindInfoToEhFrame:
+  case unwindInfoEntryToFunction:
+  case unwindInfoEntryToPageStart:
     llvm_unreachable("fixup implies __unwind_info");
     return;
   case unwindFDEToFunction:
@@ -804,6 +847,8 @@ void ArchHandler_arm64::appendSectionRelocations(
     llvm_unreachable("deltas from mach_header can only be in final images");
   case unwindFDEToFunction:
   case unwindInfoToEhFrame:
+  case unwindInfoEntryToFunction:
+  case unwindInfoEntryToPageStart:
   case negDelta32:
     // Do nothing.
     return;
@@ -814,6 +859,49 @@ void ArchHandler_arm64::appendSectionRelocations(
   llvm_unreachable("unknown arm64 Reference Kind");
 }
 
+class Arm64BranchIslandAtom : public SimpleDefinedAtom {
+public:
+  Arm64BranchIslandAtom(MachOFile &file, StringRef name, const Atom &target)
+      : SimpleDefinedAtom(file), _name(name) {
+    addReference(Reference::KindNamespace::mach_o,
+                 Reference::KindArch::AArch64, ArchHandler_arm64::branch26, 0,
+                 &target, 0);
+  }
+
+  StringRef name() const override {
+    return _name;
+  }
+
+  ContentType contentType() const override {
+    return DefinedAtom::typeCode;
+  }
+
+  Alignment alignment() const override { return 4; }
+
+  uint64_t size() const override {
+    return 4;
+  }
+
+  ContentPermissions permissions() const override {
+    return DefinedAtom::permR_X;
+  }
+
+  ArrayRef<uint8_t> rawContent() const override {
+    static const uint8_t bytes[] =
+    { 0x00, 0x00, 0x00, 0x14 };     //  b target
+    assert(sizeof(bytes) == size());
+    return llvm::makeArrayRef(bytes, sizeof(bytes));
+  }
+private:
+  StringRef _name;
+};
+
+const DefinedAtom *ArchHandler_arm64::createBranchIsland(MachOFile &file,
+                                                         StringRef name,
+                                                         const Atom &target) {
+  return new (file.allocator()) Arm64BranchIslandAtom(file, name, target);
+}
+
 std::unique_ptr<mach_o::ArchHandler> ArchHandler::create_arm64() {
   return std::unique_ptr<mach_o::ArchHandler>(new ArchHandler_arm64());
 }
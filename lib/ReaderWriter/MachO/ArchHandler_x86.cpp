@@ -68,6 +68,14 @@ public:
     return invalid;
   }
 
+  Reference::KindValue unwindEntryRefToFunctionKind() override {
+    return invalid;
+  }
+
+  Reference::KindValue unwindEntryRefToPageStartKind() override {
+    return invalid;
+  }
+
 
   uint32_t dwarfCompactUnwindType() override {
     return 0x04000000U;
@@ -413,13 +421,13 @@ void ArchHandler_x86::generateAtomContent(const DefinedAtom &atom,
   // Copy raw bytes.
   memcpy(atomContentBuffer, atom.rawContent().data(), atom.size());
   // Apply fix-ups.
+  uint64_t atomAddress = findAddress(atom);
   for (const Reference *ref : atom) {
     uint32_t offset = ref->offsetInAtom();
     const Atom *target = ref->target();
     uint64_t targetAddress = 0;
     if (isa<DefinedAtom>(target))
       targetAddress = findAddress(*target);
-    uint64_t atomAddress = findAddress(atom);
     uint64_t fixupAddress = atomAddress + offset;
     if (relocatable) {
       applyFixupRelocatable(*ref, &atomContentBuffer[offset],
@@ -101,6 +101,14 @@ public:
     return unwindInfoToEhFrame;
   }
 
+  Reference::KindValue unwindEntryRefToFunctionKind() override {
+    return unwindInfoEntryToFunction;
+  }
+
+  Reference::KindValue unwindEntryRefToPageStartKind() override {
+    return unwindInfoEntryToPageStart;
+  }
+
   uint32_t dwarfCompactUnwindType() override {
     return 0x04000000U;
   }
@@ -195,6 +203,10 @@ private:
                            /// relocatable object (yay for implicit contracts!).
     unwindInfoToEhFrame,   /// Fix low 24 bits of compact unwind encoding to
                            /// refer to __eh_frame entry.
+    unwindInfoEntryToFunction,  /// Add address of function to low 24 bits of
+                                /// compressed __unwind_info entry.
+    unwindInfoEntryToPageStart, /// Subtract address of first function of page
+                                /// from low 24 bits of compressed entry.
   };
 
   Reference::KindValue kindFromReloc(const normalized::Relocation &reloc);
@@ -236,6 +248,8 @@ const Registry::KindStrings ArchHandler_x86_64::_sKindStrings[] = {
   LLD_KIND_STRING_ENTRY(imageOffset), LLD_KIND_STRING_ENTRY(imageOffsetGot),
   LLD_KIND_STRING_ENTRY(unwindFDEToFunction),
   LLD_KIND_STRING_ENTRY(unwindInfoToEhFrame),
+  LLD_KIND_STRING_ENTRY(unwindInfoEntryToFunction),
+  LLD_KIND_STRING_ENTRY(unwindInfoEntryToPageStart),
   LLD_KIND_STRING_END
 };
 
@@ -473,13 +487,13 @@ void ArchHandler_x86_64::generateAtomContent(
   // Copy raw bytes.
   memcpy(atomContentBuffer, atom.rawContent().data(), atom.size());
   // Apply fix-ups.
+  uint64_t atomAddress = findAddress(atom);
   for (const Reference *ref : atom) {
     uint32_t offset = ref->offsetInAtom();
     const Atom *target = ref->target();
     uint64_t targetAddress = 0;
     if (isa<DefinedAtom>(target))
       targetAddress = findAddress(*target);
-    uint64_t atomAddress = findAddress(atom);
     uint64_t fixupAddress = atomAddress + offset;
     if (relocatable) {
       applyFixupRelocatable(*ref, &atomContentBuffer[offset],
@@ -560,6 +574,14 @@ void ArchHandler_x86_64::applyFixupFinal(
     *loc32 = (*loc32 & 0xff000000U) | val;
     return;
   }
+  case unwindInfoEntryToFunction:
+    *loc32 = (*loc32 & 0xff000000U) |
+             ((*loc32 + targetAddress + ref.addend()) & 0x00ffffffU);
+    return;
+  case unwindInfoEntryToPageStart:
+    *loc32 = (*loc32 & 0xff000000U) |
+             ((*loc32 - targetAddress + ref.addend()) & 0x00ffffffU);
+    return;
   case invalid:
     // Fall into llvm_unreachable().
     break;
@@ -637,6 +659,8 @@ void ArchHandler_x86_64::applyFixupRelocatable(const Reference &ref,
   case imageOffset:
   case imageOffsetGot:
   case unwindInfoToEhFrame:
+  case unwindInfoEntryToFunction:
+  case unwindInfoEntryToPageStart:
     llvm_unreachable("fixup implies __unwind_info");
     return;
   case unwindFDEToFunction:
@@ -740,6 +764,8 @@ void ArchHandler_x86_64::appendSectionRelocations(
     return;
   case unwindFDEToFunction:
   case unwindInfoToEhFrame:
+  case unwindInfoEntryToFunction:
+  case unwindInfoEntryToPageStart:
   case negDelta32:
     return;
   case ripRel32GotLoadNowLea:
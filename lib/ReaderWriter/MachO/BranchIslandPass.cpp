@@ -0,0 +1,364 @@
+//===- lib/ReaderWriter/MachO/BranchIslandPass.cpp ------------------------===//
+//
+//                             The LLVM Linker
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This linker pass inserts branch islands in large arm and arm64 images.
+//
+// The pc-rel branches of arm (+/-16MB in thumb2, +/-32MB in arm mode) and
+// arm64 (+/-128MB) cannot reach across a large __text section.  The pass
+// estimates the address of every code atom the way the writer will lay them
+// out, and sets apart regions for islands in __text, a little closer to each
+// other than the shortest branch reaches.  A branch whose target is out of
+// reach is switched to an island in the farthest region it can reach toward
+// the target.  The island branches to the target, or to the island for the
+// same target in the next region.  All branches to a target that go through
+// a region share its island.
+//
+// Islands move the code that follows them, so the addresses are estimated
+// again and all branches checked again, until no branch needs a new island
+// or a few rounds have passed.  The regions leave enough slack that a round
+// after the first rarely adds anything.
+//
+//===----------------------------------------------------------------------===//
+
+#include "ArchHandler.h"
+#include "File.h"
+#include "MachOPasses.h"
+#include "lld/Core/DefinedAtom.h"
+#include "lld/Core/LLVM.h"
+#include "lld/Core/Reference.h"
+#include "lld/Core/Simple.h"
+#include "lld/ReaderWriter/MachOLinkingContext.h"
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/STLExtras.h"
+#include "llvm/ADT/Twine.h"
+#include "llvm/Support/Debug.h"
+#include "llvm/Support/MathExtras.h"
+#include "llvm/Support/raw_ostream.h"
+#include <algorithm>
+
+#define DEBUG_TYPE "macho-branch-islands"
+
+namespace lld {
+namespace mach_o {
+
+class BranchIslandPass : public Pass {
+public:
+  BranchIslandPass(const MachOLinkingContext &context)
+      : _ctx(context), _archHandler(_ctx.archHandler()),
+        _file("<mach-o branch island pass>") {}
+
+  void perform(std::unique_ptr<SimpleFile> &mergedFile) override;
+
+private:
+  // The islands placed after one atom of __text.
+  struct Region {
+    explicit Region(size_t after) : after(after), address(0), end(0) {}
+
+    size_t                                            after;
+    uint64_t                                          address;
+    uint64_t                                          end;
+    std::vector<const DefinedAtom *>                  islands;
+    llvm::DenseMap<const Atom *, const DefinedAtom *> islandFor;
+  };
+
+  uint64_t reach(const Reference &ref);
+  uint64_t place(const DefinedAtom *atom, uint64_t address);
+  uint64_t layout();
+  void placeRegions(uint64_t spacing);
+  bool outOfReach(const DefinedAtom *atom, const Reference &ref);
+  bool checkBranches(const DefinedAtom *atom);
+  bool fixBranch(uint64_t site, const Reference *ref);
+  const DefinedAtom *getIsland(size_t index, const Atom *target);
+  StringRef targetName(const Atom *target);
+
+  const MachOLinkingContext                   &_ctx;
+  mach_o::ArchHandler                         &_archHandler;
+  MachOFile                                    _file;
+  std::vector<const DefinedAtom *>             _text;
+  std::vector<const DefinedAtom *>             _stubs;
+  std::vector<const DefinedAtom *>             _stubHelpers;
+  std::vector<Region>                          _regions;
+  llvm::DenseMap<const Atom *, uint64_t>       _address;
+  llvm::DenseMap<const Atom *, const Atom *>   _islandTarget;
+};
+
+static bool inReach(uint64_t from, uint64_t to, uint64_t reach) {
+  return (from < to ? to - from : from - to) <= reach;
+}
+
+uint64_t BranchIslandPass::reach(const Reference &ref) {
+  uint64_t reach = _archHandler.branchReach(ref);
+  if (reach && _ctx.testBranchReach())
+    return std::min(reach, _ctx.testBranchReach());
+  return reach;
+}
+
+/// Places \p atom at the first address at or after \p address that meets
+/// its alignment, the way the writer appends atoms to a section, and returns
+/// the end of the atom.
+uint64_t BranchIslandPass::place(const DefinedAtom *atom, uint64_t address) {
+  DefinedAtom::Alignment atomAlign = atom->alignment();
+  uint64_t align = atomAlign.value;
+  uint64_t requiredModulus = atomAlign.modulus;
+  uint64_t currentModulus = (address % align);
+  if (currentModulus != requiredModulus) {
+    if (requiredModulus > currentModulus)
+      address += requiredModulus - currentModulus;
+    else
+      address += align + requiredModulus - currentModulus;
+  }
+  _address[atom] = address;
+  return address + atom->size();
+}
+
+/// Estimates the addresses, relative to the start of __text, of the atoms of
+/// __text with their islands, and of __stubs and __stub_helper which follow
+/// __text. Returns the end of the last atom.
+uint64_t BranchIslandPass::layout() {
+  uint64_t address = 0;
+  auto region = _regions.begin();
+  for (size_t i = 0, e = _text.size(); i != e; ++i) {
+    address = place(_text[i], address);
+    for (; region != _regions.end() && region->after == i; ++region) {
+      region->address = address;
+      for (const DefinedAtom *island : region->islands)
+        address = place(island, address);
+      region->end = address;
+    }
+  }
+  for (const std::vector<const DefinedAtom *> *atoms :
+       {&_stubs, &_stubHelpers}) {
+    uint64_t align = 1;
+    for (const DefinedAtom *atom : *atoms)
+      align = std::max<uint64_t>(align, atom->alignment().value);
+    address = llvm::RoundUpToAlignment(address, align);
+    for (const DefinedAtom *atom : *atoms)
+      address = place(atom, address);
+  }
+  return address;
+}
+
+/// Sets apart a region about every \p spacing bytes of __text, after the
+/// last atom that ends before the region is due.
+void BranchIslandPass::placeRegions(uint64_t spacing) {
+  uint64_t next = spacing;
+  for (size_t i = 1, e = _text.size(); i != e; ++i) {
+    uint64_t address = _address[_text[i]];
+    if (address + _text[i]->size() <= next)
+      continue;
+    _regions.push_back(Region(i - 1));
+    next = address + spacing;
+  }
+}
+
+/// Returns true if \p ref is a branch of \p atom that cannot reach its
+/// target.
+bool BranchIslandPass::outOfReach(const DefinedAtom *atom,
+                                  const Reference &ref) {
+  uint64_t branchReach = reach(ref);
+  if (branchReach == 0)
+    return false;
+  auto pos = _address.find(ref.target());
+  if (pos == _address.end())
+    return false;
+  uint64_t site = _address.lookup(atom) + ref.offsetInAtom();
+  return !inReach(site, pos->second, branchReach);
+}
+
+/// Switches the branches of \p atom that cannot reach their targets to
+/// islands. Returns true if any branch changed.
+bool BranchIslandPass::checkBranches(const DefinedAtom *atom) {
+  bool changed = false;
+  for (const Reference *ref : *atom) {
+    if (!outOfReach(atom, *ref))
+      continue;
+    if (fixBranch(_address.lookup(atom) + ref->offsetInAtom(), ref))
+      changed = true;
+  }
+  return changed;
+}
+
+/// Switches the branch \p ref at address \p site to the island for its
+/// final target in the farthest region within reach toward that target.
+/// Returns true if the branch changed.
+bool BranchIslandPass::fixBranch(uint64_t site, const Reference *ref) {
+  const Atom *target = ref->target();
+  auto isl = _islandTarget.find(target);
+  if (isl != _islandTarget.end())
+    target = isl->second;
+  uint64_t targetAddress = _address[target];
+  uint64_t branchReach = reach(*ref);
+  const DefinedAtom *newTarget = nullptr;
+  if (inReach(site, targetAddress, branchReach)) {
+    newTarget = dyn_cast<DefinedAtom>(target);
+  } else {
+    size_t best = _regions.size();
+    for (size_t i = 0, e = _regions.size(); i != e; ++i) {
+      const Region &region = _regions[i];
+      bool toward = (targetAddress > site)
+          ? (region.address > site && region.address < targetAddress)
+          : (region.end < site && region.end > targetAddress);
+      if (!toward || !inReach(site, region.address, branchReach) ||
+          !inReach(site, region.end, branchReach))
+        continue;
+      // Forward, the last region in reach is the farthest; backward, the
+      // first one is.
+      if (best == _regions.size() || targetAddress > site)
+        best = i;
+    }
+    if (best == _regions.size())
+      return false;
+    newTarget = getIsland(best, target);
+  }
+  if (newTarget == nullptr || newTarget == ref->target())
+    return false;
+  const_cast<Reference *>(ref)->setTarget(newTarget);
+  return true;
+}
+
+/// Returns the island of region \p index for \p target, and creates it at
+/// the end of the region if there is none yet.
+const DefinedAtom *BranchIslandPass::getIsland(size_t index,
+                                               const Atom *target) {
+  Region &region = _regions[index];
+  auto pos = region.islandFor.find(target);
+  if (pos != region.islandFor.end())
+    return pos->second;
+  std::string name = (targetName(target) + "$island$" + Twine(index)).str();
+  const DefinedAtom *island = _archHandler.createBranchIsland(
+      _file, StringRef(name).copy(_file.allocator()), *target);
+  region.islandFor[target] = island;
+  region.islands.push_back(island);
+  _islandTarget[island] = target;
+  region.end = place(island, region.end);
+  // Chain the island to the next region if the target is too far.
+  checkBranches(island);
+  return island;
+}
+
+/// Returns the name of \p target, or for a stub, the name of the function
+/// it binds, as shims name their targets.
+StringRef BranchIslandPass::targetName(const Atom *target) {
+  const DefinedAtom *stub = dyn_cast<DefinedAtom>(target);
+  if (!stub || stub->contentType() != DefinedAtom::typeStub)
+    return target->name();
+  for (const Reference *ref : *stub) {
+    const DefinedAtom *lp = dyn_cast_or_null<DefinedAtom>(ref->target());
+    if (!lp || lp->contentType() != DefinedAtom::typeLazyPointer)
+      continue;
+    for (const Reference *lpRef : *lp)
+      if (_archHandler.isLazyPointer(*lpRef))
+        return lpRef->target()->name();
+  }
+  return "stub";
+}
+
+void BranchIslandPass::perform(std::unique_ptr<SimpleFile> &mergedFile) {
+  uint64_t minReach = _archHandler.minBranchReach();
+  if (minReach && _ctx.testBranchReach())
+    minReach = std::min(minReach, _ctx.testBranchReach());
+  if (minReach == 0)
+    return;
+
+  // Collect the atoms of __text, __stubs and __stub_helper in layout order.
+  for (const DefinedAtom *atom : mergedFile->defined()) {
+    if (atom->sectionChoice() != DefinedAtom::sectionBasedOnContent)
+      continue;
+    switch (atom->contentType()) {
+    case DefinedAtom::typeCode:
+      _text.push_back(atom);
+      break;
+    case DefinedAtom::typeStub:
+      _stubs.push_back(atom);
+      break;
+    case DefinedAtom::typeStubHelper:
+      _stubHelpers.push_back(atom);
+      break;
+    default:
+      break;
+    }
+  }
+
+  // Exit early if every branch reaches across all the code.
+  if (layout() <= minReach)
+    return;
+  placeRegions(minReach - minReach / 8);
+
+  const unsigned maxRounds = 4;
+  for (unsigned round = 0; round != maxRounds; ++round) {
+    layout();
+    bool changed = false;
+    for (const DefinedAtom *atom : _text)
+      if (checkBranches(atom))
+        changed = true;
+    // Islands may be added to the regions while they are checked.
+    for (Region &region : _regions)
+      for (size_t i = 0; i != region.islands.size(); ++i)
+        if (checkBranches(region.islands[i]))
+          changed = true;
+    DEBUG(llvm::dbgs() << "branch island round " << round << ": "
+                       << _islandTarget.size() << " islands\n");
+    if (!changed)
+      break;
+  }
+
+  // Regions too full of islands to keep within reach of each other, or
+  // atoms larger than a branch reaches, leave branches the writer cannot
+  // encode.
+  layout();
+  const DefinedAtom *firstAtom = nullptr;
+  unsigned count = 0;
+  auto report = [&](const DefinedAtom *atom) {
+    for (const Reference *ref : *atom)
+      if (outOfReach(atom, *ref) && count++ == 0)
+        firstAtom = atom;
+  };
+  for (const DefinedAtom *atom : _text)
+    report(atom);
+  for (const Region &region : _regions)
+    for (const DefinedAtom *island : region.islands)
+      report(island);
+  if (count)
+    llvm::errs() << "warning: " << count << " branches cannot reach their "
+                 << "targets, the first in " << firstAtom->name() << "\n";
+
+  if (_islandTarget.empty())
+    return;
+
+  // Add the islands to the file, and move each region of islands right
+  // after the atom it follows.
+  llvm::DenseMap<const Atom *, const Region *> regionAfter;
+  for (const Region &region : _regions) {
+    if (region.islands.empty())
+      continue;
+    regionAfter[_text[region.after]] = &region;
+    for (const DefinedAtom *island : region.islands)
+      mergedFile->addAtom(*island);
+  }
+  SimpleFile::DefinedAtomRange atomRange = mergedFile->definedAtoms();
+  std::vector<const DefinedAtom *> order;
+  order.reserve(atomRange.size());
+  for (const DefinedAtom *atom : atomRange) {
+    if (_islandTarget.count(atom))
+      continue;
+    order.push_back(atom);
+    auto pos = regionAfter.find(atom);
+    if (pos != regionAfter.end())
+      order.insert(order.end(), pos->second->islands.begin(),
+                   pos->second->islands.end());
+  }
+  std::copy(order.begin(), order.end(), atomRange.begin());
+}
+
+void addBranchIslandPass(PassManager &pm, const MachOLinkingContext &ctx) {
+  pm.add(llvm::make_unique<BranchIslandPass>(ctx));
+}
+
+} // end namespace mach_o
+} // end namespace lld
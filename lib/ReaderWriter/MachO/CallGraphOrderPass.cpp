@@ -0,0 +1,50 @@
+//===- lib/ReaderWriter/MachO/CallGraphOrderPass.cpp ----------------------===//
+//
+//                             The LLVM Linker
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This linker pass turns the call graph profile given with
+// -call_graph_ordering_file into order file entries. The functions of the
+// profile are clustered (see CallGraphProfile::sortAtoms) and appended to the
+// order file list, after the symbols of any -order_file, so the LayoutPass
+// places them through the usual custom orderer.
+//
+//===----------------------------------------------------------------------===//
+
+#include "MachOPasses.h"
+#include "lld/Core/AtomOrder.h"
+#include "lld/Core/DefinedAtom.h"
+#include "lld/Core/LLVM.h"
+#include "lld/Core/Simple.h"
+#include "lld/ReaderWriter/MachOLinkingContext.h"
+#include "llvm/ADT/STLExtras.h"
+
+namespace lld {
+namespace mach_o {
+
+class CallGraphOrderPass : public Pass {
+public:
+  CallGraphOrderPass(MachOLinkingContext &context) : _ctx(context) {}
+
+  void perform(std::unique_ptr<SimpleFile> &mergedFile) override {
+    SimpleFile::DefinedAtomRange range = mergedFile->definedAtoms();
+    std::vector<const DefinedAtom *> atoms(range.begin(), range.end());
+    for (const DefinedAtom *atom : _ctx.callGraphProfile().sortAtoms(atoms))
+      if (!_ctx.isOrderedSymbol(atom->name()))
+        _ctx.appendOrderedSymbol(atom->name(), "");
+  }
+
+private:
+  MachOLinkingContext &_ctx;
+};
+
+void addCallGraphOrderPass(PassManager &pm, MachOLinkingContext &ctx) {
+  pm.add(llvm::make_unique<CallGraphOrderPass>(ctx));
+}
+
+} // end namespace mach_o
+} // end namespace lld
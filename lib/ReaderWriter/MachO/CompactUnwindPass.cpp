@@ -58,8 +58,20 @@ struct CompactUnwindEntry {
         lsdaLocation(nullptr), ehFrame(nullptr), rangeLength(0), encoding(0) {}
 };
 
+/// An encoding in the encodings array of a compressed page, with the
+/// __eh_frame entry of the function when it defers to DWARF.
+typedef std::pair<uint32_t, const Atom *> PageEncoding;
+
 struct UnwindInfoPage {
+  UnwindInfoPage() : compressed(false) {}
+
   std::vector<CompactUnwindEntry> entries;
+
+  // Compressed pages refer to the encoding of each entry by its index into
+  // the common encodings followed by the page's own encodings.
+  bool compressed;
+  std::vector<uint8_t> encodingIndexes;
+  std::vector<PageEncoding> encodings;
 };
 }
 
@@ -206,7 +218,10 @@ public:
 
   void addSecondLevelPages(std::vector<UnwindInfoPage> &pages) {
     for (auto &page : pages) {
-      addRegularSecondLevelPage(page);
+      if (page.compressed)
+        addCompressedSecondLevelPage(page);
+      else
+        addRegularSecondLevelPage(page);
     }
   }
 
@@ -239,6 +254,59 @@ public:
     }
   }
 
+  void addCompressedSecondLevelPage(const UnwindInfoPage &page) {
+    uint32_t curPageOffset = _contents.size();
+    const int16_t headerSize = sizeof(uint32_t) + 4 * sizeof(uint16_t);
+    uint32_t encodingsOffset =
+        headerSize + page.entries.size() * sizeof(uint32_t);
+    uint32_t curPageSize =
+        encodingsOffset + page.encodings.size() * sizeof(uint32_t);
+    _contents.resize(curPageOffset + curPageSize);
+
+    using normalized::write32;
+    using normalized::write16;
+    // 3 => compressed page
+    write32(&_contents[curPageOffset], 3, _isBig);
+    // offset of 1st entry
+    write16(&_contents[curPageOffset + 4], headerSize, _isBig);
+    write16(&_contents[curPageOffset + 6], page.entries.size(), _isBig);
+    // offset of 1st encoding
+    write16(&_contents[curPageOffset + 8], encodingsOffset, _isBig);
+    write16(&_contents[curPageOffset + 10], page.encodings.size(), _isBig);
+
+    // The encoding index is in the high 8 bits of each entry, and the offset
+    // of its function from the first function of the page is in the low 24
+    // bits, filled in by the references.
+    uint32_t pagePos = curPageOffset + headerSize;
+    const Atom *pageStart = page.entries[0].rangeStart;
+    for (unsigned i = 0, e = page.entries.size(); i != e; ++i) {
+      write32(_contents.data() + pagePos, page.encodingIndexes[i] << 24,
+              _isBig);
+      if (i != 0) {
+        addEntryReference(pagePos, _archHandler.unwindEntryRefToFunctionKind(),
+                          page.entries[i].rangeStart);
+        addEntryReference(pagePos,
+                          _archHandler.unwindEntryRefToPageStartKind(),
+                          pageStart);
+      }
+      pagePos += sizeof(uint32_t);
+    }
+
+    for (const PageEncoding &encoding : page.encodings) {
+      write32(_contents.data() + pagePos, encoding.first, _isBig);
+      if ((encoding.first & 0x0f000000U) ==
+          _archHandler.dwarfCompactUnwindType())
+        addEhFrameReference(pagePos, encoding.second);
+      pagePos += sizeof(uint32_t);
+    }
+  }
+
+  void addEntryReference(uint32_t offset, Reference::KindValue kind,
+                         const Atom *dest) {
+    addReference(Reference::KindNamespace::mach_o, _archHandler.kindArch(),
+                 kind, offset, dest, 0);
+  }
+
   void addEhFrameReference(uint32_t offset, const Atom *dest,
                            Reference::Addend addend = 0) {
     addReference(Reference::KindNamespace::mach_o, _archHandler.kindArch(),
@@ -280,8 +348,8 @@ private:
   void perform(std::unique_ptr<SimpleFile> &mergedFile) override {
     DEBUG(llvm::dbgs() << "MachO Compact Unwind pass\n");
 
-    std::map<const Atom *, CompactUnwindEntry> unwindLocs;
-    std::map<const Atom *, const Atom *> dwarfFrames;
+    llvm::DenseMap<const Atom *, CompactUnwindEntry> unwindLocs;
+    llvm::DenseMap<const Atom *, const Atom *> dwarfFrames;
     std::vector<const Atom *> personalities;
     uint32_t numLSDAs = 0;
 
@@ -301,58 +369,155 @@ private:
     // also probably be sorted by frequency.
     assert(personalities.size() <= 4);
 
-    // TODO: Find commmon encodings for use by compressed pages.
-    std::vector<uint32_t> commonEncodings;
-
     // Now sort the entries by final address and fixup the compact encoding to
     // its final form (i.e. set personality function bits & create DWARF
     // references where needed).
     std::vector<CompactUnwindEntry> unwindInfos = createUnwindInfoEntries(
         mergedFile, unwindLocs, personalities, dwarfFrames);
 
-    // Finally, we can start creating pages based on these entries.
+    std::vector<uint32_t> commonEncodings = findCommonEncodings(unwindInfos);
 
+    // Then split these entries into pages.
+    std::vector<UnwindInfoPage> pages =
+        createPages(unwindInfos, commonEncodings);
+
+    UnwindInfoAtom *unwind = new (_file.allocator())
+        UnwindInfoAtom(_archHandler, _file, _isBig, personalities,
+                       commonEncodings, pages, numLSDAs);
+    mergedFile->addAtom(*unwind);
+
+    // Finally, remove all __compact_unwind atoms now that we've processed them.
+    mergedFile->removeDefinedAtomsIf([](const DefinedAtom *atom) {
+      return atom->contentType() == DefinedAtom::typeCompactUnwindInfo;
+    });
+  }
+
+  /// Returns the encodings shared by several functions, most used first, for
+  /// compressed pages to refer to by index. Encodings that defer to DWARF
+  /// differ by the __eh_frame entry they are fixed up to point to, so they
+  /// are never common.
+  std::vector<uint32_t>
+  findCommonEncodings(const std::vector<CompactUnwindEntry> &unwindInfos) {
+    llvm::DenseMap<uint32_t, unsigned> uses;
+    for (const CompactUnwindEntry &entry : unwindInfos)
+      if (!isDwarfEncoding(entry.encoding))
+        ++uses[entry.encoding];
+
+    std::vector<std::pair<uint32_t, unsigned>> shared;
+    for (const auto &use : uses)
+      if (use.second > 1)
+        shared.push_back(use);
+    std::sort(shared.begin(), shared.end(),
+              [](const std::pair<uint32_t, unsigned> &a,
+                 const std::pair<uint32_t, unsigned> &b) {
+      if (a.second != b.second)
+        return a.second > b.second;
+      return a.first < b.first;
+    });
+
+    // The format allows at most 127 common encodings.
+    std::vector<uint32_t> commonEncodings;
+    for (unsigned i = 0, e = std::min<size_t>(shared.size(), 127); i != e; ++i)
+      commonEncodings.push_back(shared[i].first);
+    return commonEncodings;
+  }
+
+  /// Splits the entries into second-level pages. Each page holds as many
+  /// entries as fit in a 4KB compressed page, and stays compressed if that
+  /// takes less room than regular entries would.
+  std::vector<UnwindInfoPage>
+  createPages(const std::vector<CompactUnwindEntry> &unwindInfos,
+              const std::vector<uint32_t> &commonEncodings) {
     DEBUG(llvm::dbgs() << "  Splitting entries into pages\n");
-    // FIXME: we split the entries into pages naively: lots of 4k pages followed
-    // by a small one. ld64 tried to minimize space and align them to real 4k
-    // boundaries. That might be worth doing, or perhaps we could perform some
-    // minor balancing for expected number of lookups.
+    llvm::DenseMap<uint64_t, uint8_t> commonIndexes;
+    for (unsigned i = 0, e = commonEncodings.size(); i != e; ++i)
+      commonIndexes[commonEncodings[i]] = i;
+
+    // The header of a compressed page takes 3 of its 1024 words. Function
+    // offsets take 24 bits; keep well short of that so that code atoms added
+    // after this pass, and alignment padding, cannot overflow them.
+    const unsigned compressedPageWords = 1021;
+    const uint64_t maxCompressedSpan = 1 << 23;
+
     std::vector<UnwindInfoPage> pages;
-    unsigned pageStart = 0;
+    size_t pageStart = 0, numEntries = unwindInfos.size();
     do {
       pages.push_back(UnwindInfoPage());
+      UnwindInfoPage &page = pages.back();
+
+      llvm::DenseMap<uint64_t, uint8_t> pageIndexes;
+      unsigned words = 0;
+      uint64_t span = 0;
+      size_t pageEnd = pageStart;
+      for (; pageEnd != numEntries; ++pageEnd) {
+        const CompactUnwindEntry &entry = unwindInfos[pageEnd];
+        if (span > maxCompressedSpan)
+          break;
+        bool dwarf = isDwarfEncoding(entry.encoding);
+        uint8_t index = 0;
+        bool found = false;
+        if (!dwarf) {
+          auto pos = commonIndexes.find(entry.encoding);
+          found = pos != commonIndexes.end();
+          if (!found) {
+            pos = pageIndexes.find(entry.encoding);
+            found = pos != pageIndexes.end();
+          }
+          if (found)
+            index = pos->second;
+        }
+        if (!found) {
+          // Encoding indexes take 8 bits.
+          size_t next = commonEncodings.size() + page.encodings.size();
+          if (next > 255 || words + 2 > compressedPageWords)
+            break;
+          index = next;
+          page.encodings.push_back(PageEncoding(entry.encoding, entry.ehFrame));
+          if (!dwarf)
+            pageIndexes[entry.encoding] = index;
+          ++words;
+        } else if (words + 1 > compressedPageWords) {
+          break;
+        }
+        page.encodingIndexes.push_back(index);
+        ++words;
+        span += entry.rangeLength;
+      }
 
-      // FIXME: we only create regular pages at the moment. These can hold up to
-      // 1021 entries according to the documentation.
-      unsigned entriesInPage =
-          std::min(1021U, (unsigned)unwindInfos.size() - pageStart);
+      // A compressed page takes a word per entry and a word per encoding of
+      // its own, where a regular page takes two words per entry.
+      size_t entriesInPage = pageEnd - pageStart;
+      page.compressed = page.encodings.size() < entriesInPage;
+      if (!page.compressed) {
+        // FIXME: These can hold up to 1021 entries according to the
+        // documentation.
+        entriesInPage = std::min<size_t>(1021, numEntries - pageStart);
+        page.encodingIndexes.clear();
+        page.encodings.clear();
+      }
 
       std::copy(unwindInfos.begin() + pageStart,
                 unwindInfos.begin() + pageStart + entriesInPage,
-                std::back_inserter(pages.back().entries));
+                std::back_inserter(page.entries));
       pageStart += entriesInPage;
 
       DEBUG(llvm::dbgs()
-            << "    Page from " << pages.back().entries[0].rangeStart->name()
-            << " to " << pages.back().entries.back().rangeStart->name() << " + "
-            << llvm::format("0x%x", pages.back().entries.back().rangeLength)
+            << "    " << (page.compressed ? "Compressed" : "Regular")
+            << " page from " << page.entries[0].rangeStart->name()
+            << " to " << page.entries.back().rangeStart->name() << " + "
+            << llvm::format("0x%x", page.entries.back().rangeLength)
             << " has " << entriesInPage << " entries\n");
-    } while (pageStart < unwindInfos.size());
-
-    UnwindInfoAtom *unwind = new (_file.allocator())
-        UnwindInfoAtom(_archHandler, _file, _isBig, personalities,
-                       commonEncodings, pages, numLSDAs);
-    mergedFile->addAtom(*unwind);
+    } while (pageStart < numEntries);
+    return pages;
+  }
 
-    // Finally, remove all __compact_unwind atoms now that we've processed them.
-    mergedFile->removeDefinedAtomsIf([](const DefinedAtom *atom) {
-      return atom->contentType() == DefinedAtom::typeCompactUnwindInfo;
-    });
+  bool isDwarfEncoding(uint32_t encoding) {
+    return (encoding & 0x0f000000U) == _archHandler.dwarfCompactUnwindType();
   }
 
   void collectCompactUnwindEntries(
       std::unique_ptr<SimpleFile> &mergedFile,
-      std::map<const Atom *, CompactUnwindEntry> &unwindLocs,
+      llvm::DenseMap<const Atom *, CompactUnwindEntry> &unwindLocs,
       std::vector<const Atom *> &personalities, uint32_t &numLSDAs) {
     DEBUG(llvm::dbgs() << "  Collecting __compact_unwind entries\n");
 
@@ -421,9 +586,9 @@ private:
     return entry;
   }
 
-  void
-  collectDwarfFrameEntries(std::unique_ptr<SimpleFile> &mergedFile,
-                           std::map<const Atom *, const Atom *> &dwarfFrames) {
+  void collectDwarfFrameEntries(
+      std::unique_ptr<SimpleFile> &mergedFile,
+      llvm::DenseMap<const Atom *, const Atom *> &dwarfFrames) {
     for (const DefinedAtom *ehFrameAtom : mergedFile->defined()) {
       if (ehFrameAtom->contentType() != DefinedAtom::typeCFI)
         continue;
@@ -443,9 +608,9 @@ private:
   ///     or too many personality functions to be accommodated.
   std::vector<CompactUnwindEntry> createUnwindInfoEntries(
       const std::unique_ptr<SimpleFile> &mergedFile,
-      const std::map<const Atom *, CompactUnwindEntry> &unwindLocs,
+      const llvm::DenseMap<const Atom *, CompactUnwindEntry> &unwindLocs,
       const std::vector<const Atom *> &personalities,
-      const std::map<const Atom *, const Atom *> &dwarfFrames) {
+      const llvm::DenseMap<const Atom *, const Atom *> &dwarfFrames) {
     std::vector<CompactUnwindEntry> unwindInfos;
 
     DEBUG(llvm::dbgs() << "  Creating __unwind_info entries\n");
@@ -470,9 +635,9 @@ private:
 
   CompactUnwindEntry finalizeUnwindInfoEntryForAtom(
       const DefinedAtom *function,
-      const std::map<const Atom *, CompactUnwindEntry> &unwindLocs,
+      const llvm::DenseMap<const Atom *, CompactUnwindEntry> &unwindLocs,
       const std::vector<const Atom *> &personalities,
-      const std::map<const Atom *, const Atom *> &dwarfFrames) {
+      const llvm::DenseMap<const Atom *, const Atom *> &dwarfFrames) {
     auto unwindLoc = unwindLocs.find(function);
 
     CompactUnwindEntry entry;
@@ -0,0 +1,270 @@
+//===- lib/ReaderWriter/MachO/DylibExportCache.cpp ------------------------===//
+//
+//                             The LLVM Linker
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#include "DylibExportCache.h"
+#include "MachONormalizedFileBinaryUtils.h"
+#include "llvm/ADT/SmallString.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/MD5.h"
+#include "llvm/Support/Path.h"
+#include "llvm/Support/TimeValue.h"
+#include "llvm/Support/raw_ostream.h"
+#include <algorithm>
+#include <cstring>
+
+namespace lld {
+namespace mach_o {
+
+static const char cacheMagic[8] = { 'l', 'l', 'd', 'x', 'p', 'o', 'r', 't' };
+static const uint32_t cacheVersion = 3;
+
+// Hashes what identifies the contents of the Mach-O \p slice: its LC_UUID,
+// or else its export trie, which is all an entry is made from. Only the load
+// commands and the trie are read, not the whole slice, unless the slice has
+// neither or is malformed.
+static void hashSliceContents(StringRef slice, llvm::MD5 &hash) {
+  using namespace llvm::MachO;
+  using normalized::read32;
+  StringRef trie;
+  if (slice.size() >= sizeof(mach_header)) {
+    const mach_header *mh = reinterpret_cast<const mach_header *>(slice.data());
+    bool isBig = mh->magic == MH_CIGAM || mh->magic == MH_CIGAM_64;
+    bool is64 = mh->magic == MH_MAGIC_64 || mh->magic == MH_CIGAM_64;
+    uint64_t offset = is64 ? sizeof(mach_header_64) : sizeof(mach_header);
+    uint64_t end = offset + read32(&mh->sizeofcmds, isBig);
+    if (end > slice.size())
+      end = slice.size();
+    for (uint32_t i = 0, e = read32(&mh->ncmds, isBig);
+         i != e && offset + sizeof(load_command) <= end; ++i) {
+      const load_command *lc =
+          reinterpret_cast<const load_command *>(slice.data() + offset);
+      uint32_t cmd = read32(&lc->cmd, isBig);
+      uint32_t size = read32(&lc->cmdsize, isBig);
+      if (size < sizeof(load_command) || offset + size > end)
+        break;
+      if (cmd == LC_UUID && size >= sizeof(uuid_command)) {
+        const uuid_command *uuid = reinterpret_cast<const uuid_command *>(lc);
+        hash.update(StringRef("uuid", 4));
+        hash.update(ArrayRef<uint8_t>(uuid->uuid, sizeof(uuid->uuid)));
+        return;
+      }
+      if ((cmd == LC_DYLD_INFO || cmd == LC_DYLD_INFO_ONLY) &&
+          size >= sizeof(dyld_info_command)) {
+        const dyld_info_command *info =
+            reinterpret_cast<const dyld_info_command *>(lc);
+        uint64_t trieOffset = read32(&info->export_off, isBig);
+        uint64_t trieSize = read32(&info->export_size, isBig);
+        if (trieOffset + trieSize <= slice.size())
+          trie = slice.substr(trieOffset, trieSize);
+      }
+      offset += size;
+    }
+  }
+  if (!trie.empty()) {
+    hash.update(StringRef("trie", 4));
+    hash.update(trie);
+    return;
+  }
+  hash.update(StringRef("file", 4));
+  hash.update(slice);
+}
+
+std::error_code DylibExportCache::getKey(StringRef path, StringRef slice,
+                                         MachOLinkingContext::Arch arch,
+                                         Key &key) {
+  llvm::sys::fs::file_status status;
+  if (std::error_code ec = llvm::sys::fs::status(path, status))
+    return ec;
+  // Keep the time in nanoseconds, so that a dylib rebuilt within a second
+  // of the cached one is not taken to be unchanged.
+  llvm::sys::TimeValue modTime = status.getLastModificationTime();
+  key.fileSize = status.getSize();
+  key.modTime = modTime.toEpochTime() * 1000000000ULL + modTime.nanoseconds();
+  key.cpuType = MachOLinkingContext::cpuTypeFromArch(arch);
+  key.cpuSubtype = MachOLinkingContext::cpuSubtypeFromArch(arch);
+  llvm::MD5 hash;
+  hashSliceContents(slice, hash);
+  llvm::MD5::MD5Result digest;
+  hash.final(digest);
+  static_assert(sizeof(digest) == sizeof(key.digest), "digest size");
+  memcpy(key.digest, &digest[0], sizeof(key.digest));
+  return std::error_code();
+}
+
+DylibExportCache::DiskKey DylibExportCache::toDisk(const Key &key) {
+  DiskKey diskKey;
+  diskKey.fileSize = key.fileSize;
+  diskKey.modTime = key.modTime;
+  diskKey.cpuType = key.cpuType;
+  diskKey.cpuSubtype = key.cpuSubtype;
+  memcpy(diskKey.digest, key.digest, sizeof(diskKey.digest));
+  return diskKey;
+}
+
+std::string DylibExportCache::entryPath(StringRef cacheDir, StringRef path,
+                                        const Key &key) {
+  DiskKey diskKey = toDisk(key);
+  llvm::MD5 hash;
+  hash.update(path);
+  hash.update(StringRef("\0", 1));
+  hash.update(StringRef(reinterpret_cast<const char *>(&diskKey),
+                        sizeof(diskKey)));
+  llvm::MD5::MD5Result result;
+  hash.final(result);
+  SmallString<32> hex;
+  llvm::MD5::stringifyResult(result, hex);
+
+  SmallString<256> entry(cacheDir);
+  llvm::sys::path::append(entry, hex + ".exports");
+  return entry.str().str();
+}
+
+DylibExportCache::DylibExportCache(std::unique_ptr<MemoryBuffer> mb)
+    : _mb(std::move(mb)) {
+  const char *start = _mb->getBufferStart();
+  _header = reinterpret_cast<const Header *>(start);
+  _exports = reinterpret_cast<const Entry *>(start + sizeof(Header));
+  _reExports = _exports + _header->exportCount;
+}
+
+std::unique_ptr<DylibExportCache> DylibExportCache::load(StringRef path,
+                                                         const Key &key) {
+  ErrorOr<std::unique_ptr<MemoryBuffer>> mbOrErr =
+      MemoryBuffer::getFile(path, -1, /*RequiresNullTerminator=*/false);
+  if (!mbOrErr)
+    return nullptr;
+  std::unique_ptr<MemoryBuffer> &mb = mbOrErr.get();
+  if (mb->getBufferSize() < sizeof(Header))
+    return nullptr;
+  std::unique_ptr<DylibExportCache> cache(new DylibExportCache(std::move(mb)));
+  if (!cache->isValid(key))
+    return nullptr;
+  return cache;
+}
+
+bool DylibExportCache::isValidString(uint32_t offset, uint32_t size) const {
+  return uint64_t(offset) + size <= _mb->getBufferSize();
+}
+
+// Checks that the entry was made from the dylib slice that \p key describes,
+// and that every table and string lies inside the buffer, so that a
+// truncated or foreign file is rejected instead of read out of bounds.
+bool DylibExportCache::isValid(const Key &key) const {
+  if (memcmp(_header->magic, cacheMagic, sizeof(cacheMagic)) != 0 ||
+      _header->version != cacheVersion)
+    return false;
+  const DiskKey &diskKey = _header->key;
+  if (diskKey.fileSize != key.fileSize || diskKey.modTime != key.modTime ||
+      diskKey.cpuType != key.cpuType || diskKey.cpuSubtype != key.cpuSubtype ||
+      memcmp(diskKey.digest, key.digest, sizeof(key.digest)) != 0)
+    return false;
+  uint64_t numEntries =
+      uint64_t(_header->exportCount) + _header->reExportCount;
+  if (sizeof(Header) + numEntries * sizeof(Entry) > _mb->getBufferSize())
+    return false;
+  if (!isValidString(_header->installNameOffset, _header->installNameSize))
+    return false;
+  for (uint32_t i = 0, e = _header->exportCount; i != e; ++i)
+    if (!isValidString(_exports[i].offset, _exports[i].size & ~weakDefFlag))
+      return false;
+  for (uint32_t i = 0, e = _header->reExportCount; i != e; ++i)
+    if (!isValidString(_reExports[i].offset, _reExports[i].size))
+      return false;
+  return true;
+}
+
+DylibExportCache::Export DylibExportCache::find(StringRef name) const {
+  const Entry *end = _exports + _header->exportCount;
+  const Entry *pos = std::lower_bound(
+      _exports, end, name,
+      [&](const Entry &e, StringRef n) { return exportName(e) < n; });
+  if (pos == end || exportName(*pos) != name)
+    return { StringRef(), false };
+  return { exportName(*pos), (pos->size & weakDefFlag) != 0 };
+}
+
+std::error_code DylibExportCache::write(StringRef path, const Key &key,
+                                        const Contents &contents) {
+  std::vector<std::pair<StringRef, bool>> exports = contents.exports;
+  std::sort(exports.begin(), exports.end(),
+            [](const std::pair<StringRef, bool> &a,
+               const std::pair<StringRef, bool> &b) {
+              return a.first < b.first;
+            });
+
+  // Lay out the string pool after the tables.
+  uint64_t offset = sizeof(Header) +
+                    (exports.size() + contents.reExportedDylibs.size()) *
+                        sizeof(Entry);
+  auto addString = [&](StringRef str, Entry &entry) {
+    entry.offset = offset;
+    entry.size = str.size();
+    offset += str.size();
+  };
+
+  Header header;
+  memcpy(header.magic, cacheMagic, sizeof(cacheMagic));
+  header.version = cacheVersion;
+  header.key = toDisk(key);
+  header.currentVersion = contents.currentVersion;
+  header.compatVersion = contents.compatVersion;
+  header.exportCount = exports.size();
+  header.reExportCount = contents.reExportedDylibs.size();
+  Entry installName;
+  addString(contents.installName, installName);
+  header.installNameOffset = installName.offset;
+  header.installNameSize = installName.size;
+  std::vector<Entry> exportEntries(exports.size());
+  for (size_t i = 0, e = exports.size(); i != e; ++i) {
+    addString(exports[i].first, exportEntries[i]);
+    if (exports[i].second)
+      exportEntries[i].size = exportEntries[i].size | weakDefFlag;
+  }
+  std::vector<Entry> reExportEntries(contents.reExportedDylibs.size());
+  for (size_t i = 0, e = reExportEntries.size(); i != e; ++i)
+    addString(contents.reExportedDylibs[i], reExportEntries[i]);
+  if (offset > UINT32_MAX)
+    return std::make_error_code(std::errc::file_too_large);
+
+  if (std::error_code ec =
+          llvm::sys::fs::create_directories(llvm::sys::path::parent_path(path)))
+    return ec;
+  int fd;
+  SmallString<256> tempPath;
+  if (std::error_code ec =
+          llvm::sys::fs::createUniqueFile(path + "-%%%%%%", fd, tempPath))
+    return ec;
+  {
+    llvm::raw_fd_ostream os(fd, /*shouldClose=*/true);
+    os.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    os.write(reinterpret_cast<const char *>(exportEntries.data()),
+             exportEntries.size() * sizeof(Entry));
+    os.write(reinterpret_cast<const char *>(reExportEntries.data()),
+             reExportEntries.size() * sizeof(Entry));
+    os << contents.installName;
+    for (const std::pair<StringRef, bool> &exp : exports)
+      os << exp.first;
+    for (StringRef dylib : contents.reExportedDylibs)
+      os << dylib;
+    os.close();
+    if (os.has_error()) {
+      os.clear_error();
+      llvm::sys::fs::remove(tempPath);
+      return std::make_error_code(std::errc::io_error);
+    }
+  }
+  if (std::error_code ec = llvm::sys::fs::rename(tempPath, path)) {
+    llvm::sys::fs::remove(tempPath);
+    return ec;
+  }
+  return std::error_code();
+}
+
+} // namespace mach_o
+} // namespace lld
@@ -0,0 +1,176 @@
+//===- lib/ReaderWriter/MachO/DylibExportCache.h --------------------------===//
+//
+//                             The LLVM Linker
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+///
+/// \file
+/// \brief On-disk cache of what each linked dylib exports.
+///
+/// Most links pull in the same large SDK dylibs, and decoding their export
+/// tries dominates the time spent loading them. With -dylib_cache_path, the
+/// install name, versions, exported symbols and re-exported dylibs of each
+/// dylib are saved in a small file which later links map and search in
+/// place, without building a per-symbol table.
+///
+/// An entry is named by an MD5 hash of the dylib's path, size, modification
+/// time, the CPU type of the slice linked and a digest of that slice's
+/// LC_UUID, or of its export trie if it has no UUID. A rebuilt dylib thus
+/// gets a new entry even if build tools kept its size and time, and each
+/// slice of a fat dylib gets its own. The entry repeats these in its header
+/// and is ignored if they do not match. The file holds the header, the
+/// export table sorted by name, the re-export table and a string pool; all
+/// fields are little endian 32-bit words, except for the 64-bit size and
+/// time and the 16-byte digest:
+///
+///     header:    magic[8], version, size, modification time,
+///                cpu type, cpu subtype, digest[16],
+///                currentVersion, compatVersion,
+///                installName offset, installName size,
+///                export count, re-export count
+///     exports:   { name offset, name size | weakDefFlag } ...
+///     reexports: { path offset, path size } ...
+///     strings
+///
+//===----------------------------------------------------------------------===//
+
+#ifndef LLD_READER_WRITER_MACHO_DYLIB_EXPORT_CACHE_H
+#define LLD_READER_WRITER_MACHO_DYLIB_EXPORT_CACHE_H
+
+#include "lld/Core/LLVM.h"
+#include "lld/ReaderWriter/MachOLinkingContext.h"
+#include "llvm/ADT/StringRef.h"
+#include "llvm/Support/Endian.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include <memory>
+#include <string>
+#include <system_error>
+#include <utility>
+#include <vector>
+
+namespace lld {
+namespace mach_o {
+
+class DylibExportCache {
+public:
+  /// A symbol exported by the cached dylib. The name is empty if the dylib
+  /// does not export the symbol looked up.
+  struct Export {
+    StringRef name;
+    bool weakDef;
+  };
+
+  /// Everything needed to write a cache entry.
+  struct Contents {
+    StringRef installName;
+    uint32_t currentVersion;
+    uint32_t compatVersion;
+    std::vector<std::pair<StringRef, bool>> exports;
+    std::vector<StringRef> reExportedDylibs;
+  };
+
+  /// Identifies the slice of a dylib that an entry was made from. Finding
+  /// an entry costs a stat() of the dylib and a read of the slice's load
+  /// commands rather than a pass over its contents. The digest catches a
+  /// dylib rebuilt with the same size and modification time, which build
+  /// systems that fix timestamps produce.
+  struct Key {
+    uint64_t fileSize;
+    uint64_t modTime;
+    uint32_t cpuType;
+    uint32_t cpuSubtype;
+    uint8_t digest[16];
+  };
+
+  /// Sets \p key for \p slice, the mapped slice for \p arch of the dylib
+  /// at \p path.
+  static std::error_code getKey(StringRef path, StringRef slice,
+                                MachOLinkingContext::Arch arch, Key &key);
+
+  /// Returns the path of the cache entry in \p cacheDir for the dylib at
+  /// \p path with \p key.
+  static std::string entryPath(StringRef cacheDir, StringRef path,
+                               const Key &key);
+
+  /// Maps the cache entry at \p path. Returns null if there is no such
+  /// entry, if it is malformed, or if it was made from another file or
+  /// slice than \p key describes, in which case the dylib must be parsed.
+  static std::unique_ptr<DylibExportCache> load(StringRef path,
+                                                const Key &key);
+
+  /// Writes \p contents as the cache entry at \p path for the dylib with
+  /// \p key. The entry is written to a temporary file first and renamed, so
+  /// that concurrent links never map a partial one.
+  static std::error_code write(StringRef path, const Key &key,
+                               const Contents &contents);
+
+  StringRef installName() const {
+    return string(_header->installNameOffset, _header->installNameSize);
+  }
+  uint32_t currentVersion() const { return _header->currentVersion; }
+  uint32_t compatVersion() const { return _header->compatVersion; }
+
+  /// Binary searches the export table for \p name.
+  Export find(StringRef name) const;
+
+  unsigned numReExportedDylibs() const { return _header->reExportCount; }
+  StringRef reExportedDylib(unsigned i) const {
+    return string(_reExports[i].offset, _reExports[i].size);
+  }
+
+private:
+  typedef llvm::support::ulittle32_t ulittle32_t;
+  typedef llvm::support::ulittle64_t ulittle64_t;
+
+  struct DiskKey {
+    ulittle64_t fileSize;
+    ulittle64_t modTime;
+    ulittle32_t cpuType;
+    ulittle32_t cpuSubtype;
+    uint8_t digest[16];
+  };
+
+  struct Header {
+    char magic[8];
+    ulittle32_t version;
+    DiskKey key;
+    ulittle32_t currentVersion;
+    ulittle32_t compatVersion;
+    ulittle32_t installNameOffset;
+    ulittle32_t installNameSize;
+    ulittle32_t exportCount;
+    ulittle32_t reExportCount;
+  };
+
+  struct Entry {
+    ulittle32_t offset;
+    ulittle32_t size;
+  };
+
+  static const uint32_t weakDefFlag = 0x80000000U;
+
+  explicit DylibExportCache(std::unique_ptr<MemoryBuffer> mb);
+
+  static DiskKey toDisk(const Key &key);
+  bool isValid(const Key &key) const;
+  bool isValidString(uint32_t offset, uint32_t size) const;
+  StringRef string(uint32_t offset, uint32_t size) const {
+    return StringRef(_mb->getBufferStart() + offset, size);
+  }
+  StringRef exportName(const Entry &e) const {
+    return string(e.offset, e.size & ~weakDefFlag);
+  }
+
+  std::unique_ptr<MemoryBuffer> _mb;
+  const Header *_header;
+  const Entry *_exports;
+  const Entry *_reExports;
+};
+
+} // namespace mach_o
+} // namespace lld
+
+#endif // LLD_READER_WRITER_MACHO_DYLIB_EXPORT_CACHE_H
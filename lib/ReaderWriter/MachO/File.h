@@ -11,6 +11,7 @@
 #define LLD_READER_WRITER_MACHO_FILE_H
 
 #include "Atoms.h"
+#include "DylibExportCache.h"
 #include "MachONormalizedFile.h"
 #include "lld/Core/SharedLibraryFile.h"
 #include "lld/Core/Simple.h"
@@ -177,8 +178,9 @@ public:
 
 protected:
   std::error_code doParse() override {
-    // Convert binary file to normalized mach-o.
-    auto normFile = normalized::readBinary(_mb, _ctx->arch());
+    // Convert binary file to normalized mach-o. Relocations are decoded
+    // straight from the mapped file as they are turned into References.
+    auto normFile = normalized::readBinary(_mb, _ctx->arch(), false);
     if (std::error_code ec = normFile.getError())
       return ec;
     // Convert normalized mach-o to atoms.
@@ -260,6 +262,24 @@ public:
   StringRef getDSOName() const override { return _installName; }
 
   std::error_code doParse() override {
+    // With -dylib_cache_path, use the saved exports if this slice of this
+    // dylib has been seen before. The entry is keyed by the arch linked, and
+    // only written once readBinary() has accepted the slice for that arch,
+    // so a dylib of the wrong arch is still reported below.
+    std::string cachePath;
+    DylibExportCache::Key cacheKey;
+    StringRef path = _mb->getBufferIdentifier();
+    if (!_ctx->dylibCachePath().empty() &&
+        !DylibExportCache::getKey(path, _mb->getBuffer(), _ctx->arch(),
+                                  cacheKey)) {
+      cachePath =
+          DylibExportCache::entryPath(_ctx->dylibCachePath(), path, cacheKey);
+      if (std::unique_ptr<DylibExportCache> cache =
+              DylibExportCache::load(cachePath, cacheKey)) {
+        loadFromCache(std::move(cache));
+        return std::error_code();
+      }
+    }
     // Convert binary file to normalized mach-o.
     auto normFile = normalized::readBinary(_mb, _ctx->arch());
     if (std::error_code ec = normFile.getError())
@@ -268,6 +288,9 @@ public:
     if (std::error_code ec = normalized::normalizedDylibToAtoms(
             this, **normFile, false))
       return ec;
+    // The cache only saves work, so a failure to write it is not an error.
+    if (!cachePath.empty())
+      DylibExportCache::write(cachePath, cacheKey, cacheContents());
     return std::error_code();
   }
 
@@ -276,6 +299,12 @@ private:
                                    StringRef installName) const {
     // First, check if requested symbol is directly implemented by this dylib.
     auto entry = _nameToAtom.find(name);
+    if (entry == _nameToAtom.end() && _exportCache) {
+      // Symbols of a cached dylib are only added to _nameToAtom once used.
+      DylibExportCache::Export exp = _exportCache->find(name);
+      if (!exp.name.empty())
+        entry = _nameToAtom.emplace(exp.name, AtomAndFlags(exp.weakDef)).first;
+    }
     if (entry != _nameToAtom.end()) {
       if (!entry->second.atom) {
         // Lazily create SharedLibraryAtom.
@@ -298,6 +327,26 @@ private:
     return nullptr;
   }
 
+  void loadFromCache(std::unique_ptr<DylibExportCache> cache) {
+    _installName = cache->installName();
+    _currentVersion = cache->currentVersion();
+    _compatVersion = cache->compatVersion();
+    for (unsigned i = 0, e = cache->numReExportedDylibs(); i != e; ++i)
+      addReExportedDylib(cache->reExportedDylib(i));
+    _exportCache = std::move(cache);
+  }
+
+  DylibExportCache::Contents cacheContents() const {
+    DylibExportCache::Contents contents;
+    contents.installName = _installName;
+    contents.currentVersion = _currentVersion;
+    contents.compatVersion = _compatVersion;
+    for (const auto &entry : _nameToAtom)
+      contents.exports.emplace_back(entry.first, entry.second.weakDef);
+    for (const ReExportedDylib &dylib : _reExportedDylibs)
+      contents.reExportedDylibs.push_back(dylib.path);
+    return contents;
+  }
 
   struct ReExportedDylib {
     ReExportedDylib(StringRef p) : path(p), file(nullptr) { }
@@ -318,6 +367,7 @@ private:
   uint32_t                                   _currentVersion;
   uint32_t                                   _compatVersion;
   std::vector<ReExportedDylib>               _reExportedDylibs;
+  std::unique_ptr<DylibExportCache>          _exportCache;
   mutable std::unordered_map<StringRef, AtomAndFlags> _nameToAtom;
 };
 
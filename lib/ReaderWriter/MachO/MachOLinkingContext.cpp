@@ -13,6 +13,7 @@
 #include "MachONormalizedFile.h"
 #include "MachOPasses.h"
 #include "lld/Core/ArchiveLibraryFile.h"
+#include "lld/Core/ICF.h"
 #include "lld/Core/PassManager.h"
 #include "lld/Core/Reader.h"
 #include "lld/Core/Writer.h"
@@ -144,7 +145,9 @@ MachOLinkingContext::MachOLinkingContext()
       _osMinVersion(0), _pageZeroSize(0), _pageSize(4096), _baseAddress(0),
       _stackSize(0), _compatibilityVersion(0), _currentVersion(0),
       _deadStrippableDylib(false), _printAtoms(false), _testingFileUsage(false),
-      _keepPrivateExterns(false), _demangle(false), _archHandler(nullptr),
+      _testBranchReach(0),
+      _keepPrivateExterns(false), _demangle(false),
+      _mergeSymbolStrings(false), _archHandler(nullptr),
       _exportMode(ExportMode::globals),
       _debugInfoMode(DebugInfoMode::addDebugMap), _orderFileEntries(0) {}
 
@@ -336,6 +339,22 @@ bool MachOLinkingContext::needsShimPass() const {
   }
 }
 
+bool MachOLinkingContext::needsBranchIslandPass() const {
+  // Branch islands are only used in final images.
+  if (_outputMachOType == MH_OBJECT)
+    return false;
+  // Only arm arches have branches that may not reach across the image.
+  switch (_arch) {
+  case arch_armv6:
+  case arch_armv7:
+  case arch_armv7s:
+  case arch_arm64:
+    return true;
+  default:
+    return false;
+  }
+}
+
 StringRef MachOLinkingContext::binderSymbolName() const {
   return archHandler().stubInfo().binderSymbolName;
 }
@@ -581,6 +600,12 @@ bool MachOLinkingContext::validateImpl(raw_ostream &diagnostics) {
 }
 
 void MachOLinkingContext::addPasses(PassManager &pm) {
+  // A relocatable output is linked again, so its functions keep their own
+  // addresses.
+  if (icfMode() != ICFMode::None && _outputMachOType != MH_OBJECT)
+    pm.add(llvm::make_unique<ICFPass>(*this));
+  if (!callGraphProfile().empty())
+    mach_o::addCallGraphOrderPass(pm, *this);
   mach_o::addLayoutPass(pm, *this);
   if (needsStubsPass())
     mach_o::addStubsPass(pm, *this);
@@ -590,6 +615,9 @@ void MachOLinkingContext::addPasses(PassManager &pm) {
     mach_o::addGOTPass(pm, *this);
   if (needsShimPass())
     mach_o::addShimPass(pm, *this); // Shim pass must run after stubs pass.
+  // Branch island pass must run last, once all code atoms exist.
+  if (needsBranchIslandPass())
+    mach_o::addBranchIslandPass(pm, *this);
 }
 
 Writer &MachOLinkingContext::writer() const {
@@ -730,6 +758,11 @@ ArchHandler &MachOLinkingContext::archHandler() const {
   return *_archHandler;
 }
 
+bool MachOLinkingContext::isCallReference(const DefinedAtom &atom,
+                                          const Reference &ref) const {
+  return archHandler().isCallSite(ref);
+}
+
 
 void MachOLinkingContext::addSectionAlignment(StringRef seg, StringRef sect,
                                               uint16_t align) {
@@ -873,6 +906,10 @@ void MachOLinkingContext::appendOrderedSymbol(StringRef symbol,
   _orderFiles[symbol].push_back(info);
 }
 
+bool MachOLinkingContext::isOrderedSymbol(StringRef symbol) const {
+  return _orderFiles.count(symbol);
+}
+
 bool
 MachOLinkingContext::findOrderOrdinal(const std::vector<OrderFileNode> &nodes,
                                       const DefinedAtom *atom,
@@ -48,6 +48,7 @@
 #include "llvm/Support/ErrorOr.h"
 #include "llvm/Support/MachO.h"
 #include "llvm/Support/YAMLTraits.h"
+#include <functional>
 
 #ifndef LLD_READER_WRITER_MACHO_NORMALIZE_FILE_H
 #define LLD_READER_WRITER_MACHO_NORMALIZE_FILE_H
@@ -69,6 +70,9 @@ using llvm::MachO::ExportSymbolKind;
 using llvm::MachO::DataRegionType;
 
 namespace lld {
+
+class TaskGroup;
+
 namespace mach_o {
 namespace normalized {
 
@@ -119,6 +123,16 @@ struct Section {
   ArrayRef<uint8_t> content;
   Relocations     relocations;
   IndirectSymbols indirectSymbols;
+
+  // Set instead of relocations when readBinary() leaves them packed in the
+  // mapped file, for normalizedObjectToAtoms() to decode one at a time.
+  ArrayRef<llvm::MachO::any_relocation_info> packedRelocations;
+
+  // When set, content only records the size of the section (its data pointer
+  // is null), and the content is written by this function straight into the
+  // output buffer. The function may spawn that work into the TaskGroup, which
+  // the writer waits on once the writers of all sections have been called.
+  std::function<void (uint8_t *, TaskGroup &)> contentWriter;
 };
 
 
@@ -214,7 +228,8 @@ struct NormalizedFile {
                      fileType(llvm::MachO::MH_OBJECT),
                      flags(0),
                      hasUUID(false),
-                     os(MachOLinkingContext::OS::unknown) { }
+                     os(MachOLinkingContext::OS::unknown),
+                     mergeSymbolStrings(false) { }
 
   MachOLinkingContext::Arch   arch;
   HeaderFileType              fileType;
@@ -250,6 +265,9 @@ struct NormalizedFile {
   std::vector<Export>         exportInfo;
   std::vector<DataInCode>     dataInCode;
 
+  // Share identical names and name suffixes in the symbol string pool.
+  bool                        mergeSymbolStrings;
+
   // TODO:
   // code-signature
   // split-seg-info
@@ -268,10 +286,13 @@ bool isThinObjectFile(StringRef path, MachOLinkingContext::Arch &arch);
 bool sliceFromFatFile(MemoryBufferRef mb, MachOLinkingContext::Arch arch,
                       uint32_t &offset, uint32_t &size);
 
-/// Reads a mach-o file and produces an in-memory normalized view.
+/// Reads a mach-o file and produces an in-memory normalized view. Unless
+/// \p decodeRelocations is set, section relocations are left packed in \p mb
+/// (see Section::packedRelocations), which must then outlive the view.
 ErrorOr<std::unique_ptr<NormalizedFile>>
 readBinary(std::unique_ptr<MemoryBuffer> &mb,
-           const MachOLinkingContext::Arch arch);
+           const MachOLinkingContext::Arch arch,
+           bool decodeRelocations = true);
 
 /// Takes in-memory normalized view and writes a mach-o object file.
 std::error_code writeBinary(const NormalizedFile &file, StringRef path);
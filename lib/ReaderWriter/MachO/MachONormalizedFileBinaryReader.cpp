@@ -92,6 +92,17 @@ static std::error_code appendRelocations(Relocations &relocs, StringRef buffer,
   return std::error_code();
 }
 
+static std::error_code
+findPackedRelocations(ArrayRef<any_relocation_info> &relocs, StringRef buffer,
+                      uint32_t reloff, uint32_t nreloc) {
+  if ((reloff + nreloc*8) > buffer.size())
+    return make_error_code(llvm::errc::executable_format_error);
+  relocs = llvm::makeArrayRef(
+      reinterpret_cast<const any_relocation_info*>(buffer.begin()+reloff),
+      nreloc);
+  return std::error_code();
+}
+
 static std::error_code
 appendIndirectSymbols(IndirectSymbols &isyms, StringRef buffer, bool isBig,
                       uint32_t istOffset, uint32_t istCount,
@@ -201,7 +212,8 @@ bool sliceFromFatFile(MemoryBufferRef mb, MachOLinkingContext::Arch arch,
 /// Reads a mach-o file and produces an in-memory normalized view.
 ErrorOr<std::unique_ptr<NormalizedFile>>
 readBinary(std::unique_ptr<MemoryBuffer> &mb,
-           const MachOLinkingContext::Arch arch) {
+           const MachOLinkingContext::Arch arch,
+           bool decodeRelocations) {
   // Make empty NormalizedFile.
   std::unique_ptr<NormalizedFile> f(new NormalizedFile());
 
@@ -305,9 +317,14 @@ readBinary(std::unique_ptr<MemoryBuffer> &mb,
           // Note: this assign() is copying the content bytes.  Ideally,
           // we can use a custom allocator for vector to avoid the copy.
           section.content = llvm::makeArrayRef(content, contentSize);
-          appendRelocations(section.relocations, mb->getBuffer(), isBig,
-                            read32(&sect->reloff, isBig),
-                            read32(&sect->nreloc, isBig));
+          if (decodeRelocations)
+            appendRelocations(section.relocations, mb->getBuffer(), isBig,
+                              read32(&sect->reloff, isBig),
+                              read32(&sect->nreloc, isBig));
+          else
+            findPackedRelocations(section.packedRelocations, mb->getBuffer(),
+                                  read32(&sect->reloff, isBig),
+                                  read32(&sect->nreloc, isBig));
           if (section.type == S_NON_LAZY_SYMBOL_POINTERS) {
             appendIndirectSymbols(section.indirectSymbols, mb->getBuffer(),
                                   isBig,
@@ -349,9 +366,14 @@ readBinary(std::unique_ptr<MemoryBuffer> &mb,
           // Note: this assign() is copying the content bytes.  Ideally,
           // we can use a custom allocator for vector to avoid the copy.
           section.content = llvm::makeArrayRef(content, contentSize);
-          appendRelocations(section.relocations, mb->getBuffer(), isBig,
-                            read32(&sect->reloff, isBig),
-                            read32(&sect->nreloc, isBig));
+          if (decodeRelocations)
+            appendRelocations(section.relocations, mb->getBuffer(), isBig,
+                              read32(&sect->reloff, isBig),
+                              read32(&sect->nreloc, isBig));
+          else
+            findPackedRelocations(section.packedRelocations, mb->getBuffer(),
+                                  read32(&sect->reloff, isBig),
+                                  read32(&sect->nreloc, isBig));
           if (section.type == S_NON_LAZY_SYMBOL_POINTERS) {
             appendIndirectSymbols(
                 section.indirectSymbols, mb->getBuffer(), isBig,
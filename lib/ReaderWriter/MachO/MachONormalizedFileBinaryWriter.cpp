@@ -25,6 +25,7 @@
 #include "MachONormalizedFileBinaryUtils.h"
 #include "lld/Core/Error.h"
 #include "lld/Core/LLVM.h"
+#include "lld/Core/Parallel.h"
 #include "llvm/ADT/SmallString.h"
 #include "llvm/ADT/SmallVector.h"
 #include "llvm/ADT/StringRef.h"
@@ -39,10 +40,12 @@
 #include "llvm/Support/MachO.h"
 #include "llvm/Support/MemoryBuffer.h"
 #include "llvm/Support/raw_ostream.h"
+#include <algorithm>
 #include <functional>
-#include <list>
 #include <map>
+#include <numeric>
 #include <system_error>
+#include <tuple>
 
 using namespace llvm::MachO;
 
@@ -89,9 +92,11 @@ private:
   void        buildExportTrie();
   void        computeDataInCodeSize();
   void        computeSymbolTableSizes();
+  uint32_t    layoutSymbolStrings(ArrayRef<StringRef> names);
+  uint32_t    layoutMergedSymbolStrings(ArrayRef<StringRef> names);
   void        buildSectionRelocations();
   void        appendSymbols(const std::vector<Symbol> &symbols,
-                                      uint32_t &symOffset, uint32_t &strOffset);
+                            uint32_t startIndex);
   uint32_t    indirectSymbolIndex(const Section &sect, uint32_t &index);
   uint32_t    indirectSymbolElementSize(const Section &sect);
 
@@ -159,26 +164,25 @@ private:
 
   struct TrieEdge {
     TrieEdge(StringRef s, TrieNode *node) : _subString(s), _child(node) {}
-    ~TrieEdge() {}
 
     StringRef          _subString;
     struct TrieNode   *_child;
   };
 
   struct TrieNode {
-    TrieNode(StringRef s)
-        : _cummulativeString(s), _address(0), _flags(0), _other(0),
+    TrieNode(uint32_t depth)
+        : _depth(depth), _address(0), _flags(0), _other(0),
           _trieOffset(0), _hasExportInfo(false) {}
-    ~TrieNode() {}
 
-    void addSymbol(const Export &entry, BumpPtrAllocator &allocator,
-                   std::vector<TrieNode *> &allNodes);
+    void setExport(const Export &entry);
     bool updateOffset(uint32_t &offset);
     void appendToByteBuffer(ByteBuffer &out);
 
+    // Length of the symbol name prefix this node stands for.
+    uint32_t                  _depth;
+    SmallVector<TrieEdge, 2>  _children;
+
 private:
-    StringRef                 _cummulativeString;
-    std::list<TrieEdge>       _children;
     uint64_t                  _address;
     uint64_t                  _flags;
     uint64_t                  _other;
@@ -198,6 +202,9 @@ private:
   };
   typedef std::map<const Section*, SectionExtraInfo> SectionMap;
 
+  // A string of the symbol string pool and its offset in the pool.
+  typedef std::pair<StringRef, uint32_t> PoolString;
+
   const NormalizedFile &_file;
   std::error_code _ec;
   uint8_t              *_buffer;
@@ -218,6 +225,8 @@ private:
   uint32_t              _symbolTableGlobalsStartIndex;
   uint32_t              _symbolTableUndefinesStartIndex;
   uint32_t              _symbolStringPoolSize;
+  std::vector<uint32_t> _symbolStringOffsets;
+  std::vector<PoolString> _symbolStrings;
   uint32_t              _symbolTableSize;
   uint32_t              _dataInCodeSize;
   uint32_t              _indirectSymbolTableCount;
@@ -884,6 +893,9 @@ std::error_code MachOFileLayout::writeLoadCommands() {
 
 
 void MachOFileLayout::writeSectionContent() {
+  // Content writers spawn their work into tg, so that the content of all
+  // sections is generated in a single parallel stage.
+  TaskGroup tg;
   for (const Section &s : _file.sections) {
     // Copy all section content to output buffer.
     if (s.type == llvm::MachO::S_ZEROFILL)
@@ -892,9 +904,12 @@ void MachOFileLayout::writeSectionContent() {
       continue;
     uint32_t offset = _sectInfo[&s].fileOffset;
     uint8_t *p = &_buffer[offset];
-    memcpy(p, &s.content[0], s.content.size());
-    p += s.content.size();
+    if (s.contentWriter)
+      s.contentWriter(p, tg);
+    else
+      memcpy(p, &s.content[0], s.content.size());
   }
+  tg.sync();
 }
 
 void MachOFileLayout::writeRelocations() {
@@ -911,33 +926,32 @@ void MachOFileLayout::writeRelocations() {
 
 
 void MachOFileLayout::appendSymbols(const std::vector<Symbol> &symbols,
-                                   uint32_t &symOffset, uint32_t &strOffset) {
-  for (const Symbol &sym : symbols) {
+                                    uint32_t startIndex) {
+  const size_t nlistSize = (_is64 ? sizeof(nlist_64) : sizeof(nlist));
+  parallel_for(size_t(0), symbols.size(), [&](size_t i) {
+    const Symbol &sym = symbols[i];
+    uint32_t index = startIndex + i;
+    uint8_t *p = &_buffer[_startOfSymbols + index * nlistSize];
     if (_is64) {
-      nlist_64* nb = reinterpret_cast<nlist_64*>(&_buffer[symOffset]);
-      nb->n_strx = strOffset - _startOfSymbolStrings;
+      nlist_64* nb = reinterpret_cast<nlist_64*>(p);
+      nb->n_strx = _symbolStringOffsets[index];
       nb->n_type = sym.type | sym.scope;
       nb->n_sect = sym.sect;
       nb->n_desc = sym.desc;
       nb->n_value = sym.value;
       if (_swap)
         swapStruct(*nb);
-      symOffset += sizeof(nlist_64);
     } else {
-      nlist* nb = reinterpret_cast<nlist*>(&_buffer[symOffset]);
-      nb->n_strx = strOffset - _startOfSymbolStrings;
+      nlist* nb = reinterpret_cast<nlist*>(p);
+      nb->n_strx = _symbolStringOffsets[index];
       nb->n_type = sym.type | sym.scope;
       nb->n_sect = sym.sect;
       nb->n_desc = sym.desc;
       nb->n_value = sym.value;
       if (_swap)
         swapStruct(*nb);
-      symOffset += sizeof(nlist);
     }
-    memcpy(&_buffer[strOffset], sym.name.begin(), sym.name.size());
-    strOffset += sym.name.size();
-    _buffer[strOffset++] ='\0'; // Strings in table have nul terminator.
-  }
+  });
 }
 
 void MachOFileLayout::writeDataInCodeInfo() {
@@ -956,12 +970,17 @@ void MachOFileLayout::writeDataInCodeInfo() {
 
 void MachOFileLayout::writeSymbolTable() {
   // Write symbol table and symbol strings in parallel.
-  uint32_t symOffset = _startOfSymbols;
-  uint32_t strOffset = _startOfSymbolStrings;
-  _buffer[strOffset++] = '\0'; // Reserve n_strx offset of zero to mean no name.
-  appendSymbols(_file.localSymbols, symOffset, strOffset);
-  appendSymbols(_file.globalSymbols, symOffset, strOffset);
-  appendSymbols(_file.undefinedSymbols, symOffset, strOffset);
+  appendSymbols(_file.localSymbols, _symbolTableLocalsStartIndex);
+  appendSymbols(_file.globalSymbols, _symbolTableGlobalsStartIndex);
+  appendSymbols(_file.undefinedSymbols, _symbolTableUndefinesStartIndex);
+  // Reserve n_strx offset of zero to mean no name.
+  _buffer[_startOfSymbolStrings] = '\0';
+  parallel_for(size_t(0), _symbolStrings.size(), [&](size_t i) {
+    StringRef str = _symbolStrings[i].first;
+    uint8_t *p = &_buffer[_startOfSymbolStrings + _symbolStrings[i].second];
+    memcpy(p, str.data(), str.size());
+    p[str.size()] = '\0'; // Strings in table have nul terminator.
+  });
   // Write indirect symbol table array.
   uint32_t *indirects = reinterpret_cast<uint32_t*>
                                             (&_buffer[_startOfIndirectSymbols]);
@@ -1023,33 +1042,164 @@ void MachOFileLayout::buildSectionRelocations() {
 }
 
 void MachOFileLayout::buildRebaseInfo() {
-  // TODO: compress rebasing info.
-  for (const RebaseLocation& entry : _file.rebasingInfo) {
-    _rebaseInfo.append_byte(REBASE_OPCODE_SET_TYPE_IMM | entry.kind);
-    _rebaseInfo.append_byte(REBASE_OPCODE_SET_SEGMENT_AND_OFFSET_ULEB
-                            | entry.segIndex);
-    _rebaseInfo.append_uleb128(entry.segOffset);
-    _rebaseInfo.append_uleb128(REBASE_OPCODE_DO_REBASE_IMM_TIMES | 1);
+  // Sort the locations by address, so that runs of pointers can be rebased
+  // by a single opcode and the address only moves forward.
+  std::vector<RebaseLocation> locs(_file.rebasingInfo.begin(),
+                                   _file.rebasingInfo.end());
+  std::sort(locs.begin(), locs.end(),
+            [](const RebaseLocation &a, const RebaseLocation &b) {
+    if (a.segIndex != b.segIndex)
+      return a.segIndex < b.segIndex;
+    return a.segOffset < b.segOffset;
+  });
+
+  const uint64_t ptrSize = _is64 ? 8 : 4;
+  // dyld starts with no segment and type 0.
+  int curSeg = -1;
+  uint64_t curOffset = 0;
+  uint8_t curKind = 0;
+  // Locations i and j can be in one run if they differ only in offset.
+  auto sameRun = [&](size_t i, size_t j) {
+    return j < locs.size() && locs[j].segIndex == locs[i].segIndex &&
+           locs[j].kind == locs[i].kind;
+  };
+  for (size_t i = 0, e = locs.size(); i != e;) {
+    const RebaseLocation &entry = locs[i];
+    if (entry.kind != curKind) {
+      _rebaseInfo.append_byte(REBASE_OPCODE_SET_TYPE_IMM | entry.kind);
+      curKind = entry.kind;
+    }
+    uint64_t offset = entry.segOffset;
+    if (entry.segIndex != curSeg || offset < curOffset) {
+      _rebaseInfo.append_byte(REBASE_OPCODE_SET_SEGMENT_AND_OFFSET_ULEB
+                              | entry.segIndex);
+      _rebaseInfo.append_uleb128(offset);
+      curSeg = entry.segIndex;
+    } else if (offset != curOffset) {
+      uint64_t delta = offset - curOffset;
+      if (delta % ptrSize == 0 && delta / ptrSize <= REBASE_IMMEDIATE_MASK) {
+        _rebaseInfo.append_byte(REBASE_OPCODE_ADD_ADDR_IMM_SCALED
+                                | (delta / ptrSize));
+      } else {
+        _rebaseInfo.append_byte(REBASE_OPCODE_ADD_ADDR_ULEB);
+        _rebaseInfo.append_uleb128(delta);
+      }
+    }
+
+    // Count the pointers that follow each other, or failing that, the
+    // pointers that are evenly spaced.
+    size_t j = i + 1;
+    while (sameRun(i, j) && locs[j].segOffset == locs[j-1].segOffset + ptrSize)
+      ++j;
+    uint64_t stride = ptrSize;
+    if (j == i + 1 && sameRun(i, j) && locs[j].segOffset > offset + ptrSize) {
+      stride = locs[j].segOffset - offset;
+      while (sameRun(i, j) && locs[j].segOffset == locs[j-1].segOffset + stride)
+        ++j;
+      // Two locations are as cheap to rebase one by one.
+      if (j == i + 2)
+        j = i + 1;
+    }
+    uint64_t count = j - i;
+    if (count > 1 && stride != ptrSize) {
+      _rebaseInfo.append_byte(REBASE_OPCODE_DO_REBASE_ULEB_TIMES_SKIPPING_ULEB);
+      _rebaseInfo.append_uleb128(count);
+      _rebaseInfo.append_uleb128(stride - ptrSize);
+    } else if (count <= REBASE_IMMEDIATE_MASK) {
+      _rebaseInfo.append_byte(REBASE_OPCODE_DO_REBASE_IMM_TIMES | count);
+    } else {
+      _rebaseInfo.append_byte(REBASE_OPCODE_DO_REBASE_ULEB_TIMES);
+      _rebaseInfo.append_uleb128(count);
+    }
+    curOffset = offset + count * (count > 1 ? stride : ptrSize);
+    i = j;
   }
   _rebaseInfo.append_byte(REBASE_OPCODE_DONE);
   _rebaseInfo.align(_is64 ? 8 : 4);
 }
 
 void MachOFileLayout::buildBindInfo() {
-  // TODO: compress bind info.
-  uint64_t lastAddend = 0;
-  for (const BindLocation& entry : _file.bindingInfo) {
-    _bindingInfo.append_byte(BIND_OPCODE_SET_TYPE_IMM | entry.kind);
-    _bindingInfo.append_byte(BIND_OPCODE_SET_SEGMENT_AND_OFFSET_ULEB
-                            | entry.segIndex);
-    _bindingInfo.append_uleb128(entry.segOffset);
-    _bindingInfo.append_byte(BIND_OPCODE_SET_DYLIB_ORDINAL_IMM | entry.ordinal);
-    _bindingInfo.append_byte(BIND_OPCODE_SET_SYMBOL_TRAILING_FLAGS_IMM);
-    _bindingInfo.append_string(entry.symbolName);
-    if (entry.addend != lastAddend) {
+  // Group the locations by symbol, so that the ordinal, symbol and addend
+  // are only set once per symbol, and sort each group by address.
+  std::vector<BindLocation> locs(_file.bindingInfo.begin(),
+                                 _file.bindingInfo.end());
+  std::stable_sort(locs.begin(), locs.end(),
+                   [](const BindLocation &a, const BindLocation &b) {
+    return std::tie(a.ordinal, a.symbolName, a.addend, a.kind, a.segIndex,
+                    a.segOffset) < std::tie(b.ordinal, b.symbolName, b.addend,
+                                            b.kind, b.segIndex, b.segOffset);
+  });
+
+  const uint64_t ptrSize = _is64 ? 8 : 4;
+  // dyld starts with no segment, ordinal 0, type 0 and addend 0.
+  int curSeg = -1;
+  uint64_t curOffset = 0;
+  uint8_t curKind = 0;
+  int curOrdinal = 0;
+  StringRef curSymbol;
+  bool hasSymbol = false;
+  uint64_t curAddend = 0;
+  for (size_t i = 0, e = locs.size(); i != e; ++i) {
+    const BindLocation &entry = locs[i];
+    if (entry.ordinal != curOrdinal) {
+      if (entry.ordinal <= 0)
+        _bindingInfo.append_byte(BIND_OPCODE_SET_DYLIB_SPECIAL_IMM |
+                                 (entry.ordinal & BIND_IMMEDIATE_MASK));
+      else if (entry.ordinal <= BIND_IMMEDIATE_MASK)
+        _bindingInfo.append_byte(BIND_OPCODE_SET_DYLIB_ORDINAL_IMM |
+                                 entry.ordinal);
+      else {
+        _bindingInfo.append_byte(BIND_OPCODE_SET_DYLIB_ORDINAL_ULEB);
+        _bindingInfo.append_uleb128(entry.ordinal);
+      }
+      curOrdinal = entry.ordinal;
+    }
+    if (!hasSymbol || entry.symbolName != curSymbol) {
+      _bindingInfo.append_byte(BIND_OPCODE_SET_SYMBOL_TRAILING_FLAGS_IMM);
+      _bindingInfo.append_string(entry.symbolName);
+      curSymbol = entry.symbolName;
+      hasSymbol = true;
+    }
+    if (entry.kind != curKind) {
+      _bindingInfo.append_byte(BIND_OPCODE_SET_TYPE_IMM | entry.kind);
+      curKind = entry.kind;
+    }
+    if (entry.addend != curAddend) {
       _bindingInfo.append_byte(BIND_OPCODE_SET_ADDEND_SLEB);
       _bindingInfo.append_sleb128(entry.addend);
-      lastAddend = entry.addend;
+      curAddend = entry.addend;
+    }
+    uint64_t offset = entry.segOffset;
+    if (entry.segIndex != curSeg || offset < curOffset) {
+      _bindingInfo.append_byte(BIND_OPCODE_SET_SEGMENT_AND_OFFSET_ULEB
+                               | entry.segIndex);
+      _bindingInfo.append_uleb128(offset);
+      curSeg = entry.segIndex;
+    } else if (offset != curOffset) {
+      _bindingInfo.append_byte(BIND_OPCODE_ADD_ADDR_ULEB);
+      _bindingInfo.append_uleb128(offset - curOffset);
+    }
+
+    // If the next location binds the same symbol further on in the same
+    // segment, move there as part of the bind.
+    curOffset = offset + ptrSize;
+    if (i + 1 != e) {
+      const BindLocation &next = locs[i + 1];
+      if (next.ordinal == entry.ordinal &&
+          next.symbolName == entry.symbolName &&
+          next.addend == entry.addend && next.kind == entry.kind &&
+          next.segIndex == entry.segIndex && next.segOffset > curOffset) {
+        uint64_t delta = next.segOffset - curOffset;
+        if (delta % ptrSize == 0 && delta / ptrSize <= BIND_IMMEDIATE_MASK) {
+          _bindingInfo.append_byte(BIND_OPCODE_DO_BIND_ADD_ADDR_IMM_SCALED
+                                   | (delta / ptrSize));
+        } else {
+          _bindingInfo.append_byte(BIND_OPCODE_DO_BIND_ADD_ADDR_ULEB);
+          _bindingInfo.append_uleb128(delta);
+        }
+        curOffset = next.segOffset;
+        continue;
+      }
     }
     _bindingInfo.append_byte(BIND_OPCODE_DO_BIND);
   }
@@ -1073,64 +1223,19 @@ void MachOFileLayout::buildLazyBindInfo() {
   _lazyBindingInfo.align(_is64 ? 8 : 4);
 }
 
-void MachOFileLayout::TrieNode::addSymbol(const Export& entry,
-                                          BumpPtrAllocator &allocator,
-                                          std::vector<TrieNode*> &allNodes) {
-  StringRef partialStr = entry.name.drop_front(_cummulativeString.size());
-  for (TrieEdge &edge : _children) {
-    StringRef edgeStr = edge._subString;
-    if (partialStr.startswith(edgeStr)) {
-      // Already have matching edge, go down that path.
-      edge._child->addSymbol(entry, allocator, allNodes);
-      return;
-    }
-    // See if string has commmon prefix with existing edge.
-    for (int n=edgeStr.size()-1; n > 0; --n) {
-      if (partialStr.substr(0, n).equals(edgeStr.substr(0, n))) {
-        // Splice in new node:  was A -> C,  now A -> B -> C
-        StringRef bNodeStr = edge._child->_cummulativeString;
-        bNodeStr = bNodeStr.drop_back(edgeStr.size()-n).copy(allocator);
-        TrieNode* bNode = new (allocator) TrieNode(bNodeStr);
-        allNodes.push_back(bNode);
-        TrieNode* cNode = edge._child;
-        StringRef abEdgeStr = edgeStr.substr(0,n).copy(allocator);
-        StringRef bcEdgeStr = edgeStr.substr(n).copy(allocator);
-        DEBUG_WITH_TYPE("trie-builder", llvm::dbgs()
-                        << "splice in TrieNode('" << bNodeStr
-                        << "') between edge '"
-                        << abEdgeStr << "' and edge='"
-                        << bcEdgeStr<< "'\n");
-        TrieEdge& abEdge = edge;
-        abEdge._subString = abEdgeStr;
-        abEdge._child = bNode;
-        TrieEdge *bcEdge = new (allocator) TrieEdge(bcEdgeStr, cNode);
-        bNode->_children.push_back(std::move(*bcEdge));
-        bNode->addSymbol(entry, allocator, allNodes);
-        return;
-      }
-    }
-  }
+void MachOFileLayout::TrieNode::setExport(const Export &entry) {
   if (entry.flags & EXPORT_SYMBOL_FLAGS_REEXPORT) {
     assert(entry.otherOffset != 0);
   }
   if (entry.flags & EXPORT_SYMBOL_FLAGS_STUB_AND_RESOLVER) {
     assert(entry.otherOffset != 0);
   }
-  // No commonality with any existing child, make a new edge.
-  TrieNode* newNode = new (allocator) TrieNode(entry.name.copy(allocator));
-  TrieEdge *newEdge = new (allocator) TrieEdge(partialStr, newNode);
-  _children.push_back(std::move(*newEdge));
-  DEBUG_WITH_TYPE("trie-builder", llvm::dbgs()
-                   << "new TrieNode('" << entry.name << "') with edge '"
-                   << partialStr << "' from node='"
-                   << _cummulativeString << "'\n");
-  newNode->_address = entry.offset;
-  newNode->_flags = entry.flags | entry.kind;
-  newNode->_other = entry.otherOffset;
+  _address = entry.offset;
+  _flags = entry.flags | entry.kind;
+  _other = entry.otherOffset;
   if ((entry.flags & EXPORT_SYMBOL_FLAGS_REEXPORT) && !entry.otherName.empty())
-    newNode->_importedName = entry.otherName.copy(allocator);
-  newNode->_hasExportInfo = true;
-  allNodes.push_back(newNode);
+    _importedName = entry.otherName;
+  _hasExportInfo = true;
 }
 
 bool MachOFileLayout::TrieNode::updateOffset(uint32_t& offset) {
@@ -1226,16 +1331,58 @@ void MachOFileLayout::buildExportTrie() {
   if (_file.exportInfo.empty())
     return;
 
-  // For all temporary strings and objects used building trie.
-  BumpPtrAllocator allocator;
-
-  // Build trie of all exported symbols.
-  TrieNode* rootNode = new (allocator) TrieNode(StringRef());
-  std::vector<TrieNode*> allNodes;
-  allNodes.reserve(_file.exportInfo.size()*2);
-  allNodes.push_back(rootNode);
-  for (const Export& entry : _file.exportInfo) {
-    rootNode->addSymbol(entry, allocator, allNodes);
+  // Insert the names one by one, in the order of the export list. This
+  // fixes the layout of the trie: the edges of a node are in the order they
+  // were added, and the nodes are written in the order they were created.
+  // Each name creates at most two nodes, so the vector never reallocates.
+  std::vector<TrieNode> allNodes;
+  allNodes.reserve(_file.exportInfo.size() * 2 + 1);
+  allNodes.emplace_back(0);
+  for (const Export &entry : _file.exportInfo) {
+    StringRef name = entry.name;
+    TrieNode *node = &allNodes.front();
+    for (;;) {
+      StringRef partialStr = name.drop_front(node->_depth);
+      TrieNode *next = nullptr;
+      for (TrieEdge &edge : node->_children) {
+        StringRef edgeStr = edge._subString;
+        if (partialStr.startswith(edgeStr)) {
+          // Already have matching edge, go down that path.
+          next = edge._child;
+          break;
+        }
+        size_t n = 0;
+        size_t maxCommon = std::min(partialStr.size(), edgeStr.size());
+        while (n < maxCommon && partialStr[n] == edgeStr[n])
+          ++n;
+        if (n == 0)
+          continue;
+        // Splice in new node:  was A -> C,  now A -> B -> C
+        DEBUG_WITH_TYPE("trie-builder", llvm::dbgs()
+                        << "splice in TrieNode('"
+                        << name.substr(0, node->_depth + n)
+                        << "') between edge '" << edgeStr.substr(0, n)
+                        << "' and edge='" << edgeStr.substr(n) << "'\n");
+        allNodes.emplace_back(node->_depth + n);
+        next = &allNodes.back();
+        next->_children.push_back(TrieEdge(edgeStr.substr(n), edge._child));
+        edge._subString = edgeStr.substr(0, n);
+        edge._child = next;
+        break;
+      }
+      if (!next)
+        break;
+      node = next;
+    }
+    // No commonality with any existing child, make a new edge.
+    DEBUG_WITH_TYPE("trie-builder", llvm::dbgs()
+                    << "new TrieNode('" << name << "') with edge '"
+                    << name.substr(node->_depth) << "' from node='"
+                    << name.substr(0, node->_depth) << "'\n");
+    allNodes.emplace_back(name.size());
+    TrieNode *leaf = &allNodes.back();
+    leaf->setExport(entry);
+    node->_children.push_back(TrieEdge(name.substr(node->_depth), leaf));
   }
 
   // Assign each node in the vector an offset in the trie stream, iterating
@@ -1244,15 +1391,15 @@ void MachOFileLayout::buildExportTrie() {
   do {
     uint32_t offset = 0;
     more = false;
-    for (TrieNode* node : allNodes) {
-      if (node->updateOffset(offset))
+    for (TrieNode &node : allNodes) {
+      if (node.updateOffset(offset))
         more = true;
     }
   } while (more);
 
   // Serialize trie to ByteBuffer.
-  for (TrieNode* node : allNodes) {
-    node->appendToByteBuffer(_exportTrie);
+  for (TrieNode &node : allNodes) {
+    node.appendToByteBuffer(_exportTrie);
   }
   _exportTrie.align(_is64 ? 8 : 4);
 }
@@ -1264,27 +1411,120 @@ void MachOFileLayout::computeSymbolTableSizes() {
   _symbolTableSize = nlistSize * (_file.localSymbols.size()
                                 + _file.globalSymbols.size()
                                 + _file.undefinedSymbols.size());
-  _symbolStringPoolSize = 0;
-  for (const Symbol &sym : _file.localSymbols) {
-    _symbolStringPoolSize += (sym.name.size()+1);
-  }
-  for (const Symbol &sym : _file.globalSymbols) {
-    _symbolStringPoolSize += (sym.name.size()+1);
-  }
-  for (const Symbol &sym : _file.undefinedSymbols) {
-    _symbolStringPoolSize += (sym.name.size()+1);
-  }
   _symbolTableLocalsStartIndex = 0;
   _symbolTableGlobalsStartIndex = _file.localSymbols.size();
   _symbolTableUndefinesStartIndex = _symbolTableGlobalsStartIndex
                                     + _file.globalSymbols.size();
 
+  // Assign each symbol name its offset in the string pool.
+  std::vector<StringRef> names;
+  names.reserve(_file.localSymbols.size() + _file.globalSymbols.size()
+                                          + _file.undefinedSymbols.size());
+  for (const Symbol &sym : _file.localSymbols)
+    names.push_back(sym.name);
+  for (const Symbol &sym : _file.globalSymbols)
+    names.push_back(sym.name);
+  for (const Symbol &sym : _file.undefinedSymbols)
+    names.push_back(sym.name);
+  if (_file.mergeSymbolStrings)
+    _symbolStringPoolSize = layoutMergedSymbolStrings(names);
+  else
+    _symbolStringPoolSize = layoutSymbolStrings(names);
+
   _indirectSymbolTableCount = 0;
   for (const Section &sect : _file.sections) {
     _indirectSymbolTableCount += sect.indirectSymbols.size();
   }
 }
 
+/// Lays out the names one after the other in symbol table order, and returns
+/// the size of the pool. The offsets are a prefix sum of the name sizes,
+/// computed a block of names at a time: the block sizes are summed in
+/// parallel, scanned, and then the offsets within each block are filled in
+/// in parallel.
+uint32_t MachOFileLayout::layoutSymbolStrings(ArrayRef<StringRef> names) {
+  const size_t blockSize = 4096;
+  size_t numBlocks = (names.size() + blockSize - 1) / blockSize;
+  auto forEachBlock = [&](std::function<void (size_t, size_t, size_t)> f) {
+    TaskGroup tg;
+    for (size_t b = 0; b + 1 < numBlocks; ++b)
+      tg.spawn([=, &f] { f(b, b * blockSize, (b + 1) * blockSize); });
+    if (numBlocks)
+      f(numBlocks - 1, (numBlocks - 1) * blockSize, names.size());
+    tg.sync();
+  };
+
+  // Offset zero is the empty string that means no name.
+  std::vector<uint32_t> blockOffsets(numBlocks + 1, 0);
+  blockOffsets[0] = 1;
+  forEachBlock([&](size_t b, size_t begin, size_t end) {
+    uint32_t size = 0;
+    for (size_t i = begin; i != end; ++i)
+      size += names[i].size() + 1;
+    blockOffsets[b + 1] = size;
+  });
+  std::partial_sum(blockOffsets.begin(), blockOffsets.end(),
+                   blockOffsets.begin());
+
+  _symbolStringOffsets.resize(names.size());
+  _symbolStrings.resize(names.size());
+  forEachBlock([&](size_t b, size_t begin, size_t end) {
+    uint32_t offset = blockOffsets[b];
+    for (size_t i = begin; i != end; ++i) {
+      _symbolStringOffsets[i] = offset;
+      _symbolStrings[i] = PoolString(names[i], offset);
+      offset += names[i].size() + 1;
+    }
+  });
+  return blockOffsets[numBlocks];
+}
+
+// Compares the bytes of two strings from the end. A string that is a suffix
+// of the other orders after it.
+static bool reverseGreater(StringRef a, StringRef b) {
+  size_t n = std::min(a.size(), b.size());
+  for (size_t i = 1; i <= n; ++i) {
+    uint8_t ca = a[a.size() - i];
+    uint8_t cb = b[b.size() - i];
+    if (ca != cb)
+      return ca > cb;
+  }
+  return a.size() > b.size();
+}
+
+/// Like layoutSymbolStrings, but stores each distinct name once, and points
+/// names that are a suffix of another name into that name. Sorting the names
+/// from their last byte puts every name right after the names it is a suffix
+/// of, so one pass over the sorted names finds all the shared strings.
+uint32_t MachOFileLayout::layoutMergedSymbolStrings(ArrayRef<StringRef> names) {
+  std::vector<uint32_t> order(names.size());
+  for (uint32_t i = 0, e = names.size(); i != e; ++i)
+    order[i] = i;
+  parallel_sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) {
+    if (reverseGreater(names[a], names[b]))
+      return true;
+    if (reverseGreater(names[b], names[a]))
+      return false;
+    return a < b;
+  });
+
+  _symbolStringOffsets.resize(names.size());
+  _symbolStrings.clear();
+  uint32_t size = 1;
+  for (uint32_t i : order) {
+    StringRef name = names[i];
+    if (!_symbolStrings.empty() && _symbolStrings.back().first.endswith(name)) {
+      const PoolString &str = _symbolStrings.back();
+      _symbolStringOffsets[i] = str.second + str.first.size() - name.size();
+      continue;
+    }
+    _symbolStrings.push_back(PoolString(name, size));
+    _symbolStringOffsets[i] = size;
+    size += name.size() + 1;
+  }
+  return size;
+}
+
 void MachOFileLayout::computeDataInCodeSize() {
   _dataInCodeSize = _file.dataInCode.size() * sizeof(data_in_code_entry);
 }
@@ -25,6 +25,7 @@
 #include "MachONormalizedFileBinaryUtils.h"
 #include "lld/Core/Error.h"
 #include "lld/Core/LLVM.h"
+#include "lld/Core/Parallel.h"
 #include "llvm/ADT/StringRef.h"
 #include "llvm/ADT/StringSwitch.h"
 #include "llvm/Support/Casting.h"
@@ -33,6 +34,7 @@
 #include "llvm/Support/Format.h"
 #include "llvm/Support/MachO.h"
 #include <map>
+#include <memory>
 #include <system_error>
 
 using llvm::StringRef;
@@ -90,6 +92,45 @@ SegmentInfo::SegmentInfo(StringRef n)
  : name(n), address(0), size(0), access(0), normalizedSegmentIndex(0) {
 }
 
+typedef llvm::DenseMap<const Atom*, uint64_t> AtomToAddress;
+typedef llvm::DenseMap<const Atom*, SectionInfo*> AtomToSection;
+
+/// Generates the content of the sections of the output, atom by atom and
+/// with the fixups applied, straight into the output file. It outlives the
+/// Util that creates it, so it keeps its own copy of the atom addresses, of
+/// the addresses of their sections, and of the atoms of each section.
+class ContentGenerator {
+public:
+  ContentGenerator(mach_o::ArchHandler &archHandler, bool relocatable,
+                   uint64_t baseAddress, const AtomToAddress &atomToAddress,
+                   const AtomToSection &atomToSection);
+
+  /// Records the atoms of a section, and returns the index to pass to
+  /// generate() for it.
+  unsigned addSection(const SectionInfo *si);
+
+  /// Spawns into \p tg the tasks that write the content of a section to
+  /// \p sectionContent.
+  void generate(unsigned index, uint8_t *sectionContent, TaskGroup &tg);
+
+private:
+  void generateAtoms(ArrayRef<AtomInfo> atoms, uint8_t *sectionContent) const;
+
+  // A task ends after this much content or this many atoms, whichever comes
+  // first.
+  static const uint64_t maxTaskBytes = 64 * 1024;
+  static const size_t maxTaskAtoms = 1024;
+
+  mach_o::ArchHandler                &_archHandler;
+  bool                                _relocatable;
+  uint64_t                            _baseAddress;
+  // Only read once the content is generated, so tasks share them unlocked.
+  AtomToAddress                       _atomToAddress;
+  AtomToAddress                       _atomToSectionAddress;
+  std::vector<std::vector<AtomInfo>>  _sectionAtoms;
+  // The index of the first atom of each task, per section.
+  std::vector<std::vector<size_t>>    _sectionTasks;
+};
 
 class Util {
 public:
@@ -113,11 +154,10 @@ public:
   void      buildDataInCodeArray(const lld::File &, NormalizedFile &file);
   void      addDependentDylibs(const lld::File &, NormalizedFile &file);
   void      copyEntryPointAddress(NormalizedFile &file);
-  void      copySectionContent(NormalizedFile &file);
+  void      addSectionContentWriters(NormalizedFile &file);
 
 private:
   typedef std::map<DefinedAtom::ContentType, SectionInfo*> TypeToSection;
-  typedef llvm::DenseMap<const Atom*, uint64_t> AtomToAddress;
 
   struct DylibInfo { int ordinal; bool hasWeak; bool hasNonWeak; };
   typedef llvm::StringMap<DylibInfo> DylibPathToInfo;
@@ -129,7 +169,6 @@ private:
   SegmentInfo *segmentForName(StringRef segName);
   void         layoutSectionsInSegment(SegmentInfo *seg, uint64_t &addr);
   void         layoutSectionsInTextSegment(size_t, SegmentInfo *, uint64_t &);
-  void         copySectionContent(SectionInfo *si, ContentBytes &content);
   uint16_t     descBits(const DefinedAtom* atom);
   int          dylibOrdinal(const SharedLibraryAtom *sa);
   void         segIndexForSection(const SectionInfo *sect,
@@ -145,7 +184,8 @@ private:
   typedef llvm::DenseMap<const Atom*, uint32_t> AtomToIndex;
   struct AtomAndIndex { const Atom *atom; uint32_t index; SymbolScope scope; };
   struct AtomSorter {
-    bool operator()(const AtomAndIndex &left, const AtomAndIndex &right);
+    bool operator()(const AtomAndIndex &left,
+                    const AtomAndIndex &right) const;
   };
   struct SegmentSorter {
     bool operator()(const SegmentInfo *left, const SegmentInfo *right);
@@ -164,6 +204,7 @@ private:
   TypeToSection                 _sectionMap;
   std::vector<SectionInfo*>     _customSections;
   AtomToAddress                 _atomToAddress;
+  AtomToSection                 _atomToSection;
   DylibPathToInfo               _dylibInfo;
   const DefinedAtom            *_entryAtom;
   AtomToIndex                   _atomToSymbolIndex;
@@ -338,6 +379,7 @@ void Util::appendAtom(SectionInfo *sect, const DefinedAtom *atom) {
   // Assign atom to this section with this offset.
   AtomInfo ai = {atom, offset};
   sect->atomsAndOffsets.push_back(ai);
+  _atomToSection[atom] = sect;
   // Update section size to include this atom.
   sect->size = offset + atom->size();
 }
@@ -562,9 +604,49 @@ void Util::appendSection(SectionInfo *si, NormalizedFile &file) {
   si->normalizedSectionIndex = file.sections.size()-1;
 }
 
-void Util::copySectionContent(NormalizedFile &file) {
-  const bool r = (_ctx.outputMachOType() == llvm::MachO::MH_OBJECT);
+ContentGenerator::ContentGenerator(mach_o::ArchHandler &archHandler,
+                                   bool relocatable, uint64_t baseAddress,
+                                   const AtomToAddress &atomToAddress,
+                                   const AtomToSection &atomToSection)
+    : _archHandler(archHandler), _relocatable(relocatable),
+      _baseAddress(baseAddress), _atomToAddress(atomToAddress) {
+  _atomToSectionAddress.reserve(atomToSection.size());
+  for (const auto &entry : atomToSection)
+    _atomToSectionAddress[entry.first] = entry.second->address;
+}
+
+unsigned ContentGenerator::addSection(const SectionInfo *si) {
+  _sectionAtoms.push_back(si->atomsAndOffsets);
+  // Cut the atoms into tasks by the amount of content rather than by count,
+  // so that sections of a few large functions are spread over threads too.
+  std::vector<size_t> tasks;
+  uint64_t bytes = 0;
+  for (size_t i = 0, e = si->atomsAndOffsets.size(); i != e; ++i) {
+    if (tasks.empty() || bytes >= maxTaskBytes ||
+        i - tasks.back() == maxTaskAtoms) {
+      tasks.push_back(i);
+      bytes = 0;
+    }
+    bytes += si->atomsAndOffsets[i].atom->size();
+  }
+  _sectionTasks.push_back(std::move(tasks));
+  return _sectionAtoms.size() - 1;
+}
 
+void ContentGenerator::generate(unsigned index, uint8_t *sectionContent,
+                                TaskGroup &tg) {
+  // Atoms do not overlap, so their content can be generated in parallel.
+  ArrayRef<AtomInfo> atoms = _sectionAtoms[index];
+  const std::vector<size_t> &tasks = _sectionTasks[index];
+  for (size_t i = 0, e = tasks.size(); i != e; ++i) {
+    size_t end = (i + 1 == e) ? atoms.size() : tasks[i + 1];
+    ArrayRef<AtomInfo> slice = atoms.slice(tasks[i], end - tasks[i]);
+    tg.spawn([=] { generateAtoms(slice, sectionContent); });
+  }
+}
+
+void ContentGenerator::generateAtoms(ArrayRef<AtomInfo> atoms,
+                                     uint8_t *sectionContent) const {
   // Utility function for ArchHandler to find address of atom in output file.
   auto addrForAtom = [&] (const Atom &atom) -> uint64_t {
     auto pos = _atomToAddress.find(&atom);
@@ -573,30 +655,37 @@ void Util::copySectionContent(NormalizedFile &file) {
   };
 
   auto sectionAddrForAtom = [&] (const Atom &atom) -> uint64_t {
-    for (const SectionInfo *sectInfo : _sectionInfos)
-      for (const AtomInfo &atomInfo : sectInfo->atomsAndOffsets)
-        if (atomInfo.atom == &atom)
-          return sectInfo->address;
-    llvm_unreachable("atom not assigned to section");
+    auto pos = _atomToSectionAddress.find(&atom);
+    if (pos == _atomToSectionAddress.end())
+      llvm_unreachable("atom not assigned to section");
+    return pos->second;
   };
 
+  for (const AtomInfo &ai : atoms) {
+    uint8_t *atomContent = &sectionContent[ai.offsetInSection];
+    _archHandler.generateAtomContent(*ai.atom, _relocatable, addrForAtom,
+                                     sectionAddrForAtom, _baseAddress,
+                                     atomContent);
+  }
+}
+
+void Util::addSectionContentWriters(NormalizedFile &file) {
+  const bool r = (_ctx.outputMachOType() == llvm::MachO::MH_OBJECT);
+  auto generator = std::make_shared<ContentGenerator>(
+      _archHandler, r, _ctx.baseAddress(), _atomToAddress, _atomToSection);
+
   for (SectionInfo *si : _sectionInfos) {
     Section *normSect = &file.sections[si->normalizedSectionIndex];
-    if (si->type == llvm::MachO::S_ZEROFILL) {
-      const uint8_t *empty = nullptr;
-      normSect->content = llvm::makeArrayRef(empty, si->size);
+    // Only the size of the content is known until the writer generates it.
+    const uint8_t *empty = nullptr;
+    normSect->content = llvm::makeArrayRef(empty, si->size);
+    if (si->type == llvm::MachO::S_ZEROFILL)
       continue;
-    }
-    // Copy content from atoms to content buffer for section.
-    uint8_t *sectionContent = file.ownedAllocations.Allocate<uint8_t>(si->size);
-    normSect->content = llvm::makeArrayRef(sectionContent, si->size);
-    for (AtomInfo &ai : si->atomsAndOffsets) {
-      uint8_t *atomContent = reinterpret_cast<uint8_t*>
-                                          (&sectionContent[ai.offsetInSection]);
-      _archHandler.generateAtomContent(*ai.atom, r, addrForAtom,
-                                       sectionAddrForAtom, _ctx.baseAddress(),
-                                       atomContent);
-    }
+    unsigned index = generator->addSection(si);
+    normSect->contentWriter = [generator, index](uint8_t *buffer,
+                                                 TaskGroup &tg) {
+      generator->generate(index, buffer, tg);
+    };
   }
 }
 
@@ -708,7 +797,7 @@ uint16_t Util::descBits(const DefinedAtom* atom) {
 
 
 bool Util::AtomSorter::operator()(const AtomAndIndex &left,
-                                  const AtomAndIndex &right) {
+                                  const AtomAndIndex &right) const {
   return (left.atom->name().compare(right.atom->name()) < 0);
 }
 
@@ -766,66 +855,77 @@ std::error_code Util::addSymbols(const lld::File &atomFile,
   bool rMode = (_ctx.outputMachOType() == llvm::MachO::MH_OBJECT);
   // Mach-O symbol table has three regions: locals, globals, undefs.
 
+  // Find the region of every named atom in parallel.
+  std::vector<AtomAndIndex> atoms;
+  for (SectionInfo *sect : _sectionInfos) {
+    for (const AtomInfo &info : sect->atomsAndOffsets) {
+      AtomAndIndex ai = { info.atom, sect->finalSectionIndex, 0 };
+      atoms.push_back(ai);
+    }
+  }
+  std::vector<uint8_t> inGlobals(atoms.size(), false);
+  std::vector<std::error_code> errors(atoms.size());
+  parallel_for(size_t(0), atoms.size(), [&](size_t i) {
+    const DefinedAtom *atom = static_cast<const DefinedAtom*>(atoms[i].atom);
+    if (atom->name().empty())
+      return;
+    bool inGlobalsRegion = false;
+    errors[i] = getSymbolTableRegion(atom, inGlobalsRegion, atoms[i].scope);
+    inGlobals[i] = inGlobalsRegion;
+  });
+
   // Add all local (non-global) symbols in address order
+  std::vector<const DefinedAtom *> localAtoms;
   std::vector<AtomAndIndex> globals;
   globals.reserve(512);
-  for (SectionInfo *sect : _sectionInfos) {
-    for (const AtomInfo &info : sect->atomsAndOffsets) {
-      const DefinedAtom *atom = info.atom;
-      if (!atom->name().empty()) {
-        SymbolScope symbolScope;
-        bool inGlobalsRegion;
-        if (auto ec = getSymbolTableRegion(atom, inGlobalsRegion, symbolScope)){
-          return ec;
-        }
-        if (inGlobalsRegion) {
-          AtomAndIndex ai = { atom, sect->finalSectionIndex, symbolScope };
-          globals.push_back(ai);
-        } else {
-          Symbol sym;
-          sym.name  = atom->name();
-          sym.type  = N_SECT;
-          sym.scope = symbolScope;
-          sym.sect  = sect->finalSectionIndex;
-          sym.desc  = descBits(atom);
-          sym.value = _atomToAddress[atom];
-          _atomToSymbolIndex[atom] = file.localSymbols.size();
-          file.localSymbols.push_back(sym);
-        }
-      } else if (rMode && _archHandler.needsLocalSymbolInRelocatableFile(atom)){
-        // Create 'Lxxx' labels for anonymous atoms if archHandler says so.
-        static unsigned tempNum = 1;
-        char tmpName[16];
-        sprintf(tmpName, "L%04u", tempNum++);
-        StringRef tempRef(tmpName);
-        Symbol sym;
-        sym.name  = tempRef.copy(file.ownedAllocations);
-        sym.type  = N_SECT;
-        sym.scope = 0;
-        sym.sect  = sect->finalSectionIndex;
-        sym.desc  = 0;
-        sym.value = _atomToAddress[atom];
-        _atomToSymbolIndex[atom] = file.localSymbols.size();
-        file.localSymbols.push_back(sym);
+  for (size_t i = 0, e = atoms.size(); i != e; ++i) {
+    if (errors[i])
+      return errors[i];
+    const DefinedAtom *atom = static_cast<const DefinedAtom*>(atoms[i].atom);
+    Symbol sym;
+    if (!atom->name().empty()) {
+      if (inGlobals[i]) {
+        globals.push_back(atoms[i]);
+        continue;
       }
+      sym.name  = atom->name();
+      sym.scope = atoms[i].scope;
+    } else if (rMode && _archHandler.needsLocalSymbolInRelocatableFile(atom)){
+      // Create 'Lxxx' labels for anonymous atoms if archHandler says so.
+      static unsigned tempNum = 1;
+      char tmpName[16];
+      sprintf(tmpName, "L%04u", tempNum++);
+      StringRef tempRef(tmpName);
+      sym.name  = tempRef.copy(file.ownedAllocations);
+      sym.scope = 0;
+    } else {
+      continue;
     }
+    sym.type  = N_SECT;
+    sym.sect  = atoms[i].index;
+    localAtoms.push_back(atom);
+    file.localSymbols.push_back(sym);
   }
+  parallel_for(size_t(0), localAtoms.size(), [&](size_t i) {
+    const DefinedAtom *atom = localAtoms[i];
+    Symbol &sym = file.localSymbols[i];
+    sym.desc  = atom->name().empty() ? 0 : descBits(atom);
+    sym.value = _atomToAddress.lookup(atom);
+  });
 
   // Sort global symbol alphabetically, then add to symbol table.
-  std::sort(globals.begin(), globals.end(), AtomSorter());
-  const uint32_t globalStartIndex = file.localSymbols.size();
-  for (AtomAndIndex &ai : globals) {
-    Symbol sym;
+  parallel_sort(globals.begin(), globals.end(), AtomSorter());
+  file.globalSymbols.resize(globals.size());
+  parallel_for(size_t(0), globals.size(), [&](size_t i) {
+    const AtomAndIndex &ai = globals[i];
+    Symbol &sym = file.globalSymbols[i];
     sym.name  = ai.atom->name();
     sym.type  = N_SECT;
     sym.scope = ai.scope;
     sym.sect  = ai.index;
     sym.desc  = descBits(static_cast<const DefinedAtom*>(ai.atom));
-    sym.value = _atomToAddress[ai.atom];
-    _atomToSymbolIndex[ai.atom] = globalStartIndex + file.globalSymbols.size();
-    file.globalSymbols.push_back(sym);
-  }
-
+    sym.value = _atomToAddress.lookup(ai.atom);
+  });
 
   // Sort undefined symbol alphabetically, then add to symbol table.
   std::vector<AtomAndIndex> undefs;
@@ -838,10 +938,11 @@ std::error_code Util::addSymbols(const lld::File &atomFile,
     AtomAndIndex ai = { atom, 0, N_EXT };
     undefs.push_back(ai);
   }
-  std::sort(undefs.begin(), undefs.end(), AtomSorter());
-  const uint32_t start = file.globalSymbols.size() + file.localSymbols.size();
-  for (AtomAndIndex &ai : undefs) {
-    Symbol sym;
+  parallel_sort(undefs.begin(), undefs.end(), AtomSorter());
+  file.undefinedSymbols.resize(undefs.size());
+  parallel_for(size_t(0), undefs.size(), [&](size_t i) {
+    const AtomAndIndex &ai = undefs[i];
+    Symbol &sym = file.undefinedSymbols[i];
     uint16_t desc = 0;
     if (!rMode) {
       uint8_t ordinal = dylibOrdinal(dyn_cast<SharedLibraryAtom>(ai.atom));
@@ -853,9 +954,17 @@ std::error_code Util::addSymbols(const lld::File &atomFile,
     sym.sect  = 0;
     sym.desc  = desc;
     sym.value = 0;
-    _atomToSymbolIndex[ai.atom] = file.undefinedSymbols.size() + start;
-    file.undefinedSymbols.push_back(sym);
-  }
+  });
+
+  // Record the symbol table index of each atom.
+  const uint32_t globalStartIndex = file.localSymbols.size();
+  const uint32_t start = file.globalSymbols.size() + file.localSymbols.size();
+  for (uint32_t i = 0, e = localAtoms.size(); i != e; ++i)
+    _atomToSymbolIndex[localAtoms[i]] = i;
+  for (uint32_t i = 0, e = globals.size(); i != e; ++i)
+    _atomToSymbolIndex[globals[i].atom] = globalStartIndex + i;
+  for (uint32_t i = 0, e = undefs.size(); i != e; ++i)
+    _atomToSymbolIndex[undefs[i].atom] = start + i;
 
   return std::error_code();
 }
@@ -971,7 +1080,7 @@ void Util::addDependentDylibs(const lld::File &atomFile,NormalizedFile &nFile) {
 
 
 int Util::dylibOrdinal(const SharedLibraryAtom *sa) {
-  return _dylibInfo[sa->loadName()].ordinal;
+  return _dylibInfo.lookup(sa->loadName()).ordinal;
 }
 
 void Util::segIndexForSection(const SectionInfo *sect, uint8_t &segmentIndex,
@@ -1203,13 +1312,14 @@ normalizedFromAtoms(const lld::File &atomFile,
   normFile.compatVersion = context.compatibilityVersion();
   normFile.pageSize = context.pageSize();
   normFile.rpaths = context.rpaths();
+  normFile.mergeSymbolStrings = context.mergeSymbolStrings();
   util.addDependentDylibs(atomFile, normFile);
   util.copySegmentInfo(normFile);
   util.copySectionInfo(normFile);
   util.assignAddressesToSections(normFile);
   util.buildAtomToAddressMap();
   util.updateSectionInfo(normFile);
-  util.copySectionContent(normFile);
+  util.addSectionContentWriters(normFile);
   if (auto ec = util.addSymbols(atomFile, normFile)) {
     return ec;
   }
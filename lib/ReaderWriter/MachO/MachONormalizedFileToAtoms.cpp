@@ -574,10 +574,18 @@ std::error_code convertRelocs(const Section &section,
   };
 
   const bool isBig = MachOLinkingContext::isBigEndian(normalizedFile.arch);
-  // Use old-school iterator so that paired relocations can be grouped.
-  for (auto it=section.relocations.begin(), e=section.relocations.end();
-                                                                it != e; ++it) {
-    const Relocation &reloc = *it;
+  // Relocations left packed in the mapped file are decoded one at a time.
+  const bool packed = !section.packedRelocations.empty();
+  const size_t numRelocs = packed ? section.packedRelocations.size()
+                                  : section.relocations.size();
+  auto relocAt = [&] (size_t index) -> Relocation {
+    if (packed)
+      return unpackRelocation(section.packedRelocations[index], isBig);
+    return section.relocations[index];
+  };
+  // Use an index so that paired relocations can be grouped.
+  for (size_t i = 0; i != numRelocs; ++i) {
+    const Relocation reloc = relocAt(i);
     // Find atom this relocation is in.
     if (reloc.offset > section.content.size())
       return make_dynamic_error_code(Twine("r_address (") + Twine(reloc.offset)
@@ -595,10 +603,14 @@ std::error_code convertRelocs(const Section &section,
     Reference::KindValue kind;
     std::error_code relocErr;
     if (handler.isPairedReloc(reloc)) {
-     // Handle paired relocations together.
+      // Handle paired relocations together.
+      if (i + 1 == numRelocs)
+        return make_dynamic_error_code(
+            Twine("missing second relocation of pair in section ") +
+            section.segmentName + "/" + section.sectionName);
       relocErr = handler.getPairReferenceInfo(
-          reloc, *++it, inAtom, offsetInAtom, fixupAddress, isBig, scatterable,
-          atomByAddr, atomBySymbol, &kind, &target, &addend);
+          reloc, relocAt(++i), inAtom, offsetInAtom, fixupAddress, isBig,
+          scatterable, atomByAddr, atomBySymbol, &kind, &target, &addend);
     }
     else {
       // Use ArchHandler to convert relocation record into information
@@ -16,11 +16,13 @@
 namespace lld {
 namespace mach_o {
 
+void addCallGraphOrderPass(PassManager &pm, MachOLinkingContext &ctx);
 void addLayoutPass(PassManager &pm, const MachOLinkingContext &ctx);
 void addStubsPass(PassManager &pm, const MachOLinkingContext &ctx);
 void addGOTPass(PassManager &pm, const MachOLinkingContext &ctx);
 void addCompactUnwindPass(PassManager &pm, const MachOLinkingContext &ctx);
 void addShimPass(PassManager &pm, const MachOLinkingContext &ctx);
+void addBranchIslandPass(PassManager &pm, const MachOLinkingContext &ctx);
 
 } // namespace mach_o
 } // namespace lld
@@ -30,9 +30,13 @@
 #define LLD_READER_WRITER_PE_COFF_ORDER_PASS_H
 
 #include "Atoms.h"
+#include "lld/Core/AtomOrder.h"
+#include "lld/Core/LinkingContext.h"
 #include "lld/Core/Parallel.h"
 #include "lld/Core/Pass.h"
+#include "llvm/ADT/DenseMap.h"
 #include <algorithm>
+#include <limits>
 
 namespace lld {
 namespace pecoff {
@@ -53,12 +57,59 @@ static bool compare(const DefinedAtom *lhs, const DefinedAtom *rhs) {
   return DefinedAtom::compareByPosition(lhs, rhs);
 }
 
+/// Returns true if the two atoms are merged into the same section in the
+/// order given by compare().
+static bool inSameGroup(const DefinedAtom *lhs, const DefinedAtom *rhs) {
+  bool lhsCustom = (lhs->sectionChoice() == DefinedAtom::sectionCustomRequired);
+  bool rhsCustom = (rhs->sectionChoice() == DefinedAtom::sectionCustomRequired);
+  if (lhsCustom != rhsCustom)
+    return false;
+  return !lhsCustom || lhs->customSectionName() == rhs->customSectionName();
+}
+
 class OrderPass : public lld::Pass {
 public:
+  explicit OrderPass(const LinkingContext &ctx) : _ctx(ctx) {}
+
   void perform(std::unique_ptr<SimpleFile> &file) override {
     SimpleFile::DefinedAtomRange defined = file->definedAtoms();
     parallel_sort(defined.begin(), defined.end(), compare);
+    if (!_ctx.callGraphProfile().empty())
+      applyCallGraphProfile(defined);
   }
+
+private:
+  /// Moves the functions of the call graph profile to the front of their
+  /// section, in the order computed by the profile. "$" suffixes define the
+  /// layout within a section, so atoms never move across section names.
+  void applyCallGraphProfile(SimpleFile::DefinedAtomRange defined) {
+    std::vector<const DefinedAtom *> atoms(defined.begin(), defined.end());
+    llvm::DenseMap<const DefinedAtom *, unsigned> rank;
+    unsigned next = 0;
+    for (const DefinedAtom *atom : _ctx.callGraphProfile().sortAtoms(atoms))
+      rank[atom] = next++;
+
+    const unsigned unordered = std::numeric_limits<unsigned>::max();
+    std::vector<unsigned> priority(atoms.size(), unordered);
+    for (size_t i = 0, e = atoms.size(); i != e; ++i) {
+      auto it = rank.find(atoms[i]);
+      if (it != rank.end())
+        priority[i] = it->second;
+    }
+
+    llvm::MutableArrayRef<const DefinedAtom *> all(atoms);
+    for (size_t begin = 0, e = atoms.size(); begin != e;) {
+      size_t end = begin + 1;
+      while (end != e && inSameGroup(atoms[begin], atoms[end]))
+        ++end;
+      orderLayoutChains(all.slice(begin, end - begin),
+                        makeArrayRef(priority).slice(begin, end - begin));
+      begin = end;
+    }
+    std::copy(atoms.begin(), atoms.end(), defined.begin());
+  }
+
+  const LinkingContext &_ctx;
 };
 
 } // namespace pecoff
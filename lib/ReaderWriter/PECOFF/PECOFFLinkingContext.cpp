@@ -342,7 +342,7 @@ void PECOFFLinkingContext::addPasses(PassManager &pm) {
   pm.add(llvm::make_unique<pecoff::PDBPass>(*this));
   pm.add(llvm::make_unique<pecoff::EdataPass>(*this));
   pm.add(llvm::make_unique<pecoff::IdataPass>(*this));
-  pm.add(llvm::make_unique<pecoff::OrderPass>());
+  pm.add(llvm::make_unique<pecoff::OrderPass>(*this));
   pm.add(llvm::make_unique<pecoff::LoadConfigPass>(*this));
   pm.add(llvm::make_unique<pecoff::InferSubsystemPass>(*this));
 }
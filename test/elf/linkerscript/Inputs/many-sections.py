@@ -0,0 +1,23 @@
+# Writes an x86-64 assembly file with the given number of input sections,
+# cycling through code, read-only data and writable data. Each section
+# defines one global symbol named after it: f<N>, r<N> or d<N>. Code
+# sections are 16-byte aligned so that their addresses are easy to predict.
+import sys
+
+count = int(sys.argv[1])
+for i in range(count):
+    kind = i % 3
+    if kind == 0:
+        print('.section .text.f%d,"ax",@progbits' % i)
+        print('.p2align 4')
+        print('.globl f%d' % i)
+        print('f%d: ret' % i)
+    elif kind == 1:
+        print('.section .rodata.r%d,"a",@progbits' % i)
+        print('.globl r%d' % i)
+        print('r%d: .byte %d' % (i, i % 256))
+    else:
+        print('.section .data.d%d,"aw",@progbits' % i)
+        print('.p2align 3')
+        print('.globl d%d' % i)
+        print('d%d: .quad %d' % (i, i))
@@ -0,0 +1,2 @@
+_a _b 100
+_c _d 50
@@ -0,0 +1,23 @@
+# Damages every entry in a -dylib_cache_path directory, to test that links
+# fall back to parsing the dylibs, or edits them to test that links read them.
+# Usage: damage-dylib-cache.py <dir> <how> where <how> is "truncate" to drop
+# the last byte of each entry, "magic" to overwrite its first byte, or
+# "rename <old> <new>" to replace the string <old> by <new>, which must have
+# the same length.
+import os
+import sys
+
+cache, how = sys.argv[1], sys.argv[2]
+for name in os.listdir(cache):
+    path = os.path.join(cache, name)
+    with open(path, 'r+b') as f:
+        if how == 'truncate':
+            f.truncate(os.path.getsize(path) - 1)
+        elif how == 'rename':
+            old, new = sys.argv[3].encode(), sys.argv[4].encode()
+            assert len(old) == len(new)
+            data = f.read()
+            f.seek(0)
+            f.write(data.replace(old, new))
+        else:
+            f.write(b'X')
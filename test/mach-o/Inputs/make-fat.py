@@ -0,0 +1,28 @@
+# Writes a fat file made of the thin mach-o files given, as lipo -create
+# does.  Usage: make-fat.py <output> <input>...
+import struct
+import sys
+
+FAT_MAGIC = 0xcafebabe
+PAGE_ALIGN = 12
+PAGE_SIZE = 1 << PAGE_ALIGN
+
+slices = []
+for path in sys.argv[2:]:
+    with open(path, 'rb') as f:
+        data = f.read()
+    cputype, cpusubtype = struct.unpack('<II', data[4:12])
+    slices.append((cputype, cpusubtype, data))
+
+header = struct.pack('>II', FAT_MAGIC, len(slices))
+body = b''
+offset = PAGE_SIZE
+for cputype, cpusubtype, data in slices:
+    header += struct.pack('>IIIII', cputype, cpusubtype, offset, len(data),
+                          PAGE_ALIGN)
+    padded = data + b'\0' * (-len(data) % PAGE_SIZE)
+    body += padded
+    offset += len(padded)
+
+with open(sys.argv[1], 'wb') as f:
+    f.write(header + b'\0' * (PAGE_SIZE - len(header)) + body)
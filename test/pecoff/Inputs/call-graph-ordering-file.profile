@@ -0,0 +1,2 @@
+_main _b1 100
+_b1 _a2 50
@@ -14,17 +14,76 @@
 
 #include "lld/ReaderWriter/LinkerScript.h"
 
+#include "llvm/Support/Format.h"
 #include "llvm/Support/PrettyStackTrace.h"
 #include "llvm/Support/Signals.h"
+#include <chrono>
 
 using namespace llvm;
 using namespace lld;
 using namespace script;
 
+/// Lexes and parses the script repeatedly and prints the throughput of each
+/// phase in MB/s. Small scripts are repeated until \p totalSize bytes have
+/// been processed.
+static int benchmark(std::unique_ptr<MemoryBuffer> mb, size_t totalSize) {
+  typedef std::chrono::steady_clock Clock;
+  StringRef input = mb->getBuffer();
+  StringRef name = mb->getBufferIdentifier();
+  size_t iterations =
+      std::max<size_t>(1, totalSize / std::max<size_t>(1, input.size()));
+  double megabytes = double(input.size()) * iterations / (1 << 20);
+
+  size_t numTokens = 0;
+  Clock::time_point start = Clock::now();
+  for (size_t i = 0; i != iterations; ++i) {
+    Lexer l(MemoryBuffer::getMemBuffer(input, name, false));
+    Token tok;
+    do {
+      l.lex(tok);
+      ++numTokens;
+    } while (tok._kind != Token::eof && tok._kind != Token::unknown);
+  }
+  std::chrono::duration<double> lexTime = Clock::now() - start;
+
+  start = Clock::now();
+  for (size_t i = 0; i != iterations; ++i) {
+    Parser p(MemoryBuffer::getMemBuffer(input, name, false));
+    if (p.parse())
+      return 1;
+  }
+  std::chrono::duration<double> parseTime = Clock::now() - start;
+
+  llvm::outs() << "input: " << input.size() << " bytes, "
+               << numTokens / iterations << " tokens, " << iterations
+               << " iterations\n";
+  llvm::outs() << "lex: "
+               << format("%.2f", megabytes / lexTime.count()) << " MB/s\n";
+  llvm::outs() << "parse: "
+               << format("%.2f", megabytes / parseTime.count()) << " MB/s\n";
+  return 0;
+}
+
 int main(int argc, const char **argv) {
   llvm::sys::PrintStackTraceOnErrorSignal();
   llvm::PrettyStackTraceProgram X(argc, argv);
 
+  // linker-script-test -benchmark <script> [<total bytes>]
+  if ((argc == 3 || argc == 4) && StringRef(argv[1]) == "-benchmark") {
+    size_t totalSize = 16 << 20;
+    if (argc == 4 && StringRef(argv[3]).getAsInteger(10, totalSize)) {
+      llvm::errs() << "invalid benchmark size: " << argv[3] << "\n";
+      return 1;
+    }
+    ErrorOr<std::unique_ptr<MemoryBuffer>> mb =
+        MemoryBuffer::getFileOrSTDIN(argv[2]);
+    if (std::error_code ec = mb.getError()) {
+      llvm::errs() << ec.message() << "\n";
+      return 1;
+    }
+    return benchmark(std::move(mb.get()), totalSize);
+  }
+
   {
     ErrorOr<std::unique_ptr<MemoryBuffer>> mb =
         MemoryBuffer::getFileOrSTDIN(argv[1]);
@@ -16,6 +16,7 @@
 #include "lld/Core/Parallel.h"
 #include <array>
 #include <random>
+#include <vector>
 
 uint32_t array[1024 * 1024];
 
@@ -29,3 +30,11 @@ TEST(Parallel, sort) {
   lld::parallel_sort(std::begin(array), std::end(array));
   ASSERT_TRUE(std::is_sorted(std::begin(array), std::end(array)));
 }
+
+TEST(Parallel, parallel_for) {
+  // Use an uneven size so that the last partial task is exercised.
+  std::vector<uint32_t> v(10 * 1024 + 3);
+  lld::parallel_for(0, v.size(), [&](size_t i) { v[i] = i * 2; });
+  for (size_t i = 0, e = v.size(); i != e; ++i)
+    ASSERT_EQ(i * 2, v[i]);
+}
@@ -199,6 +199,24 @@ TEST_F(GnuLdParserTest, AsNeeded) {
   EXPECT_FALSE(cast<FileNode>(nodes[3].get())->asNeeded());
 }
 
+// -z pack-relative-relocs
+
+TEST_F(GnuLdParserTest, PackRelativeRelocsDefault) {
+  EXPECT_TRUE(parse("ld", "a.o", nullptr));
+  EXPECT_FALSE(_ctx->packRelativeRelocs());
+}
+
+TEST_F(GnuLdParserTest, PackRelativeRelocs) {
+  EXPECT_TRUE(parse("ld", "a.o", "-z", "pack-relative-relocs", nullptr));
+  EXPECT_TRUE(_ctx->packRelativeRelocs());
+}
+
+TEST_F(GnuLdParserTest, NoPackRelativeRelocs) {
+  EXPECT_TRUE(parse("ld", "a.o", "-z", "pack-relative-relocs", "-z",
+                    "nopack-relative-relocs", nullptr));
+  EXPECT_FALSE(_ctx->packRelativeRelocs());
+}
+
 // Linker script
 
 TEST_F(LinkerScriptTest, Input) {
@@ -282,3 +300,61 @@ TEST_F(LinkerScriptTest, ExprEval) {
   EXPECT_EQ(0, sa2->symbol().compare(StringRef(".")));
 }
 
+TEST_F(LinkerScriptTest, SemaEvalExpr) {
+  parse("SECTIONS { b = a * 2; a = 0x10 + 4; . = b;\n"
+        "c = . + (a > 4 ? 1 : b); d = undefined + 1; }");
+  script::Sema &sema = _ctx->linkerScriptSema();
+  sema.perform();
+
+  auto *secs = dyn_cast<const script::Sections>(
+      *sema.getLinkerScripts()[0]->get()->_commands.begin());
+  ASSERT_TRUE(secs != nullptr);
+  std::vector<const script::SymbolAssignment *> assgns;
+  for (const script::Command *c : *secs)
+    assgns.push_back(cast<script::SymbolAssignment>(c));
+  ASSERT_EQ((size_t)5, assgns.size());
+
+  // "a" and "b" do not depend on the location counter, so they are known
+  // before any expression is evaluated, despite the forward reference.
+  EXPECT_EQ((uint64_t)0x28, sema.getLinkerScriptExprValue("b"));
+  EXPECT_EQ((uint64_t)0x14, sema.getLinkerScriptExprValue("a"));
+
+  uint64_t curPos = 0x1000;
+  for (int i = 0; i < 4; ++i)
+    EXPECT_FALSE(sema.evalExpr(assgns[i], curPos));
+  EXPECT_EQ((uint64_t)0x28, curPos);
+  EXPECT_EQ((uint64_t)0x29, sema.getLinkerScriptExprValue("c"));
+  EXPECT_EQ(std::error_code(LinkerScriptReaderError::unknown_symbol_in_expr),
+            sema.evalExpr(assgns[4], curPos));
+}
+
+
+TEST(WildcardPatternTest, Match) {
+  EXPECT_TRUE(script::WildcardPattern(".text").match(".text"));
+  EXPECT_FALSE(script::WildcardPattern(".text").match(".text.foo"));
+  EXPECT_TRUE(script::WildcardPattern(".text.*").match(".text.foo"));
+  EXPECT_FALSE(script::WildcardPattern(".text.*").match(".text."));
+  EXPECT_TRUE(script::WildcardPattern("*").match("crt1.o"));
+  EXPECT_FALSE(script::WildcardPattern("*").match(""));
+  EXPECT_TRUE(script::WildcardPattern("*foo*bar*").match("xfooybarz"));
+  EXPECT_FALSE(script::WildcardPattern("*foo*bar*").match("xfoobar"));
+  EXPECT_TRUE(script::WildcardPattern(".data.[a-c]?").match(".data.b1"));
+  EXPECT_FALSE(script::WildcardPattern(".data.[a-c]?").match(".data.d1"));
+  EXPECT_TRUE(script::WildcardPattern("a\\*b").match("a*b"));
+  EXPECT_FALSE(script::WildcardPattern("a\\*b").match("axb"));
+}
+
+// "[...]" follows fnmatch: "a-z" is a range, and a '-' at either end of the
+// set is an ordinary character. A '[' without a closing ']' is literal.
+TEST(WildcardPatternTest, CharSet) {
+  EXPECT_TRUE(script::WildcardPattern("[a-z]x").match("mx"));
+  EXPECT_FALSE(script::WildcardPattern("[a-z]x").match("-x"));
+  EXPECT_FALSE(script::WildcardPattern("[a-z]x").match("Mx"));
+  EXPECT_TRUE(script::WildcardPattern("[-a]x").match("-x"));
+  EXPECT_TRUE(script::WildcardPattern("[a-]x").match("-x"));
+  EXPECT_FALSE(script::WildcardPattern("[a-]x").match("bx"));
+  EXPECT_TRUE(script::WildcardPattern("[0-9_]x").match("_x"));
+  EXPECT_FALSE(script::WildcardPattern("[ab]x").match("abx"));
+  EXPECT_TRUE(script::WildcardPattern(".text.[ab*").match(".text.[ab*"));
+  EXPECT_FALSE(script::WildcardPattern(".text.[ab*").match(".text.a"));
+}
@@ -0,0 +1,77 @@
+//===- lld/unittest/ELFTests/CompressionTest.cpp --------------------------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+///
+/// \file
+/// \brief Tests for the parallel zlib compressor of --compress-debug-sections.
+///
+//===----------------------------------------------------------------------===//
+
+#include "gtest/gtest.h"
+#include "../../lib/ReaderWriter/ELF/Compression.h"
+#include "llvm/ADT/SmallString.h"
+#include "llvm/ADT/StringRef.h"
+#include "llvm/Config/config.h"
+#include "llvm/Support/Compression.h"
+#include <cstring>
+#include <random>
+#include <vector>
+
+#if LLVM_ENABLE_ZLIB == 1 && HAVE_LIBZ
+#include <zlib.h>
+
+using lld::elf::zlibCompress;
+
+static uint32_t readBig32(const uint8_t *p) {
+  return (uint32_t(p[0]) << 24) | (uint32_t(p[1]) << 16) |
+         (uint32_t(p[2]) << 8) | p[3];
+}
+
+/// Checks that \p stream, which starts at \p out[offset], is a zlib stream of
+/// \p in with a correct Adler-32 trailer, and that zlib inflates it to \p in.
+static void checkStream(const std::vector<uint8_t> &in,
+                        const std::vector<uint8_t> &out, size_t offset) {
+  ASSERT_GT(out.size(), offset + 6);
+  EXPECT_EQ(0x78, out[offset]);
+  EXPECT_EQ(0x9c, out[offset + 1]);
+  uLong checksum = adler32(adler32(0, Z_NULL, 0), in.data(), in.size());
+  EXPECT_EQ(checksum, readBig32(&out[out.size() - 4]));
+
+  llvm::StringRef stream(reinterpret_cast<const char *>(&out[offset]),
+                         out.size() - offset);
+  llvm::SmallString<0> uncompressed;
+  ASSERT_EQ(llvm::zlib::StatusOK,
+            llvm::zlib::uncompress(stream, uncompressed, in.size()));
+  ASSERT_EQ(in.size(), uncompressed.size());
+  EXPECT_EQ(0, std::memcmp(in.data(), uncompressed.data(), in.size()));
+}
+
+TEST(Compression, zlibManyBlocks) {
+  // Two and a half 1MiB blocks, so that there are two sync-flushed blocks
+  // and a partial last one.
+  std::vector<uint8_t> in((5 << 19) + 123);
+  std::mt19937 randEngine;
+  for (uint8_t &c : in)
+    c = "abcdefgh"[randEngine() % 8];
+  std::vector<uint8_t> out;
+  ASSERT_TRUE(zlibCompress(in, out));
+  EXPECT_LT(out.size(), in.size());
+  checkStream(in, out, 0);
+}
+
+TEST(Compression, zlibEmpty) {
+  std::vector<uint8_t> in;
+  // The output is appended to what is already there, e.g. a section header.
+  std::vector<uint8_t> out = { 1, 2, 3 };
+  ASSERT_TRUE(zlibCompress(in, out));
+  EXPECT_EQ(1, out[0]);
+  EXPECT_EQ(2, out[1]);
+  EXPECT_EQ(3, out[2]);
+  checkStream(in, out, 3);
+}
+#endif
@@ -0,0 +1,411 @@
+//===- lld/unittest/MachOTests/DylibExportCacheTests.cpp ------------------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#include "gtest/gtest.h"
+#include "../../lib/ReaderWriter/MachO/DylibExportCache.h"
+#include "../../lib/ReaderWriter/MachO/File.h"
+#include "../../lib/ReaderWriter/MachO/MachONormalizedFile.h"
+#include "llvm/ADT/SmallString.h"
+#include "llvm/ADT/Twine.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/MachO.h"
+#include "llvm/Support/MathExtras.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/Path.h"
+#include "llvm/Support/Process.h"
+#include "llvm/Support/raw_ostream.h"
+#include <memory>
+#include <string>
+#include <system_error>
+#include <vector>
+
+using llvm::ErrorOr;
+using llvm::MemoryBuffer;
+using llvm::SmallString;
+using llvm::StringRef;
+using llvm::Twine;
+using lld::MachOLinkingContext;
+using lld::SharedLibraryAtom;
+using lld::mach_o::DylibExportCache;
+using lld::mach_o::MachODylibFile;
+using namespace llvm::MachO;
+using namespace lld::mach_o::normalized;
+
+static const char *const reExportPath = "/usr/lib/libbar.dylib";
+
+// Writes a dylib for arch that exports _foo and the weak definition weakName,
+// and re-exports libbar.
+static void writeDylib(StringRef path, MachOLinkingContext::Arch arch,
+                       StringRef installName, StringRef weakName = "_weak") {
+  NormalizedFile f;
+  f.arch = arch;
+  f.fileType = MH_DYLIB;
+  f.os = MachOLinkingContext::OS::macOSX;
+  f.installName = installName;
+  f.currentVersion = 0x10203;
+  f.compatVersion = 0x10000;
+  f.pageSize = 0x1000;
+  f.segments.resize(1);
+  f.segments[0].name = "__TEXT";
+  f.segments[0].address = 0;
+  f.segments[0].size = 0x2000;
+  f.segments[0].access = VMProtect(VM_PROT_READ | VM_PROT_EXECUTE);
+  const std::pair<StringRef, ExportFlags> exports[] = {
+    { "_foo", ExportFlags(0) },
+    { weakName, ExportFlags(EXPORT_SYMBOL_FLAGS_WEAK_DEFINITION) }
+  };
+  uint64_t offset = 0x1000;
+  for (const std::pair<StringRef, ExportFlags> &exp : exports) {
+    Export entry;
+    entry.name = exp.first;
+    entry.offset = offset;
+    entry.kind = EXPORT_SYMBOL_FLAGS_KIND_REGULAR;
+    entry.flags = exp.second;
+    entry.otherOffset = 0;
+    f.exportInfo.push_back(entry);
+    offset += 0x10;
+  }
+  DependentDylib bar;
+  bar.path = reExportPath;
+  bar.kind = LC_REEXPORT_DYLIB;
+  bar.compatVersion = 0x10000;
+  bar.currentVersion = 0x10000;
+  f.dependentDylibs.push_back(bar);
+
+  std::error_code ec = writeBinary(f, path);
+  ASSERT_FALSE(ec);
+}
+
+static void appendBE32(std::string &out, uint32_t value) {
+  for (int shift = 24; shift >= 0; shift -= 8)
+    out.push_back(char(value >> shift));
+}
+
+static uint32_t readLE32(const char *p) {
+  const uint8_t *b = reinterpret_cast<const uint8_t *>(p);
+  return b[0] | (b[1] << 8) | (b[2] << 16) | (uint32_t(b[3]) << 24);
+}
+
+// Writes a fat file holding the thin Mach-O files slicePaths, each slice
+// aligned to a page.
+static void writeFatFile(StringRef path,
+                         const std::vector<std::string> &slicePaths) {
+  std::string header;
+  std::string contents;
+  appendBE32(header, FAT_MAGIC);
+  appendBE32(header, slicePaths.size());
+  for (const std::string &slicePath : slicePaths) {
+    ErrorOr<std::unique_ptr<MemoryBuffer>> mb =
+        MemoryBuffer::getFile(slicePath);
+    ASSERT_FALSE(mb.getError());
+    StringRef slice = (*mb)->getBuffer();
+    contents.resize(llvm::RoundUpToAlignment(contents.size(), 0x1000));
+    appendBE32(header, readLE32(slice.data() + 4));
+    appendBE32(header, readLE32(slice.data() + 8));
+    appendBE32(header, 0x1000 + contents.size());
+    appendBE32(header, slice.size());
+    appendBE32(header, 12);
+    contents.append(slice.begin(), slice.end());
+  }
+  header.resize(0x1000);
+
+  std::error_code ec;
+  llvm::raw_fd_ostream out(path, ec, llvm::sys::fs::F_None);
+  ASSERT_FALSE(ec);
+  out << header << contents;
+}
+
+static std::error_code getDylibKey(StringRef path,
+                                   MachOLinkingContext::Arch arch,
+                                   DylibExportCache::Key &key) {
+  ErrorOr<std::unique_ptr<MemoryBuffer>> mb = MemoryBuffer::getFile(path);
+  if (std::error_code ec = mb.getError())
+    return ec;
+  return DylibExportCache::getKey(path, (*mb)->getBuffer(), arch, key);
+}
+
+static std::unique_ptr<MachODylibFile>
+parseDylib(MachOLinkingContext &ctx, StringRef path, std::error_code &ec) {
+  ErrorOr<std::unique_ptr<MemoryBuffer>> mb = ctx.getMemoryBuffer(path);
+  ec = mb.getError();
+  if (ec)
+    return nullptr;
+  std::unique_ptr<MachODylibFile> file(
+      new MachODylibFile(std::move(*mb), &ctx));
+  ec = file->parse();
+  return file;
+}
+
+static void configure(MachOLinkingContext &ctx, MachOLinkingContext::Arch arch,
+                      StringRef cacheDir) {
+  ctx.configure(MH_EXECUTE, arch, MachOLinkingContext::OS::macOSX, 0x000A0800);
+  ctx.setDylibCachePath(cacheDir);
+}
+
+static unsigned countEntries(StringRef cacheDir) {
+  unsigned count = 0;
+  std::error_code ec;
+  for (llvm::sys::fs::directory_iterator it(cacheDir, ec), end;
+       !ec && it != end; it.increment(ec))
+    ++count;
+  return count;
+}
+
+static std::string readFile(StringRef path) {
+  ErrorOr<std::unique_ptr<MemoryBuffer>> mb = MemoryBuffer::getFile(path);
+  if (mb.getError())
+    return std::string();
+  return (*mb)->getBuffer().str();
+}
+
+static void writeFile(StringRef path, StringRef contents) {
+  std::error_code ec;
+  llvm::raw_fd_ostream out(path, ec, llvm::sys::fs::F_None);
+  ASSERT_FALSE(ec);
+  out << contents;
+}
+
+// The first parse writes the entry and the second is served from it. Both
+// must see the re-exported dylib, and the entry must keep the weak flag.
+TEST(DylibExportCacheTest, reexport_and_weak_def) {
+  SmallString<128> dir;
+  ASSERT_FALSE(llvm::sys::fs::createUniqueDirectory("dylib-cache", dir));
+  SmallString<128> dylibPath(dir);
+  llvm::sys::path::append(dylibPath, "libfoo.dylib");
+  SmallString<128> cacheDir(dir);
+  llvm::sys::path::append(cacheDir, "cache");
+  writeDylib(dylibPath, MachOLinkingContext::arch_x86_64,
+             "/usr/lib/libfoo.dylib");
+
+  MachODylibFile bar(reExportPath);
+  bar.setInstallName(reExportPath);
+  bar.addExportedSymbol("_bar", false, false);
+
+  for (int round = 0; round < 2; ++round) {
+    MachOLinkingContext ctx;
+    configure(ctx, MachOLinkingContext::arch_x86_64, cacheDir);
+    std::error_code ec;
+    std::unique_ptr<MachODylibFile> file = parseDylib(ctx, dylibPath, ec);
+    ASSERT_FALSE(ec);
+    EXPECT_EQ(1U, countEntries(cacheDir));
+    EXPECT_TRUE(file->installName().equals("/usr/lib/libfoo.dylib"));
+    EXPECT_EQ(0x10203U, file->currentVersion());
+    EXPECT_EQ(0x10000U, file->compatVersion());
+
+    std::vector<std::string> requested;
+    file->loadReExportedDylibs([&](StringRef path) -> MachODylibFile * {
+      requested.push_back(path.str());
+      return path.equals(reExportPath) ? &bar : nullptr;
+    });
+    ASSERT_EQ(1U, requested.size());
+    EXPECT_EQ(reExportPath, requested[0]);
+
+    EXPECT_TRUE(file->exports("_foo", false) != nullptr);
+    EXPECT_TRUE(file->exports("_weak", false) != nullptr);
+    EXPECT_TRUE(file->exports("_none", false) == nullptr);
+    const SharedLibraryAtom *atom = file->exports("_bar", false);
+    ASSERT_TRUE(atom != nullptr);
+    EXPECT_TRUE(atom->loadName().equals("/usr/lib/libfoo.dylib"));
+  }
+
+  DylibExportCache::Key key;
+  ASSERT_FALSE(
+      getDylibKey(dylibPath, MachOLinkingContext::arch_x86_64, key));
+  std::unique_ptr<DylibExportCache> cache = DylibExportCache::load(
+      DylibExportCache::entryPath(cacheDir, dylibPath, key), key);
+  ASSERT_TRUE(cache != nullptr);
+  EXPECT_TRUE(cache->installName().equals("/usr/lib/libfoo.dylib"));
+  ASSERT_EQ(1U, cache->numReExportedDylibs());
+  EXPECT_TRUE(cache->reExportedDylib(0).equals(reExportPath));
+  EXPECT_TRUE(cache->find("_foo").name.equals("_foo"));
+  EXPECT_FALSE(cache->find("_foo").weakDef);
+  EXPECT_TRUE(cache->find("_weak").name.equals("_weak"));
+  EXPECT_TRUE(cache->find("_weak").weakDef);
+  EXPECT_TRUE(cache->find("_none").name.empty());
+
+  llvm::sys::fs::remove_directories(dir);
+}
+
+// A truncated or corrupt entry, or one made for another file or arch, is
+// never used, and the dylib is parsed again instead.
+TEST(DylibExportCacheTest, damaged_entries) {
+  SmallString<128> dir;
+  ASSERT_FALSE(llvm::sys::fs::createUniqueDirectory("dylib-cache", dir));
+  SmallString<128> entry(dir);
+  llvm::sys::path::append(entry, "entry");
+
+  DylibExportCache::Key key = { 0x1234, 1000000001ULL, CPU_TYPE_X86_64,
+                                CPU_SUBTYPE_X86_64_ALL };
+  DylibExportCache::Contents contents;
+  contents.installName = "/usr/lib/libfoo.dylib";
+  contents.currentVersion = 0x10203;
+  contents.compatVersion = 0x10000;
+  contents.exports.push_back(std::make_pair(StringRef("_foo"), false));
+  contents.exports.push_back(std::make_pair(StringRef("_weak"), true));
+  contents.reExportedDylibs.push_back(reExportPath);
+  ASSERT_FALSE(DylibExportCache::write(entry, key, contents));
+  std::string good = readFile(entry);
+  ASSERT_FALSE(good.empty());
+  EXPECT_TRUE(DylibExportCache::load(entry, key) != nullptr);
+
+  for (size_t size = 0; size < good.size(); ++size) {
+    writeFile(entry, StringRef(good).substr(0, size));
+    EXPECT_TRUE(DylibExportCache::load(entry, key) == nullptr) << size;
+  }
+
+  std::string badMagic = good;
+  badMagic[0] ^= 0xff;
+  writeFile(entry, badMagic);
+  EXPECT_TRUE(DylibExportCache::load(entry, key) == nullptr);
+
+  writeFile(entry, good);
+  DylibExportCache::Key otherKey = key;
+  otherKey.modTime += 1;
+  EXPECT_TRUE(DylibExportCache::load(entry, otherKey) == nullptr);
+  otherKey = key;
+  otherKey.fileSize += 1;
+  EXPECT_TRUE(DylibExportCache::load(entry, otherKey) == nullptr);
+  otherKey = key;
+  otherKey.cpuType = CPU_TYPE_I386;
+  otherKey.cpuSubtype = CPU_SUBTYPE_X86_ALL;
+  EXPECT_TRUE(DylibExportCache::load(entry, otherKey) == nullptr);
+  otherKey = key;
+  otherKey.digest[15] ^= 1;
+  EXPECT_TRUE(DylibExportCache::load(entry, otherKey) == nullptr);
+
+  // A dylib whose entry was truncated is parsed, and the entry rewritten.
+  SmallString<128> dylibPath(dir);
+  llvm::sys::path::append(dylibPath, "libfoo.dylib");
+  SmallString<128> cacheDir(dir);
+  llvm::sys::path::append(cacheDir, "cache");
+  writeDylib(dylibPath, MachOLinkingContext::arch_x86_64,
+             "/usr/lib/libfoo.dylib");
+  DylibExportCache::Key dylibKey;
+  ASSERT_FALSE(
+      getDylibKey(dylibPath, MachOLinkingContext::arch_x86_64, dylibKey));
+  std::string dylibEntry =
+      DylibExportCache::entryPath(cacheDir, dylibPath, dylibKey);
+  for (int round = 0; round < 2; ++round) {
+    MachOLinkingContext ctx;
+    configure(ctx, MachOLinkingContext::arch_x86_64, cacheDir);
+    std::error_code ec;
+    std::unique_ptr<MachODylibFile> file = parseDylib(ctx, dylibPath, ec);
+    ASSERT_FALSE(ec);
+    EXPECT_TRUE(file->installName().equals("/usr/lib/libfoo.dylib"));
+    EXPECT_TRUE(file->exports("_foo", false) != nullptr);
+    std::string written = readFile(dylibEntry);
+    ASSERT_FALSE(written.empty());
+    EXPECT_TRUE(DylibExportCache::load(dylibEntry, dylibKey) != nullptr);
+    writeFile(dylibEntry, StringRef(written).drop_back());
+  }
+
+  llvm::sys::fs::remove_directories(dir);
+}
+
+// Build tools that fix timestamps can rebuild a dylib with the same size and
+// modification time. The digest of its contents must keep the old entry from
+// being used for it.
+TEST(DylibExportCacheTest, rebuilt_with_same_size_and_time) {
+  SmallString<128> dir;
+  ASSERT_FALSE(llvm::sys::fs::createUniqueDirectory("dylib-cache", dir));
+  SmallString<128> dylibPath(dir);
+  llvm::sys::path::append(dylibPath, "libfoo.dylib");
+  SmallString<128> cacheDir(dir);
+  llvm::sys::path::append(cacheDir, "cache");
+
+  writeDylib(dylibPath, MachOLinkingContext::arch_x86_64,
+             "/usr/lib/libfoo.dylib", "_weak");
+  llvm::sys::fs::file_status before;
+  ASSERT_FALSE(llvm::sys::fs::status(dylibPath, before));
+  {
+    MachOLinkingContext ctx;
+    configure(ctx, MachOLinkingContext::arch_x86_64, cacheDir);
+    std::error_code ec;
+    std::unique_ptr<MachODylibFile> file = parseDylib(ctx, dylibPath, ec);
+    ASSERT_FALSE(ec);
+    EXPECT_TRUE(file->exports("_weak", false) != nullptr);
+  }
+
+  writeDylib(dylibPath, MachOLinkingContext::arch_x86_64,
+             "/usr/lib/libfoo.dylib", "_wean");
+  int fd;
+  ASSERT_FALSE(llvm::sys::fs::openFileForWrite(dylibPath, fd,
+                                               llvm::sys::fs::F_Append));
+  std::error_code ec = llvm::sys::fs::setLastModificationAndAccessTime(
+      fd, before.getLastModificationTime());
+  llvm::sys::Process::SafelyCloseFileDescriptor(fd);
+  ASSERT_FALSE(ec);
+  llvm::sys::fs::file_status after;
+  ASSERT_FALSE(llvm::sys::fs::status(dylibPath, after));
+  ASSERT_EQ(before.getSize(), after.getSize());
+  ASSERT_TRUE(before.getLastModificationTime() ==
+              after.getLastModificationTime());
+
+  MachOLinkingContext ctx;
+  configure(ctx, MachOLinkingContext::arch_x86_64, cacheDir);
+  std::unique_ptr<MachODylibFile> file = parseDylib(ctx, dylibPath, ec);
+  ASSERT_FALSE(ec);
+  EXPECT_TRUE(file->exports("_wean", false) != nullptr);
+  EXPECT_TRUE(file->exports("_weak", false) == nullptr);
+  EXPECT_EQ(2U, countEntries(cacheDir));
+
+  llvm::sys::fs::remove_directories(dir);
+}
+
+// Each slice of a fat dylib gets its own entry, and a dylib without a slice
+// for the arch linked is rejected even after another arch cached it.
+TEST(DylibExportCacheTest, fat_dylib_slices) {
+  SmallString<128> dir;
+  ASSERT_FALSE(llvm::sys::fs::createUniqueDirectory("dylib-cache", dir));
+  SmallString<128> x86_64Path(dir);
+  llvm::sys::path::append(x86_64Path, "libfat_x86_64.dylib");
+  SmallString<128> i386Path(dir);
+  llvm::sys::path::append(i386Path, "libfat_i386.dylib");
+  SmallString<128> fatPath(dir);
+  llvm::sys::path::append(fatPath, "libfat.dylib");
+  SmallString<128> cacheDir(dir);
+  llvm::sys::path::append(cacheDir, "cache");
+  writeDylib(x86_64Path, MachOLinkingContext::arch_x86_64,
+             "/usr/lib/libfat_x86_64.dylib");
+  writeDylib(i386Path, MachOLinkingContext::arch_x86,
+             "/usr/lib/libfat_i386.dylib");
+  writeFatFile(fatPath, { x86_64Path.str().str(), i386Path.str().str() });
+
+  static const std::pair<MachOLinkingContext::Arch, const char *> slices[] = {
+    { MachOLinkingContext::arch_x86_64, "/usr/lib/libfat_x86_64.dylib" },
+    { MachOLinkingContext::arch_x86, "/usr/lib/libfat_i386.dylib" }
+  };
+  for (int round = 0; round < 2; ++round) {
+    for (const std::pair<MachOLinkingContext::Arch, const char *> &slice :
+         slices) {
+      MachOLinkingContext ctx;
+      configure(ctx, slice.first, cacheDir);
+      std::error_code ec;
+      std::unique_ptr<MachODylibFile> file = parseDylib(ctx, fatPath, ec);
+      ASSERT_FALSE(ec);
+      EXPECT_TRUE(file->installName().equals(slice.second));
+      EXPECT_TRUE(file->exports("_foo", false) != nullptr);
+    }
+  }
+  EXPECT_EQ(2U, countEntries(cacheDir));
+
+  // The thin x86_64 dylib is cached for x86_64 and must still be rejected
+  // by an i386 link.
+  for (MachOLinkingContext::Arch arch :
+       { MachOLinkingContext::arch_x86_64, MachOLinkingContext::arch_x86 }) {
+    MachOLinkingContext ctx;
+    configure(ctx, arch, cacheDir);
+    std::error_code ec;
+    parseDylib(ctx, x86_64Path, ec);
+    EXPECT_EQ(arch != MachOLinkingContext::arch_x86_64, bool(ec));
+  }
+  EXPECT_EQ(3U, countEntries(cacheDir));
+
+  llvm::sys::fs::remove_directories(dir);
+}
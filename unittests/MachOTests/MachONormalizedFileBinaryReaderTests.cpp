@@ -9,6 +9,7 @@
 
 #include "gtest/gtest.h"
 #include "../../lib/ReaderWriter/MachO/MachONormalizedFile.h"
+#include "../../lib/ReaderWriter/MachO/MachONormalizedFileBinaryUtils.h"
 #include "llvm/Support/MachO.h"
 #include <assert.h>
 #include <vector>
@@ -21,12 +22,14 @@ using namespace lld::mach_o::normalized;
 using namespace llvm::MachO;
 
 static std::unique_ptr<NormalizedFile>
-fromBinary(const uint8_t bytes[], unsigned length, StringRef archStr) {
+fromBinary(const uint8_t bytes[], unsigned length, StringRef archStr,
+           bool decodeRelocations = true) {
   StringRef sr((const char*)bytes, length);
   std::unique_ptr<MemoryBuffer> mb(MemoryBuffer::getMemBuffer(sr, "", false));
   ErrorOr<std::unique_ptr<NormalizedFile>> r =
       lld::mach_o::normalized::readBinary(
-          mb, lld::MachOLinkingContext::archFromName(archStr));
+          mb, lld::MachOLinkingContext::archFromName(archStr),
+          decodeRelocations);
   EXPECT_FALSE(!r);
   return std::move(*r);
 }
@@ -324,6 +327,18 @@ TEST(BinaryReaderTest, hello_obj_x86_64) {
   EXPECT_TRUE(printfLabel.name.equals("_printf"));
   EXPECT_EQ(printfLabel.type, N_UNDF);
   EXPECT_EQ(printfLabel.scope, SymbolScope(N_EXT));
+
+  std::unique_ptr<NormalizedFile> packed =
+      fromBinary(fileBytes, sizeof(fileBytes), "x86_64", false);
+  const Section& packedText = packed->sections[0];
+  EXPECT_TRUE(packedText.relocations.empty());
+  EXPECT_EQ(packedText.packedRelocations.size(), 2UL);
+  const Relocation packedCall =
+      unpackRelocation(packedText.packedRelocations[0], false);
+  EXPECT_EQ(packedCall.offset, Hex32(0x19));
+  EXPECT_EQ(packedCall.type, X86_64_RELOC_BRANCH);
+  EXPECT_EQ(packedCall.symbol, 2U);
+  EXPECT_TRUE(packed->sections[1].packedRelocations.empty());
 }
 
 
@@ -11,10 +11,16 @@
 #include "../../lib/ReaderWriter/MachO/MachONormalizedFile.h"
 #include "llvm/ADT/Twine.h"
 #include "llvm/Support/FileSystem.h"
+#include "llvm/Support/LEB128.h"
 #include "llvm/Support/MachO.h"
 #include <cassert>
+#include <cstring>
 #include <memory>
+#include <random>
+#include <set>
+#include <string>
 #include <system_error>
+#include <tuple>
 #include <vector>
 
 using llvm::StringRef;
@@ -690,3 +696,341 @@ TEST(BinaryWriterTest, obj_relocs_ppc) {
   std::error_code ec = llvm::sys::fs::remove(Twine(tmpFl));
   EXPECT_FALSE(ec);
 }
+
+// Segment, offset and type of a rebased pointer.
+typedef std::tuple<unsigned, uint64_t, unsigned> RebaseTuple;
+// Segment, offset, type, ordinal, symbol and addend of a bound pointer.
+typedef std::tuple<unsigned, uint64_t, unsigned, int, std::string, int64_t>
+    BindTuple;
+
+static uint64_t readULEB(const uint8_t *&p) {
+  unsigned n;
+  uint64_t value = llvm::decodeULEB128(p, &n);
+  p += n;
+  return value;
+}
+
+static int64_t readSLEB(const uint8_t *&p) {
+  unsigned n;
+  int64_t value = llvm::decodeSLEB128(p, &n);
+  p += n;
+  return value;
+}
+
+// Runs a rebase opcode stream the way dyld does, and returns the locations
+// it rebases.
+static std::multiset<RebaseTuple> decodeRebaseInfo(const uint8_t *p,
+                                                   uint64_t ptrSize) {
+  std::multiset<RebaseTuple> result;
+  unsigned seg = 0, type = 0;
+  uint64_t addr = 0;
+  for (;;) {
+    uint8_t opcode = *p & REBASE_OPCODE_MASK;
+    uint8_t imm = *p & REBASE_IMMEDIATE_MASK;
+    ++p;
+    switch (opcode) {
+    case REBASE_OPCODE_DONE:
+      return result;
+    case REBASE_OPCODE_SET_TYPE_IMM:
+      type = imm;
+      break;
+    case REBASE_OPCODE_SET_SEGMENT_AND_OFFSET_ULEB:
+      seg = imm;
+      addr = readULEB(p);
+      break;
+    case REBASE_OPCODE_ADD_ADDR_ULEB:
+      addr += readULEB(p);
+      break;
+    case REBASE_OPCODE_ADD_ADDR_IMM_SCALED:
+      addr += imm * ptrSize;
+      break;
+    case REBASE_OPCODE_DO_REBASE_IMM_TIMES:
+      for (unsigned i = 0; i != imm; ++i, addr += ptrSize)
+        result.insert(RebaseTuple(seg, addr, type));
+      break;
+    case REBASE_OPCODE_DO_REBASE_ULEB_TIMES:
+      for (uint64_t i = 0, count = readULEB(p); i != count;
+           ++i, addr += ptrSize)
+        result.insert(RebaseTuple(seg, addr, type));
+      break;
+    case REBASE_OPCODE_DO_REBASE_ADD_ADDR_ULEB:
+      result.insert(RebaseTuple(seg, addr, type));
+      addr += ptrSize + readULEB(p);
+      break;
+    case REBASE_OPCODE_DO_REBASE_ULEB_TIMES_SKIPPING_ULEB: {
+      uint64_t count = readULEB(p);
+      uint64_t skip = readULEB(p);
+      for (uint64_t i = 0; i != count; ++i, addr += ptrSize + skip)
+        result.insert(RebaseTuple(seg, addr, type));
+      break;
+    }
+    default:
+      ADD_FAILURE() << "unknown rebase opcode " << unsigned(opcode);
+      return result;
+    }
+  }
+}
+
+// Runs a bind opcode stream the way dyld does, and returns the locations it
+// binds.
+static std::multiset<BindTuple> decodeBindInfo(const uint8_t *p,
+                                               uint64_t ptrSize) {
+  std::multiset<BindTuple> result;
+  unsigned seg = 0, type = 0;
+  uint64_t addr = 0;
+  int ordinal = 0;
+  std::string symbol;
+  int64_t addend = 0;
+  auto bind = [&]() {
+    result.insert(BindTuple(seg, addr, type, ordinal, symbol, addend));
+  };
+  for (;;) {
+    uint8_t opcode = *p & BIND_OPCODE_MASK;
+    uint8_t imm = *p & BIND_IMMEDIATE_MASK;
+    ++p;
+    switch (opcode) {
+    case BIND_OPCODE_DONE:
+      return result;
+    case BIND_OPCODE_SET_DYLIB_ORDINAL_IMM:
+      ordinal = imm;
+      break;
+    case BIND_OPCODE_SET_DYLIB_ORDINAL_ULEB:
+      ordinal = readULEB(p);
+      break;
+    case BIND_OPCODE_SET_DYLIB_SPECIAL_IMM:
+      ordinal = imm ? int8_t(BIND_OPCODE_MASK | imm) : 0;
+      break;
+    case BIND_OPCODE_SET_SYMBOL_TRAILING_FLAGS_IMM:
+      symbol = reinterpret_cast<const char *>(p);
+      p += symbol.size() + 1;
+      break;
+    case BIND_OPCODE_SET_TYPE_IMM:
+      type = imm;
+      break;
+    case BIND_OPCODE_SET_ADDEND_SLEB:
+      addend = readSLEB(p);
+      break;
+    case BIND_OPCODE_SET_SEGMENT_AND_OFFSET_ULEB:
+      seg = imm;
+      addr = readULEB(p);
+      break;
+    case BIND_OPCODE_ADD_ADDR_ULEB:
+      addr += readULEB(p);
+      break;
+    case BIND_OPCODE_DO_BIND:
+      bind();
+      addr += ptrSize;
+      break;
+    case BIND_OPCODE_DO_BIND_ADD_ADDR_ULEB:
+      bind();
+      addr += ptrSize + readULEB(p);
+      break;
+    case BIND_OPCODE_DO_BIND_ADD_ADDR_IMM_SCALED:
+      bind();
+      addr += ptrSize + imm * ptrSize;
+      break;
+    case BIND_OPCODE_DO_BIND_ULEB_TIMES_SKIPPING_ULEB: {
+      uint64_t count = readULEB(p);
+      uint64_t skip = readULEB(p);
+      for (uint64_t i = 0; i != count; ++i, addr += ptrSize + skip)
+        bind();
+      break;
+    }
+    default:
+      ADD_FAILURE() << "unknown bind opcode " << unsigned(opcode);
+      return result;
+    }
+  }
+}
+
+// Returns the LC_DYLD_INFO_ONLY load command of the image at \p start.
+static const dyld_info_command *findDyldInfo(const uint8_t *start, bool is64) {
+  const mach_header *mh = reinterpret_cast<const mach_header *>(start);
+  const uint8_t *lc =
+      start + (is64 ? sizeof(mach_header_64) : sizeof(mach_header));
+  for (uint32_t i = 0; i != mh->ncmds; ++i) {
+    const load_command *cmd = reinterpret_cast<const load_command *>(lc);
+    if (cmd->cmd == LC_DYLD_INFO_ONLY)
+      return reinterpret_cast<const dyld_info_command *>(lc);
+    lc += cmd->cmdsize;
+  }
+  return nullptr;
+}
+
+// Writes dylibs with random rebase and bind locations, and checks that the
+// opcode streams in them rebase and bind exactly these locations.
+static void checkRebaseBindRoundTrip(lld::MachOLinkingContext::Arch arch,
+                                     std::mt19937 &randEngine) {
+  static const char *const symbols[] = { "_a", "_b", "_c", "_d" };
+  static const int ordinals[] = { 1, 2, 3, 15, 16, 200, 0, -1, -2 };
+  const bool is64 = lld::MachOLinkingContext::is64Bit(arch);
+  const uint64_t ptrSize = is64 ? 8 : 4;
+  const uint64_t segSize = 0x100000;
+
+  NormalizedFile f;
+  f.arch = arch;
+  f.fileType = MH_DYLIB;
+  f.os = lld::MachOLinkingContext::OS::macOSX;
+  f.installName = "/usr/lib/libtest.dylib";
+  f.pageSize = 0x1000;
+  f.segments.resize(3);
+  f.segments[0].name = "__TEXT";
+  f.segments[0].address = 0;
+  f.segments[0].size = 0x1000;
+  f.segments[0].access = VMProtect(VM_PROT_READ | VM_PROT_EXECUTE);
+  f.segments[1].name = "__DATA";
+  f.segments[1].address = 0x1000;
+  f.segments[1].size = segSize;
+  f.segments[1].access = VMProtect(VM_PROT_READ | VM_PROT_WRITE);
+  f.segments[2].name = "__DATA_CONST";
+  f.segments[2].address = 0x1000 + segSize;
+  f.segments[2].size = segSize;
+  f.segments[2].access = VMProtect(VM_PROT_READ | VM_PROT_WRITE);
+
+  // Lay out runs of locations with a random length and stride, so that
+  // every way of moving the address and of repeating a rebase or a bind is
+  // needed.
+  std::set<std::pair<unsigned, uint64_t>> used;
+  std::multiset<RebaseTuple> rebases;
+  std::multiset<BindTuple> binds;
+  unsigned numRuns = randEngine() % 40;
+  for (unsigned run = 0; run != numRuns; ++run) {
+    unsigned seg = 1 + randEngine() % 2;
+    uint64_t offset = (randEngine() % (segSize / ptrSize / 2)) * ptrSize;
+    uint64_t stride = (1 + randEngine() % 4) * ptrSize;
+    if (randEngine() % 4 == 0)
+      stride += ptrSize * (randEngine() % 100);
+    unsigned length = 1 + randEngine() % 40;
+    bool isRebase = randEngine() % 2;
+    RebaseType rebaseType = (randEngine() % 5) ? REBASE_TYPE_POINTER
+                                               : REBASE_TYPE_TEXT_ABSOLUTE32;
+    const char *symbol = symbols[randEngine() % 4];
+    int ordinal = ordinals[randEngine() % 9];
+    int64_t addend = (randEngine() % 3) ? 0 : int64_t(randEngine() % 64) - 32;
+    for (unsigned i = 0; i != length; ++i, offset += stride) {
+      if (offset + ptrSize > segSize || !used.insert({seg, offset}).second)
+        break;
+      if (isRebase) {
+        RebaseLocation loc;
+        loc.segIndex = seg;
+        loc.segOffset = offset;
+        loc.kind = rebaseType;
+        f.rebasingInfo.push_back(loc);
+        rebases.insert(RebaseTuple(seg, offset, rebaseType));
+      } else {
+        BindLocation loc;
+        loc.segIndex = seg;
+        loc.segOffset = offset;
+        loc.kind = BIND_TYPE_POINTER;
+        loc.canBeNull = false;
+        loc.ordinal = ordinal;
+        loc.symbolName = symbol;
+        loc.addend = addend;
+        f.bindingInfo.push_back(loc);
+        binds.insert(BindTuple(seg, offset, BIND_TYPE_POINTER, ordinal, symbol,
+                               addend));
+      }
+    }
+  }
+  // The writer must not depend on the order of the locations.
+  std::shuffle(f.rebasingInfo.begin(), f.rebasingInfo.end(), randEngine);
+  std::shuffle(f.bindingInfo.begin(), f.bindingInfo.end(), randEngine);
+
+  SmallString<128> tmpFl;
+  std::error_code ec =
+      llvm::sys::fs::createTemporaryFile(Twine("xx"), "dylib", tmpFl);
+  EXPECT_FALSE(ec);
+  ec = writeBinary(f, tmpFl);
+  EXPECT_FALSE(ec);
+
+  ErrorOr<std::unique_ptr<MemoryBuffer>> mbOrErr = MemoryBuffer::getFile(tmpFl);
+  ASSERT_FALSE(mbOrErr.getError());
+  const uint8_t *start =
+      reinterpret_cast<const uint8_t *>(mbOrErr.get()->getBufferStart());
+  const dyld_info_command *dyldInfo = findDyldInfo(start, is64);
+  ASSERT_TRUE(dyldInfo != nullptr);
+
+  if (rebases.empty())
+    EXPECT_EQ(0U, dyldInfo->rebase_off);
+  else
+    EXPECT_EQ(rebases, decodeRebaseInfo(start + dyldInfo->rebase_off,
+                                        ptrSize));
+  if (binds.empty())
+    EXPECT_EQ(0U, dyldInfo->bind_off);
+  else
+    EXPECT_EQ(binds, decodeBindInfo(start + dyldInfo->bind_off, ptrSize));
+
+  ec = llvm::sys::fs::remove(Twine(tmpFl));
+  EXPECT_FALSE(ec);
+}
+
+TEST(BinaryWriterTest, rebase_bind_opcodes_random) {
+  std::mt19937 randEngine;
+  for (unsigned i = 0; i != 50; ++i) {
+    checkRebaseBindRoundTrip(lld::MachOLinkingContext::arch_x86_64,
+                             randEngine);
+    checkRebaseBindRoundTrip(lld::MachOLinkingContext::arch_x86, randEngine);
+  }
+}
+
+// The export trie is built by inserting the exported names in the order of
+// the export list, which decides the order of the edges and of the nodes in
+// the output. Check that names out of alphabetical order, and a name that
+// is inserted before its own prefix, still give the same bytes as always.
+TEST(BinaryWriterTest, export_trie_insertion_order) {
+  NormalizedFile f;
+  f.arch = lld::MachOLinkingContext::arch_x86_64;
+  f.fileType = MH_DYLIB;
+  f.os = lld::MachOLinkingContext::OS::macOSX;
+  f.installName = "/usr/lib/libtest.dylib";
+  f.pageSize = 0x1000;
+  f.segments.resize(1);
+  f.segments[0].name = "__TEXT";
+  f.segments[0].address = 0;
+  f.segments[0].size = 0x2000;
+  f.segments[0].access = VMProtect(VM_PROT_READ | VM_PROT_EXECUTE);
+  static const std::pair<const char *, uint64_t> exports[] = {
+    { "_foobar", 0x1010 }, { "_foo", 0x1000 }, { "_main", 0x1f00 },
+    { "_bar", 0x1020 },    { "_fob", 0x1030 }
+  };
+  for (const std::pair<const char *, uint64_t> &exp : exports) {
+    Export entry;
+    entry.name = exp.first;
+    entry.offset = exp.second;
+    entry.kind = EXPORT_SYMBOL_FLAGS_KIND_REGULAR;
+    entry.flags = ExportFlags(0);
+    entry.otherOffset = 0;
+    f.exportInfo.push_back(entry);
+  }
+
+  SmallString<128> tmpFl;
+  std::error_code ec =
+      llvm::sys::fs::createTemporaryFile(Twine("xx"), "dylib", tmpFl);
+  EXPECT_FALSE(ec);
+  ec = writeBinary(f, tmpFl);
+  EXPECT_FALSE(ec);
+
+  ErrorOr<std::unique_ptr<MemoryBuffer>> mbOrErr = MemoryBuffer::getFile(tmpFl);
+  ASSERT_FALSE(mbOrErr.getError());
+  const uint8_t *start =
+      reinterpret_cast<const uint8_t *>(mbOrErr.get()->getBufferStart());
+  const dyld_info_command *dyldInfo = findDyldInfo(start, true);
+  ASSERT_TRUE(dyldInfo != nullptr);
+
+  static const uint8_t expected[] = {
+    0x00, 0x01, 0x5F, 0x00, 0x18, 0x03, 0x00, 0x90,
+    0x20, 0x00, 0x00, 0x02, 0x62, 0x61, 0x72, 0x00,
+    0x05, 0x00, 0x13, 0x03, 0x00, 0x80, 0x20, 0x00,
+    0x00, 0x03, 0x66, 0x6F, 0x00, 0x33, 0x6D, 0x61,
+    0x69, 0x6E, 0x00, 0x29, 0x62, 0x61, 0x72, 0x00,
+    0x2E, 0x03, 0x00, 0x80, 0x3E, 0x00, 0x03, 0x00,
+    0xA0, 0x20, 0x00, 0x00, 0x02, 0x6F, 0x00, 0x0A,
+    0x62, 0x00, 0x3B, 0x03, 0x00, 0xB0, 0x20, 0x00
+  };
+  ASSERT_EQ(sizeof(expected), dyldInfo->export_size);
+  EXPECT_EQ(0, memcmp(expected, start + dyldInfo->export_off,
+                      sizeof(expected)));
+
+  ec = llvm::sys::fs::remove(Twine(tmpFl));
+  EXPECT_FALSE(ec);
+}